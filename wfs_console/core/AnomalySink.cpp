@@ -0,0 +1,311 @@
+#include "AnomalySink.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include "IndexCache.h"
+#include "WFSTime.h"
+
+namespace {
+	// Описание вида нарушения для отчёта
+	struct AnomalyKindInfo {
+		const char* szId;			// Идентификатор в JSON
+		const char* szText;			// Описание в консоли
+		const char* szValue;		// Название значения или nullptr, если значения нет
+		uint8_t ui8RawOffset;		// Смещение значения в дескрипторе (0 - значение берётся из ui32Value)
+		uint8_t ui8RawSize;			// Размер значения в дескрипторе
+		bool bIsTime;				// Значение - упакованная временная метка
+	};
+
+	const AnomalyKindInfo kArrKindInfo[AnomalySink::kUi32KindCount] = {
+		{ "main_desc_rejected", "Дескриптор с типом MainDesc не прошёл проверку количества нулевых байт", nullptr, 0, 0, false },
+		{ "main_desc_index_mismatch", "Номер MainDesc в дескрипторе не совпадает с номером слота", "номер в дескрипторе", 24, 4, false },
+		{ "main_desc_bad_start_time", "Некорректное время начала видеопотока MainDesc", "время", 12, 4, true },
+		{ "main_desc_bad_end_time", "Некорректное время конца видеопотока MainDesc", "время", 16, 4, true },
+		{ "main_desc_bad_prev", "Ненулевая ссылка MainDesc на предыдущий дескриптор", "ссылка", 4, 4, false },
+		{ "sec_desc_rejected", "Дескриптор с типом SecDesc не прошёл проверку количества нулевых байт", nullptr, 0, 0, false },
+		{ "sec_desc_bad_start_time", "Некорректное время начала видеофрагмента SecDesc", "время", 12, 4, true },
+		{ "sec_desc_bad_end_time", "Некорректное время конца видеофрагмента SecDesc", "время", 16, 4, true },
+		{ "reserved_desc_damaged", "Дескриптор с типом зарезервированного содержит данные", nullptr, 0, 0, false },
+		{ "another_desc", "Дескриптор неизвестного типа", "тип", 1, 1, false },
+		{ "chain_first_sec_not_found", "MainDesc ссылается на слот без SecDesc", nullptr, 0, 0, false },
+		{ "chain_first_sec_mismatch", "Номер первого SecDesc не совпадает со ссылкой MainDesc", "номер в дескрипторе", 0, 0, false },
+		{ "chain_first_sec_no_back_link", "Первый SecDesc не ссылается на MainDesc", "ссылка на предыдущий", 0, 0, false },
+		{ "chain_bad_first_index", "Ссылка MainDesc на первый SecDesc вне IndexArea", nullptr, 0, 0, false },
+		{ "chain_sec_not_found", "Следующий SecDesc цепочки не найден", nullptr, 0, 0, false },
+		{ "chain_order_mismatch", "Порядковый номер SecDesc не совпадает с позицией в цепочке", "порядковый номер", 0, 0, false },
+		{ "chain_camera_mismatch", "Номер камеры SecDesc отличается от номера камеры MainDesc", "камера", 0, 0, false },
+		{ "recovered_camera_mismatch", "SecDesc вне цепочек с одним MainDesc имеют разные номера камер", nullptr, 0, 0, false }
+	};
+
+	// Значение, нарушившее проверку: из исходных данных дескриптора или из ui32Value
+	uint32_t valueOf(const AnomalyEvent& inStEvent, const AnomalyKindInfo& inStInfo) {
+		if (inStInfo.ui8RawOffset == 0) {
+			return inStEvent.ui32Value;
+		}
+		uint32_t ui32Value = 0;
+		std::memcpy(&ui32Value, inStEvent.arrUi8Raw + inStInfo.ui8RawOffset, inStInfo.ui8RawSize);
+		return ui32Value;
+	}
+
+	bool hasValue(const AnomalyEvent& inStEvent, const AnomalyKindInfo& inStInfo) {
+		return inStInfo.szValue != nullptr && (inStInfo.ui8RawOffset == 0 || inStEvent.ui8HasRaw != 0);
+	}
+
+	std::string formatTime(uint32_t inUi32Time) {
+		WFSDateTime stDateTime = WFSTime::toDateTime(inUi32Time);
+		char szDateTime[32];
+		snprintf(szDateTime, sizeof(szDateTime), "%02u.%02u.%04u %02u:%02u:%02u", stDateTime.ui8Day, stDateTime.ui8Month, stDateTime.ui16Year, stDateTime.ui8Hour, stDateTime.ui8Minute, stDateTime.ui8Second);
+		return szDateTime;
+	}
+}
+
+AnomalySink::AnomalySink(uint32_t inUi32SampleLimit) {
+	reset(inUi32SampleLimit);
+};
+
+void AnomalySink::reset(uint32_t inUi32SampleLimit) {
+	ui32SampleLimit = std::min(inUi32SampleLimit, kUi32MaxSampleLimit);
+	arrUi64Counters.fill(0);
+	arrUi32SampleCount.fill(0);
+	arrUi64MaxOrder.fill(0);
+	vecSamples.assign(static_cast<size_t>(kUi32KindCount) * ui32SampleLimit, AnomalyEvent{});
+};
+
+void AnomalySink::record(AnomalyKind inEKind, uint32_t inUi32Slot, const uint8_t* inPUi8Raw, uint32_t inUi32Chain, uint16_t inUi16Item, uint32_t inUi32Value) {
+	uint32_t ui32Kind = static_cast<uint32_t>(inEKind);
+	arrUi64Counters[ui32Kind]++;
+
+	AnomalyEvent stEvent;
+	stEvent.ui32Slot = inUi32Slot;
+	stEvent.ui32Chain = inUi32Chain;
+	stEvent.ui32Value = inUi32Value;
+	stEvent.ui16Item = inUi16Item;
+	stEvent.eKind = inEKind;
+	if (inPUi8Raw != nullptr) {
+		stEvent.ui8HasRaw = 1;
+		std::memcpy(stEvent.arrUi8Raw, inPUi8Raw, sizeof(stEvent.arrUi8Raw));
+	}
+	offer(stEvent);
+};
+
+void AnomalySink::merge(const AnomalySink& inSink) {
+	for (uint32_t ui32Kind = 0; ui32Kind < kUi32KindCount; ui32Kind++) {
+		arrUi64Counters[ui32Kind] += inSink.arrUi64Counters[ui32Kind];
+		for (uint32_t ui32Sample = 0; ui32Sample < inSink.arrUi32SampleCount[ui32Kind]; ui32Sample++) {
+			offer(inSink.vecSamples[static_cast<size_t>(ui32Kind) * inSink.ui32SampleLimit + ui32Sample]);
+		}
+	}
+};
+
+uint64_t AnomalySink::getTotal() const {
+	uint64_t ui64Total = 0;
+	for (uint64_t ui64Count : arrUi64Counters) {
+		ui64Total += ui64Count;
+	}
+	return ui64Total;
+};
+
+std::vector<AnomalyEvent> AnomalySink::getSamples(AnomalyKind inEKind) const {
+	uint32_t ui32Kind = static_cast<uint32_t>(inEKind);
+	auto iterBegin = vecSamples.begin() + static_cast<size_t>(ui32Kind) * ui32SampleLimit;
+	std::vector<AnomalyEvent> vecKindSamples(iterBegin, iterBegin + arrUi32SampleCount[ui32Kind]);
+	std::sort(vecKindSamples.begin(), vecKindSamples.end(), [](const AnomalyEvent& inStLeft, const AnomalyEvent& inStRight) {
+		return orderOf(inStLeft) < orderOf(inStRight);
+	});
+	return vecKindSamples;
+};
+
+/**
+* \brief
+* Выводит количество нарушений каждого вида и сохранённые события: слот, цепочку, значение,
+* нарушившее проверку, и исходные данные дескриптора.
+**/
+void AnomalySink::print(std::ostream& outStream, uint64_t inUi64IndexAreaOffset) const {
+	outStream << "---------------------------------------------------------------------" << std::endl;
+	outStream << "Нарушения в IndexArea и цепочках" << std::endl;
+	outStream << "---------------------------------------------------------------------" << std::endl;
+	outStream << "Всего нарушений: " << getTotal() << std::endl;
+
+	for (uint32_t ui32Kind = 0; ui32Kind < kUi32KindCount; ui32Kind++) {
+		if (arrUi64Counters[ui32Kind] == 0) {
+			continue;
+		}
+		const AnomalyKindInfo& stInfo = kArrKindInfo[ui32Kind];
+		std::vector<AnomalyEvent> vecKindSamples = getSamples(static_cast<AnomalyKind>(ui32Kind));
+		outStream << stInfo.szText << ": " << arrUi64Counters[ui32Kind] << std::endl;
+
+		for (const AnomalyEvent& stEvent : vecKindSamples) {
+			outStream << "\tСлот " << stEvent.ui32Slot;
+			if (stEvent.ui32Chain != AnomalyEvent::kUi32NoChain) {
+				outStream << ", цепочка " << stEvent.ui32Chain;
+			}
+			if (stEvent.ui16Item != 0) {
+				outStream << ", позиция " << stEvent.ui16Item;
+			}
+			if (hasValue(stEvent, stInfo)) {
+				uint32_t ui32Value = valueOf(stEvent, stInfo);
+				outStream << ", " << stInfo.szValue << " ";
+				if (stInfo.bIsTime) {
+					outStream << formatTime(ui32Value);
+				}
+				else {
+					outStream << ui32Value;
+				}
+			}
+			outStream << std::endl;
+
+			if (stEvent.ui8HasRaw != 0) {
+				uint64_t ui64Offset = inUi64IndexAreaOffset + static_cast<uint64_t>(stEvent.ui32Slot) * sizeof(stEvent.arrUi8Raw);
+				char szByte[4];
+				for (uint32_t ui32Row = 0; ui32Row < sizeof(stEvent.arrUi8Raw) / 16; ui32Row++) {
+					outStream << "\t\t0x" << std::hex << ui64Offset + ui32Row * 16 << std::dec << ":";
+					for (uint32_t ui32Column = 0; ui32Column < 16; ui32Column++) {
+						snprintf(szByte, sizeof(szByte), " %02x", stEvent.arrUi8Raw[ui32Row * 16 + ui32Column]);
+						outStream << szByte;
+					}
+					outStream << std::endl;
+				}
+			}
+		}
+		if (arrUi64Counters[ui32Kind] > vecKindSamples.size()) {
+			outStream << "\t... не показано: " << arrUi64Counters[ui32Kind] - vecKindSamples.size() << std::endl;
+		}
+	}
+};
+
+/**
+* \brief
+* Отчёт о нарушениях в формате JSON: счётчики всех видов и сохранённые события.
+**/
+std::string AnomalySink::toJson(uint64_t inUi64IndexAreaOffset) const {
+	std::ostringstream streamJson;
+	streamJson << "{\n";
+	streamJson << "  \"total\": " << getTotal() << ",\n";
+	streamJson << "  \"sample_limit\": " << ui32SampleLimit << ",\n";
+	streamJson << "  \"kinds\": [";
+	bool bIsFirstKind = true;
+	for (uint32_t ui32Kind = 0; ui32Kind < kUi32KindCount; ui32Kind++) {
+		if (arrUi64Counters[ui32Kind] == 0) {
+			continue;
+		}
+		const AnomalyKindInfo& stInfo = kArrKindInfo[ui32Kind];
+		streamJson << (bIsFirstKind ? "\n" : ",\n");
+		bIsFirstKind = false;
+		streamJson << "    {\n";
+		streamJson << "      \"kind\": \"" << stInfo.szId << "\",\n";
+		streamJson << "      \"count\": " << arrUi64Counters[ui32Kind] << ",\n";
+		streamJson << "      \"samples\": [";
+
+		std::vector<AnomalyEvent> vecKindSamples = getSamples(static_cast<AnomalyKind>(ui32Kind));
+		for (size_t szSample = 0; szSample < vecKindSamples.size(); szSample++) {
+			const AnomalyEvent& stEvent = vecKindSamples[szSample];
+			streamJson << (szSample == 0 ? "\n" : ",\n") << "        { \"slot\": " << stEvent.ui32Slot;
+			if (stEvent.ui32Chain != AnomalyEvent::kUi32NoChain) {
+				streamJson << ", \"chain\": " << stEvent.ui32Chain;
+			}
+			if (stEvent.ui16Item != 0) {
+				streamJson << ", \"item\": " << stEvent.ui16Item;
+			}
+			if (hasValue(stEvent, stInfo)) {
+				uint32_t ui32Value = valueOf(stEvent, stInfo);
+				streamJson << ", \"value\": " << ui32Value;
+				if (stInfo.bIsTime) {
+					streamJson << ", \"time\": \"" << formatTime(ui32Value) << "\"";
+				}
+			}
+			if (stEvent.ui8HasRaw != 0) {
+				streamJson << ", \"offset\": " << inUi64IndexAreaOffset + static_cast<uint64_t>(stEvent.ui32Slot) * sizeof(stEvent.arrUi8Raw) << ", \"raw\": \"";
+				char szByte[3];
+				for (uint8_t ui8Byte : stEvent.arrUi8Raw) {
+					snprintf(szByte, sizeof(szByte), "%02x", ui8Byte);
+					streamJson << szByte;
+				}
+				streamJson << "\"";
+			}
+			streamJson << " }";
+		}
+		streamJson << (vecKindSamples.empty() ? "]\n" : "\n      ]\n");
+		streamJson << "    }";
+	}
+	streamJson << (bIsFirstKind ? "]\n" : "\n  ]\n");
+	streamJson << "}\n";
+	return streamJson.str();
+};
+
+void AnomalySink::save(IndexCacheWriter& inWriter, uint32_t inUi32SectionCounters) const {
+	inWriter.addSection(inUi32SectionCounters, arrUi64Counters.data(), sizeof(arrUi64Counters));
+	inWriter.addArray(inUi32SectionCounters + 1, vecSamples);
+};
+
+/**
+* \brief
+* Загружает счётчики и события из файла индекса. Количество событий каждого вида определяется
+* по заполненным записям, поэтому ограничение может отличаться от ограничения при сохранении.
+*
+* \return
+* true, если разделы найдены и их размеры корректны.
+**/
+bool AnomalySink::load(const IndexCacheReader& inReader, uint32_t inUi32SectionCounters) {
+	std::vector<AnomalyEvent> vecLoaded;
+	ByteView stCounters = inReader.section(inUi32SectionCounters);
+	if (stCounters.ui64Size != sizeof(arrUi64Counters) || !inReader.readArray(inUi32SectionCounters + 1, vecLoaded)) {
+		return false;
+	}
+
+	reset(ui32SampleLimit);
+	std::memcpy(arrUi64Counters.data(), stCounters.pData, sizeof(arrUi64Counters));
+	for (const AnomalyEvent& stEvent : vecLoaded) {
+		if (stEvent.eKind < AnomalyKind::Count) {
+			offer(stEvent);
+		}
+	}
+	return true;
+};
+
+uint64_t AnomalySink::orderOf(const AnomalyEvent& inStEvent) {
+	if (inStEvent.ui32Chain == AnomalyEvent::kUi32NoChain) {
+		return inStEvent.ui32Slot;
+	}
+	return (static_cast<uint64_t>(inStEvent.ui32Chain) << 16) | inStEvent.ui16Item;
+};
+
+/**
+* \brief
+* Помещает событие в блок его вида. В заполненном блоке событие заменяет событие с наибольшим
+* порядком, если его порядок меньше.
+**/
+void AnomalySink::offer(const AnomalyEvent& inStEvent) {
+	uint32_t ui32Kind = static_cast<uint32_t>(inStEvent.eKind);
+	if (ui32SampleLimit == 0) {
+		return;
+	}
+	AnomalyEvent* pStBlock = vecSamples.data() + static_cast<size_t>(ui32Kind) * ui32SampleLimit;
+	uint64_t ui64Order = orderOf(inStEvent);
+
+	// При разборе по возрастанию слотов заполненный блок обычно отклоняет событие без поиска
+	if (arrUi32SampleCount[ui32Kind] < ui32SampleLimit) {
+		pStBlock[arrUi32SampleCount[ui32Kind]++] = inStEvent;
+	}
+	else if (ui64Order < arrUi64MaxOrder[ui32Kind]) {
+		for (uint32_t ui32Sample = 0; ui32Sample < ui32SampleLimit; ui32Sample++) {
+			if (orderOf(pStBlock[ui32Sample]) == arrUi64MaxOrder[ui32Kind]) {
+				pStBlock[ui32Sample] = inStEvent;
+				break;
+			}
+		}
+	}
+	else {
+		return;
+	}
+
+	if (arrUi32SampleCount[ui32Kind] == ui32SampleLimit) {
+		uint64_t ui64MaxOrder = 0;
+		for (uint32_t ui32Sample = 0; ui32Sample < ui32SampleLimit; ui32Sample++) {
+			ui64MaxOrder = std::max(ui64MaxOrder, orderOf(pStBlock[ui32Sample]));
+		}
+		arrUi64MaxOrder[ui32Kind] = ui64MaxOrder;
+	}
+};
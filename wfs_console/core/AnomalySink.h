@@ -0,0 +1,110 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class IndexCacheWriter;
+class IndexCacheReader;
+
+/*
+* Вид нарушения, обнаруженного при разборе IndexArea или построении цепочек
+*/
+enum class AnomalyKind : uint8_t {
+	// Разбор IndexArea
+	MainDescRejected,			// Дескриптор с типом MainDesc не прошёл проверку количества нулевых байт
+	MainDescIndexMismatch,		// Номер MainDesc в дескрипторе не совпадает с номером слота
+	MainDescBadStartTime,		// Некорректное время начала видеопотока MainDesc
+	MainDescBadEndTime,			// Некорректное время конца видеопотока MainDesc
+	MainDescBadPrev,			// Ненулевая ссылка MainDesc на предыдущий дескриптор
+	SecDescRejected,			// Дескриптор с типом SecDesc не прошёл проверку количества нулевых байт
+	SecDescBadStartTime,		// Некорректное время начала видеофрагмента SecDesc
+	SecDescBadEndTime,			// Некорректное время конца видеофрагмента SecDesc
+	ReservedDescDamaged,		// Дескриптор с типом зарезервированного содержит данные
+	AnotherDesc,				// Дескриптор неизвестного типа
+	// Построение цепочек
+	ChainFirstSecNotFound,		// MainDesc ссылается на слот без SecDesc
+	ChainFirstSecMismatch,		// Номер первого SecDesc не совпадает со ссылкой MainDesc
+	ChainFirstSecNoBackLink,	// Первый SecDesc не ссылается на MainDesc
+	ChainBadFirstIndex,			// Ссылка MainDesc на первый SecDesc вне IndexArea
+	ChainSecNotFound,			// Следующий SecDesc цепочки не найден
+	ChainOrderMismatch,			// Порядковый номер SecDesc не совпадает с позицией в цепочке
+	ChainCameraMismatch,		// Номер камеры SecDesc отличается от номера камеры MainDesc
+	RecoveredCameraMismatch,	// SecDesc вне цепочек с одним MainDesc имеют разные номера камер
+	Count
+};
+
+/*
+* Событие нарушения. Для нарушений разбора IndexArea сохраняются исходные 32 байта
+* дескриптора, для нарушений цепочек - номер MainDesc цепочки и позиция в ней.
+*/
+struct AnomalyEvent {
+	static constexpr uint32_t kUi32NoChain = 0xFFFFFFFF;
+
+	uint32_t	ui32Slot = 0;					// Слот дескриптора
+	uint32_t	ui32Chain = kUi32NoChain;		// MainDesc цепочки
+	uint32_t	ui32Value = 0;					// Значение, нарушившее проверку (для нарушений цепочек)
+	uint16_t	ui16Item = 0;					// Позиция в цепочке (с 1)
+	AnomalyKind	eKind = AnomalyKind::Count;
+	uint8_t		ui8HasRaw = 0;					// 1, если arrUi8Raw заполнен
+	uint8_t		arrUi8Raw[32] = {};				// Исходные данные дескриптора
+};
+
+/*
+* Сборщик нарушений разбора IndexArea и построения цепочек (AnomalySink). Вместо вывода
+* в консоль из цикла разбора нарушения записываются как типизированные события, а отчёт
+* выводится в консоль (print) или в JSON (toJson) после разбора.
+*
+* Для каждого вида нарушения ведётся счётчик, а события хранятся в заранее выделенном
+* блоке из ui32SampleLimit записей: сохраняются события с наименьшими номерами слотов
+* (для нарушений цепочек - номерами MainDesc и позициями в цепочке), остальные только
+* подсчитываются. Поэтому объём памяти не зависит от количества нарушений, а сборщики
+* частей IndexArea и потоков построения цепочек объединяются (merge) в любом порядке
+* с одинаковым результатом.
+*/
+class AnomalySink {
+public:
+	static constexpr uint32_t kUi32KindCount = static_cast<uint32_t>(AnomalyKind::Count);
+	static constexpr uint32_t kUi32DefaultSampleLimit = 16;
+	// Наибольшее количество примеров каждого вида: блок примеров выделяется в каждом сборщике (по одному на поток)
+	static constexpr uint32_t kUi32MaxSampleLimit = 4096;
+
+	explicit AnomalySink(uint32_t inUi32SampleLimit = kUi32DefaultSampleLimit);
+
+	// Регистрирует нарушение. inPUi8Raw - 32 байта дескриптора или nullptr
+	void record(AnomalyKind inEKind, uint32_t inUi32Slot, const uint8_t* inPUi8Raw = nullptr,
+		uint32_t inUi32Chain = AnomalyEvent::kUi32NoChain, uint16_t inUi16Item = 0, uint32_t inUi32Value = 0);
+
+	// Добавляет счётчики и события другого сборщика
+	void merge(const AnomalySink& inSink);
+
+	// Удаляет события и обнуляет счётчики; inUi32SampleLimit - новое количество событий каждого вида
+	void reset(uint32_t inUi32SampleLimit);
+	void clear() { reset(ui32SampleLimit); }
+
+	uint32_t getSampleLimit() const { return ui32SampleLimit; }
+	uint64_t getCount(AnomalyKind inEKind) const { return arrUi64Counters[static_cast<uint32_t>(inEKind)]; }
+	uint64_t getTotal() const;
+
+	// Сохранённые события вида inEKind в порядке слотов
+	std::vector<AnomalyEvent> getSamples(AnomalyKind inEKind) const;
+
+	// Отчёт о нарушениях; inUi64IndexAreaOffset используется для вывода смещений дескрипторов
+	void print(std::ostream& outStream, uint64_t inUi64IndexAreaOffset) const;
+	std::string toJson(uint64_t inUi64IndexAreaOffset) const;
+
+	// Сохранение в файл индекса и загрузка из него (разделы inUi32SectionCounters и inUi32SectionCounters + 1)
+	void save(IndexCacheWriter& inWriter, uint32_t inUi32SectionCounters) const;
+	bool load(const IndexCacheReader& inReader, uint32_t inUi32SectionCounters);
+
+private:
+	uint32_t ui32SampleLimit;
+	std::array<uint64_t, kUi32KindCount> arrUi64Counters{};
+	std::array<uint32_t, kUi32KindCount> arrUi32SampleCount{};	// Заполненных записей в блоке вида
+	std::array<uint64_t, kUi32KindCount> arrUi64MaxOrder{};		// Наибольший порядок среди записей заполненного блока
+	std::vector<AnomalyEvent> vecSamples;						// kUi32KindCount блоков по ui32SampleLimit событий
+
+	static uint64_t orderOf(const AnomalyEvent& inStEvent);
+	void offer(const AnomalyEvent& inStEvent);
+};
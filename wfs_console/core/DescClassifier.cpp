@@ -0,0 +1,223 @@
+#include "DescClassifier.h"
+#include "WFSTime.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(WFS_DESC_CLASSIFIER_X86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+#if defined(WFS_DESC_CLASSIFIER_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define WFS_TARGET_AVX2
+#else
+#define WFS_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+namespace {
+	constexpr uint32_t kUi32OffsetType = 0x01;					// Смещение типа дескриптора
+	constexpr uint32_t kUi32OffsetIndexPrevSecDesc = 0x04;		// Смещение ui32IndexPrevSecDesc
+	constexpr uint32_t kUi32OffsetTimeStampStart = 0x0C;		// Смещение метки времени начала
+	constexpr uint32_t kUi32OffsetTimeStampEnd = 0x10;			// Смещение метки времени конца
+	constexpr uint32_t kUi32OffsetIndexCurrentMainDesc = 0x18;	// Смещение ui32IndexCurrentMainDesc
+	constexpr uint32_t kUi32PrevZeroMask = 0xFu << kUi32OffsetIndexPrevSecDesc;	// Биты маски нулевых байт поля ui32IndexPrevSecDesc
+	constexpr uint32_t kUi32TimeBatch = 64;						// Дескрипторов в пакете проверки меток времени
+
+	uint32_t countBits(uint32_t ui32Value) {
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<uint32_t>(__builtin_popcount(ui32Value));
+#else
+		ui32Value = ui32Value - ((ui32Value >> 1) & 0x55555555u);
+		ui32Value = (ui32Value & 0x33333333u) + ((ui32Value >> 2) & 0x33333333u);
+		ui32Value = (ui32Value + (ui32Value >> 4)) & 0x0F0F0F0Fu;
+		return (ui32Value * 0x01010101u) >> 24;
+#endif
+	}
+
+	uint32_t loadUi32(const uint8_t* pUi8Data) {
+		uint32_t ui32Value;
+		memcpy(&ui32Value, pUi8Data, sizeof(ui32Value));
+		return ui32Value;
+	}
+
+	/*
+	* Признаки по маске нулевых байт (бит i установлен, если байт i равен нулю)
+	*/
+	void fillTraits(const uint8_t* pUi8Desc, uint32_t ui32ZeroMask, uint32_t ui32ZeroCount, bool bIndexMatch, DescTraits& outStTraits) {
+		outStTraits.ui8Type = pUi8Desc[kUi32OffsetType];
+		outStTraits.ui8ZeroCount = static_cast<uint8_t>(ui32ZeroCount);
+		outStTraits.ui8Flags = 0;
+		if ((ui32ZeroMask & kUi32PrevZeroMask) == kUi32PrevZeroMask) {
+			outStTraits.ui8Flags |= DescClassifier::kUi8DescPrevZero;
+		}
+		if (bIndexMatch) {
+			outStTraits.ui8Flags |= DescClassifier::kUi8DescIndexMatch;
+		}
+	}
+}
+
+void DescClassifier::classify(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits) {
+	select().fnClassify(inPUi8Data, inUi32FirstDesc, inUi32CountDesc, outPStTraits);
+
+	// Метки времени начала и конца собираются подряд и проверяются пакетно
+	uint32_t arrTime[kUi32TimeBatch * 2];
+	uint8_t arrValid[kUi32TimeBatch * 2];
+	for (uint32_t ui32Base = 0; ui32Base < inUi32CountDesc; ui32Base += kUi32TimeBatch) {
+		uint32_t ui32Count = std::min(kUi32TimeBatch, inUi32CountDesc - ui32Base);
+		for (uint32_t ui32Desc = 0; ui32Desc < ui32Count; ui32Desc++) {
+			const uint8_t* pUi8Desc = inPUi8Data + static_cast<uint64_t>(ui32Base + ui32Desc) * kUi32DescSize;
+			arrTime[ui32Desc * 2] = loadUi32(pUi8Desc + kUi32OffsetTimeStampStart);
+			arrTime[ui32Desc * 2 + 1] = loadUi32(pUi8Desc + kUi32OffsetTimeStampEnd);
+		}
+		WFSTime::validateBatch(arrTime, ui32Count * 2, arrValid);
+		for (uint32_t ui32Desc = 0; ui32Desc < ui32Count; ui32Desc++) {
+			DescTraits& stTraits = outPStTraits[ui32Base + ui32Desc];
+			if (arrValid[ui32Desc * 2]) {
+				stTraits.ui8Flags |= kUi8DescStartTimeValid;
+			}
+			if (arrValid[ui32Desc * 2 + 1]) {
+				stTraits.ui8Flags |= kUi8DescEndTimeValid;
+			}
+		}
+	}
+};
+
+const char* DescClassifier::getName() {
+	return select().szName;
+};
+
+/**
+* \brief
+* Выбирает реализацию один раз за время работы программы
+**/
+const DescClassifier::Implementation& DescClassifier::select() {
+	static const Implementation stImplementation = []() -> Implementation {
+#if defined(WFS_DESC_CLASSIFIER_X86)
+		if (isAvx2Supported()) {
+			return { &DescClassifier::classifyAvx2, "avx2" };
+		}
+		return { &DescClassifier::classifySse2, "sse2" };
+#elif defined(WFS_DESC_CLASSIFIER_NEON)
+		return { &DescClassifier::classifyNeon, "neon" };
+#else
+		return { &DescClassifier::classifyScalar, "scalar" };
+#endif
+	}();
+	return stImplementation;
+};
+
+void DescClassifier::classifyScalar(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits) {
+	for (uint32_t ui32Desc = 0; ui32Desc < inUi32CountDesc; ui32Desc++) {
+		const uint8_t* pUi8Desc = inPUi8Data + static_cast<uint64_t>(ui32Desc) * kUi32DescSize;
+		uint32_t ui32ZeroMask = 0;
+		for (uint32_t ui32Byte = 0; ui32Byte < kUi32DescSize; ui32Byte++) {
+			if (pUi8Desc[ui32Byte] == 0) {
+				ui32ZeroMask |= 1u << ui32Byte;
+			}
+		}
+		bool bIndexMatch = loadUi32(pUi8Desc + kUi32OffsetIndexCurrentMainDesc) == inUi32FirstDesc + ui32Desc;
+		fillTraits(pUi8Desc, ui32ZeroMask, countBits(ui32ZeroMask), bIndexMatch, outPStTraits[ui32Desc]);
+	}
+};
+
+#if defined(WFS_DESC_CLASSIFIER_X86)
+/**
+* \brief
+* Дескриптор загружается двумя регистрами по 16 байт. Поле ui32IndexCurrentMainDesc
+* является третьим 32-битным словом второй половины.
+**/
+void DescClassifier::classifySse2(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits) {
+	const __m128i xmmZero = _mm_setzero_si128();
+	for (uint32_t ui32Desc = 0; ui32Desc < inUi32CountDesc; ui32Desc++) {
+		const uint8_t* pUi8Desc = inPUi8Data + static_cast<uint64_t>(ui32Desc) * kUi32DescSize;
+		__m128i xmmLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pUi8Desc));
+		__m128i xmmHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pUi8Desc + 16));
+
+		uint32_t ui32ZeroMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(xmmLow, xmmZero)))
+			| (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(xmmHigh, xmmZero))) << 16);
+
+		__m128i xmmIndex = _mm_set1_epi32(static_cast<int>(inUi32FirstDesc + ui32Desc));
+		uint32_t ui32IndexMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(xmmHigh, xmmIndex))));
+		bool bIndexMatch = (ui32IndexMask & (1u << ((kUi32OffsetIndexCurrentMainDesc - 16) / 4))) != 0;
+
+		fillTraits(pUi8Desc, ui32ZeroMask, countBits(ui32ZeroMask), bIndexMatch, outPStTraits[ui32Desc]);
+	}
+};
+
+/**
+* \brief
+* Дескриптор целиком помещается в один регистр AVX2
+**/
+WFS_TARGET_AVX2 void DescClassifier::classifyAvx2(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits) {
+	const __m256i ymmZero = _mm256_setzero_si256();
+	for (uint32_t ui32Desc = 0; ui32Desc < inUi32CountDesc; ui32Desc++) {
+		const uint8_t* pUi8Desc = inPUi8Data + static_cast<uint64_t>(ui32Desc) * kUi32DescSize;
+		__m256i ymmDesc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pUi8Desc));
+
+		uint32_t ui32ZeroMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(ymmDesc, ymmZero)));
+
+		__m256i ymmIndex = _mm256_set1_epi32(static_cast<int>(inUi32FirstDesc + ui32Desc));
+		uint32_t ui32IndexMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(ymmDesc, ymmIndex))));
+		bool bIndexMatch = (ui32IndexMask & (1u << (kUi32OffsetIndexCurrentMainDesc / 4))) != 0;
+
+		fillTraits(pUi8Desc, ui32ZeroMask, static_cast<uint32_t>(_mm_popcnt_u32(ui32ZeroMask)), bIndexMatch, outPStTraits[ui32Desc]);
+	}
+};
+
+/**
+* \brief
+* Проверяет поддержку AVX2 и POPCNT процессором и сохранение регистров YMM операционной системой
+**/
+bool DescClassifier::isAvx2Supported() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int arrInfo[4];
+	__cpuid(arrInfo, 0);
+	if (arrInfo[0] < 7) {
+		return false;
+	}
+	__cpuid(arrInfo, 1);
+	bool bPopcnt = (arrInfo[2] & (1 << 23)) != 0;
+	bool bOsXsave = (arrInfo[2] & (1 << 27)) != 0;
+	bool bAvx = (arrInfo[2] & (1 << 28)) != 0;
+	if (!bPopcnt || !bOsXsave || !bAvx || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(arrInfo, 7, 0);
+	return (arrInfo[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+};
+#endif
+
+#if defined(WFS_DESC_CLASSIFIER_NEON)
+/**
+* \brief
+* Дескриптор загружается двумя регистрами по 16 байт. NEON не имеет аналога movemask,
+* поэтому нулевые байты подсчитываются сложением по регистру, а поля проверяются
+* скалярно.
+**/
+void DescClassifier::classifyNeon(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits) {
+	for (uint32_t ui32Desc = 0; ui32Desc < inUi32CountDesc; ui32Desc++) {
+		const uint8_t* pUi8Desc = inPUi8Data + static_cast<uint64_t>(ui32Desc) * kUi32DescSize;
+		uint8x16_t vLow = vld1q_u8(pUi8Desc);
+		uint8x16_t vHigh = vld1q_u8(pUi8Desc + 16);
+
+		// Нулевые байты дают 0xFF, сдвиг оставляет по единице на каждый нулевой байт
+		uint8x16_t vZeroCount = vaddq_u8(vshrq_n_u8(vceqq_u8(vLow, vdupq_n_u8(0)), 7), vshrq_n_u8(vceqq_u8(vHigh, vdupq_n_u8(0)), 7));
+		uint32_t ui32ZeroCount = vaddvq_u8(vZeroCount);
+
+		uint32_t ui32ZeroMask = (loadUi32(pUi8Desc + kUi32OffsetIndexPrevSecDesc) == 0) ? kUi32PrevZeroMask : 0;
+		bool bIndexMatch = loadUi32(pUi8Desc + kUi32OffsetIndexCurrentMainDesc) == inUi32FirstDesc + ui32Desc;
+
+		fillTraits(pUi8Desc, ui32ZeroMask, ui32ZeroCount, bIndexMatch, outPStTraits[ui32Desc]);
+	}
+};
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define WFS_DESC_CLASSIFIER_X86
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define WFS_DESC_CLASSIFIER_NEON
+#endif
+
+/*
+* Признаки дескриптора IndexArea, на основе которых isLikelyMainDesc / isLikelySecDesc
+* и проверка зарезервированных дескрипторов выносят решение
+*/
+struct DescTraits {
+	uint8_t		ui8Type;			// Тип дескриптора (байт по смещению 0x01)
+	uint8_t		ui8ZeroCount;		// Количество нулевых байт в дескрипторе
+	uint8_t		ui8Flags;			// Сочетание флагов DescClassifier::kUi8Desc*
+};
+
+/*
+* Векторный классификатор дескрипторов IndexArea. Дескриптор (32 байта) занимает один
+* регистр AVX2 или два регистра SSE2/NEON: нулевые байты подсчитываются сравнением
+* с нулём, извлечением маски и подсчётом единичных бит, а проверки полей
+* ui32IndexPrevSecDesc == 0 и ui32IndexCurrentMainDesc == индекс слота выполняются
+* по той же маске и сравнением 32-битных слов.
+*
+* Реализация выбирается при первом вызове по возможностям процессора. Все реализации
+* дают одинаковый результат со скалярной. Допустимость временных меток начала и конца
+* проверяется в classify() для всего блока пакетно (WFSTime::validateBatch).
+*/
+class DescClassifier {
+public:
+	static constexpr uint32_t kUi32DescSize = 32;
+	static constexpr uint8_t kUi8DescPrevZero = 0x01;		// ui32IndexPrevSecDesc (0x04) равно нулю
+	static constexpr uint8_t kUi8DescIndexMatch = 0x02;		// ui32IndexCurrentMainDesc (0x18) равно индексу дескриптора
+	static constexpr uint8_t kUi8DescStartTimeValid = 0x04;	// Допустимая метка времени начала (0x0C)
+	static constexpr uint8_t kUi8DescEndTimeValid = 0x08;	// Допустимая метка времени конца (0x10)
+
+	using ClassifyFunc = void (*)(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits);
+
+	// Вычисляет признаки inUi32CountDesc подряд идущих дескрипторов, первый из которых имеет индекс inUi32FirstDesc
+	static void classify(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits);
+
+	// Имя выбранной реализации: "avx2", "sse2", "neon" или "scalar"
+	static const char* getName();
+
+	static void classifyScalar(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits);
+#if defined(WFS_DESC_CLASSIFIER_X86)
+	static void classifySse2(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits);
+	static void classifyAvx2(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits);
+	static bool isAvx2Supported();
+#endif
+#if defined(WFS_DESC_CLASSIFIER_NEON)
+	static void classifyNeon(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, DescTraits* outPStTraits);
+#endif
+
+private:
+	struct Implementation {
+		ClassifyFunc	fnClassify;
+		const char*		szName;
+	};
+
+	static const Implementation& select();
+};
@@ -0,0 +1,259 @@
+#include "DescTable.h"
+
+#include <cstring>
+#include <stdexcept>
+
+/**
+* \brief
+* Очищает таблицу и выделяет битовые карты и номера записей для inUi32SlotCount слотов.
+*
+* \param
+* uint32_t inUi32SlotCount - количество дескрипторов IndexArea.
+**/
+void DescTable::reset(uint32_t inUi32SlotCount) {
+	uint32_t ui32Words = (inUi32SlotCount + 63) / 64;
+
+	ui32SlotCount = inUi32SlotCount;
+	vecValidBitmap.assign(ui32Words, 0);
+	vecMainBitmap.assign(ui32Words, 0);
+	vecReservedBitmap.assign(ui32Words, 0);
+	vecAnotherBitmap.assign(ui32Words, 0);
+	vecSlotRecord.assign(inUi32SlotCount, kUi32NoRecord);
+	vecMainRecords.clear();
+	vecSecRecords.clear();
+	vecRecoveredMainRecords.clear();
+};
+
+/**
+* \brief
+* Добавляет запись MainDesc слота inUi32Slot.
+*
+* \return
+* Указатель на добавленную запись.
+**/
+WFSMainDescAdvInfo* DescTable::addMain(uint32_t inUi32Slot, const WFSMainDescAdvInfo& inStMainDesc) {
+	markSlot(inUi32Slot, true, static_cast<uint32_t>(vecMainRecords.size()));
+	vecMainRecords.push_back(inStMainDesc);
+	return &vecMainRecords.back();
+};
+
+/**
+* \brief
+* Добавляет запись SecDesc слота inUi32Slot.
+*
+* \return
+* Указатель на добавленную запись.
+**/
+WFSSecDescAdvInfo* DescTable::addSec(uint32_t inUi32Slot, const WFSSecDescAdvInfo& inStSecDesc) {
+	markSlot(inUi32Slot, false, static_cast<uint32_t>(vecSecRecords.size()));
+	vecSecRecords.push_back(inStSecDesc);
+	return &vecSecRecords.back();
+};
+
+void DescTable::markReserved(uint32_t inUi32Slot) {
+	setKind(inUi32Slot, SlotKind::Reserved, kUi32NoRecord);
+};
+
+void DescTable::markAnother(uint32_t inUi32Slot) {
+	setKind(inUi32Slot, SlotKind::Another, kUi32NoRecord);
+};
+
+DescTable::SlotKind DescTable::getKind(uint32_t inUi32Slot) const {
+	if (inUi32Slot >= ui32SlotCount) {
+		return SlotKind::None;
+	}
+	if (testBit(vecValidBitmap, inUi32Slot)) {
+		return testBit(vecMainBitmap, inUi32Slot) ? SlotKind::Main : SlotKind::Sec;
+	}
+	if (testBit(vecReservedBitmap, inUi32Slot)) {
+		return SlotKind::Reserved;
+	}
+	return testBit(vecAnotherBitmap, inUi32Slot) ? SlotKind::Another : SlotKind::None;
+};
+
+/**
+* \brief
+* Заменяет содержимое слотов, например перезаписанных оборудованием. Если тип записи в слотах
+* не меняется, записи заменяются на месте. Иначе плотные массивы записей перестраиваются
+* в порядке слотов, поэтому таблица совпадает с таблицей, заполненной полным разбором.
+*
+* \param
+* const std::vector<SlotPatch>& inVecPatches - новое содержимое слотов в порядке возрастания слотов.
+**/
+void DescTable::patch(const std::vector<SlotPatch>& inVecPatches) {
+	bool bIsLayoutKept = true;
+	for (const SlotPatch& stPatch : inVecPatches) {
+		if (stPatch.ui32Slot >= ui32SlotCount) {
+			throw std::runtime_error("DescTable::patch() - Slot out of range");
+		}
+		SlotKind eOldKind = getKind(stPatch.ui32Slot);
+		bool bHadRecord = eOldKind == SlotKind::Main || eOldKind == SlotKind::Sec;
+		bool bHasRecord = stPatch.eKind == SlotKind::Main || stPatch.eKind == SlotKind::Sec;
+		if ((bHadRecord || bHasRecord) && eOldKind != stPatch.eKind) {
+			bIsLayoutKept = false;
+		}
+	}
+
+	if (bIsLayoutKept) {
+		for (const SlotPatch& stPatch : inVecPatches) {
+			if (stPatch.eKind == SlotKind::Main) {
+				vecMainRecords[vecSlotRecord[stPatch.ui32Slot]] = stPatch.stMainDesc;
+			}
+			else if (stPatch.eKind == SlotKind::Sec) {
+				vecSecRecords[vecSlotRecord[stPatch.ui32Slot]] = stPatch.stSecDesc;
+			}
+			else {
+				setKind(stPatch.ui32Slot, stPatch.eKind, kUi32NoRecord);
+			}
+		}
+		return;
+	}
+
+	std::vector<WFSMainDescAdvInfo> vecNewMainRecords;
+	std::vector<WFSSecDescAdvInfo> vecNewSecRecords;
+	vecNewMainRecords.reserve(vecMainRecords.size() + inVecPatches.size());
+	vecNewSecRecords.reserve(vecSecRecords.size() + inVecPatches.size());
+	auto iterPatch = inVecPatches.begin();
+	for (uint32_t ui32Slot = 0; ui32Slot < ui32SlotCount; ui32Slot++) {
+		if (iterPatch != inVecPatches.end() && iterPatch->ui32Slot == ui32Slot) {
+			if (iterPatch->eKind == SlotKind::Main) {
+				setKind(ui32Slot, SlotKind::Main, static_cast<uint32_t>(vecNewMainRecords.size()));
+				vecNewMainRecords.push_back(iterPatch->stMainDesc);
+			}
+			else if (iterPatch->eKind == SlotKind::Sec) {
+				setKind(ui32Slot, SlotKind::Sec, static_cast<uint32_t>(vecNewSecRecords.size()));
+				vecNewSecRecords.push_back(iterPatch->stSecDesc);
+			}
+			else {
+				setKind(ui32Slot, iterPatch->eKind, kUi32NoRecord);
+			}
+			++iterPatch;
+		}
+		else if (testBit(vecValidBitmap, ui32Slot)) {
+			if (testBit(vecMainBitmap, ui32Slot)) {
+				vecNewMainRecords.push_back(vecMainRecords[vecSlotRecord[ui32Slot]]);
+				vecSlotRecord[ui32Slot] = static_cast<uint32_t>(vecNewMainRecords.size() - 1);
+			}
+			else {
+				vecNewSecRecords.push_back(vecSecRecords[vecSlotRecord[ui32Slot]]);
+				vecSlotRecord[ui32Slot] = static_cast<uint32_t>(vecNewSecRecords.size() - 1);
+			}
+		}
+	}
+	vecMainRecords.swap(vecNewMainRecords);
+	vecSecRecords.swap(vecNewSecRecords);
+};
+
+/**
+* \brief
+* Очищает восстановленные MainDesc и резервирует место под inUi32Count записей. Добавление
+* не более inUi32Count записей addRecoveredMain не перемещает уже добавленные записи.
+**/
+void DescTable::reserveRecoveredMain(uint32_t inUi32Count) {
+	vecRecoveredMainRecords.clear();
+	vecRecoveredMainRecords.reserve(inUi32Count);
+};
+
+/**
+* \brief
+* Добавляет MainDesc, восстановленный по SecDesc. Номер такого MainDesc может указывать
+* за пределы IndexArea или на слот с SecDesc, поэтому запись не связывается со слотом.
+*
+* \return
+* Указатель на добавленную запись.
+**/
+WFSMainDescAdvInfo* DescTable::addRecoveredMain(const WFSMainDescAdvInfo& inStMainDesc) {
+	if (vecRecoveredMainRecords.size() == vecRecoveredMainRecords.capacity()) {
+		throw std::runtime_error("DescTable::addRecoveredMain() - Recovered MainDesc capacity exceeded");
+	}
+	vecRecoveredMainRecords.push_back(inStMainDesc);
+	return &vecRecoveredMainRecords.back();
+};
+
+/**
+* \brief
+* Добавляет массивы таблицы разделами файла индекса: записи копируются из файла одной
+* операцией, без повторного разбора IndexArea.
+**/
+void DescTable::save(IndexCacheWriter& inWriter) const {
+	inWriter.addSection(kUi32SectionSlotCount, &ui32SlotCount, sizeof(ui32SlotCount));
+	inWriter.addArray(kUi32SectionValidBitmap, vecValidBitmap);
+	inWriter.addArray(kUi32SectionMainBitmap, vecMainBitmap);
+	inWriter.addArray(kUi32SectionSlotRecord, vecSlotRecord);
+	inWriter.addArray(kUi32SectionMainRecords, vecMainRecords);
+	inWriter.addArray(kUi32SectionSecRecords, vecSecRecords);
+	inWriter.addArray(kUi32SectionRecoveredMainRecords, vecRecoveredMainRecords);
+	inWriter.addArray(kUi32SectionReservedBitmap, vecReservedBitmap);
+	inWriter.addArray(kUi32SectionAnotherBitmap, vecAnotherBitmap);
+};
+
+/**
+* \brief
+* Заполняет таблицу из файла индекса. Размеры массивов и номера записей занятых слотов
+* проверяются, поэтому повреждённый файл не приводит к обращению за пределы массивов.
+*
+* \return
+* true, если таблица загружена.
+**/
+bool DescTable::load(const IndexCacheReader& inReader) {
+	reset(0);
+
+	ByteView stSlotCount = inReader.section(kUi32SectionSlotCount);
+	if (stSlotCount.ui64Size != sizeof(ui32SlotCount)) {
+		return false;
+	}
+	uint32_t ui32LoadedSlotCount;
+	std::memcpy(&ui32LoadedSlotCount, stSlotCount.pData, sizeof(ui32LoadedSlotCount));
+
+	uint32_t ui32Words = (ui32LoadedSlotCount + 63) / 64;
+	bool bIsLoaded = inReader.readArray(kUi32SectionValidBitmap, vecValidBitmap) && vecValidBitmap.size() == ui32Words &&
+		inReader.readArray(kUi32SectionMainBitmap, vecMainBitmap) && vecMainBitmap.size() == ui32Words &&
+		inReader.readArray(kUi32SectionReservedBitmap, vecReservedBitmap) && vecReservedBitmap.size() == ui32Words &&
+		inReader.readArray(kUi32SectionAnotherBitmap, vecAnotherBitmap) && vecAnotherBitmap.size() == ui32Words &&
+		inReader.readArray(kUi32SectionSlotRecord, vecSlotRecord) && vecSlotRecord.size() == ui32LoadedSlotCount &&
+		inReader.readArray(kUi32SectionMainRecords, vecMainRecords) &&
+		inReader.readArray(kUi32SectionSecRecords, vecSecRecords) &&
+		inReader.readArray(kUi32SectionRecoveredMainRecords, vecRecoveredMainRecords);
+	ui32SlotCount = ui32LoadedSlotCount;
+
+	for (uint32_t ui32Slot = 0; bIsLoaded && ui32Slot < ui32SlotCount; ui32Slot++) {
+		if (isValid(ui32Slot)) {
+			size_t szRecords = testBit(vecMainBitmap, ui32Slot) ? vecMainRecords.size() : vecSecRecords.size();
+			bIsLoaded = vecSlotRecord[ui32Slot] < szRecords;
+		}
+	}
+	if (!bIsLoaded) {
+		reset(0);
+	}
+	return bIsLoaded;
+};
+
+/**
+* \brief
+* Записывает тип слота в битовые карты и номер записи слота.
+**/
+void DescTable::setKind(uint32_t inUi32Slot, SlotKind inEKind, uint32_t inUi32Record) {
+	if (inUi32Slot >= ui32SlotCount) {
+		throw std::runtime_error("DescTable::setKind() - Slot out of range");
+	}
+	setBit(vecValidBitmap, inUi32Slot, inEKind == SlotKind::Main || inEKind == SlotKind::Sec);
+	setBit(vecMainBitmap, inUi32Slot, inEKind == SlotKind::Main);
+	setBit(vecReservedBitmap, inUi32Slot, inEKind == SlotKind::Reserved);
+	setBit(vecAnotherBitmap, inUi32Slot, inEKind == SlotKind::Another);
+	vecSlotRecord[inUi32Slot] = inUi32Record;
+};
+
+void DescTable::markSlot(uint32_t inUi32Slot, bool inBIsMain, uint32_t inUi32Record) {
+	if (inUi32Slot >= ui32SlotCount) {
+		throw std::runtime_error("DescTable::markSlot() - Slot out of range");
+	}
+	if (isValid(inUi32Slot)) {
+		throw std::runtime_error("DescTable::markSlot() - Slot already occupied");
+	}
+	uint64_t ui64Bit = 1ull << (inUi32Slot & 63);
+	vecValidBitmap[inUi32Slot >> 6] |= ui64Bit;
+	if (inBIsMain) {
+		vecMainBitmap[inUi32Slot >> 6] |= ui64Bit;
+	}
+	vecSlotRecord[inUi32Slot] = inUi32Record;
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "struct_wfs.h"
+#include "IndexCache.h"
+
+/*
+* Таблица дескрипторов IndexArea с прямой адресацией по номеру слота. Таблица состоит из
+* параллельных массивов: битовые карты "слот занят" и "слот содержит MainDesc", номер записи
+* для каждого слота и плотные массивы записей MainDesc и SecDesc в порядке возрастания слотов.
+* Поиск по слоту выполняется за O(1) без выделения памяти на каждый дескриптор.
+*
+* Записи добавляются в конец массивов, поэтому указатели на записи остаются действительными,
+* только пока массивы не растут: указатели на MainDesc выдаются после окончания разбора.
+* MainDesc, восстановленные по SecDesc, хранятся в отдельном массиве, место под который
+* резервируется заранее (reserveRecoveredMain).
+*
+* Для слотов без записей отмечается, содержит ли слот зарезервированный или другой дескриптор,
+* чтобы при обновлении отдельных слотов (patch) можно было скорректировать счётчики дескрипторов.
+*/
+class DescTable {
+public:
+	static constexpr uint32_t kUi32NoRecord = 0xFFFFFFFF;
+
+	// Содержимое слота IndexArea
+	enum class SlotKind : uint8_t {
+		None,		// Дескриптор не прошёл проверку
+		Main,		// MainDesc
+		Sec,		// SecDesc
+		Reserved,	// Зарезервированный дескриптор
+		Another		// Другие данные
+	};
+
+	// Новое содержимое слота для patch. Используется запись, соответствующая eKind
+	struct SlotPatch {
+		uint32_t ui32Slot = 0;
+		SlotKind eKind = SlotKind::None;
+		WFSMainDescAdvInfo stMainDesc{};
+		WFSSecDescAdvInfo stSecDesc{};
+	};
+
+	// Очищает таблицу и задаёт количество слотов (дескрипторов IndexArea)
+	void reset(uint32_t inUi32SlotCount);
+
+	// Добавляет записи дескрипторов. Слоты добавляются в порядке возрастания, каждый не более одного раза
+	WFSMainDescAdvInfo* addMain(uint32_t inUi32Slot, const WFSMainDescAdvInfo& inStMainDesc);
+	WFSSecDescAdvInfo* addSec(uint32_t inUi32Slot, const WFSSecDescAdvInfo& inStSecDesc);
+
+	// Отмечают слот без записи как содержащий зарезервированный или другой дескриптор
+	void markReserved(uint32_t inUi32Slot);
+	void markAnother(uint32_t inUi32Slot);
+
+	// Заменяет содержимое слотов. inVecPatches упорядочен по возрастанию слотов, каждый слот не более одного раза.
+	// Указатели на записи после вызова недействительны
+	void patch(const std::vector<SlotPatch>& inVecPatches);
+
+	// Очищает восстановленные MainDesc и резервирует место под inUi32Count записей
+	void reserveRecoveredMain(uint32_t inUi32Count);
+
+	// Добавляет MainDesc, восстановленный по SecDesc. Такая запись не занимает слот таблицы
+	WFSMainDescAdvInfo* addRecoveredMain(const WFSMainDescAdvInfo& inStMainDesc);
+
+	uint32_t getSlotCount() const { return ui32SlotCount; }
+	std::vector<WFSMainDescAdvInfo>& getMainRecords() { return vecMainRecords; }
+	std::vector<WFSSecDescAdvInfo>& getSecRecords() { return vecSecRecords; }
+	std::vector<WFSMainDescAdvInfo>& getRecoveredMainRecords() { return vecRecoveredMainRecords; }
+
+	// Добавляет массивы таблицы разделами файла индекса. Таблица не должна меняться до записи файла
+	void save(IndexCacheWriter& inWriter) const;
+
+	// Заполняет таблицу из файла индекса. false (таблица очищена), если разделы отсутствуют или несогласованы
+	bool load(const IndexCacheReader& inReader);
+
+	bool isValid(uint32_t inUi32Slot) const {
+		return inUi32Slot < ui32SlotCount && testBit(vecValidBitmap, inUi32Slot);
+	}
+
+	bool isMain(uint32_t inUi32Slot) const {
+		return isValid(inUi32Slot) && testBit(vecMainBitmap, inUi32Slot);
+	}
+
+	SlotKind getKind(uint32_t inUi32Slot) const;
+
+	// Запись MainDesc в слоте inUi32Slot или nullptr
+	WFSMainDescAdvInfo* findMain(uint32_t inUi32Slot) {
+		return isMain(inUi32Slot) ? &vecMainRecords[vecSlotRecord[inUi32Slot]] : nullptr;
+	}
+
+	// Запись SecDesc в слоте inUi32Slot или nullptr
+	WFSSecDescAdvInfo* findSec(uint32_t inUi32Slot) {
+		return (isValid(inUi32Slot) && !testBit(vecMainBitmap, inUi32Slot)) ? &vecSecRecords[vecSlotRecord[inUi32Slot]] : nullptr;
+	}
+
+private:
+	// Номера разделов файла индекса
+	static constexpr uint32_t kUi32SectionSlotCount = 1;
+	static constexpr uint32_t kUi32SectionValidBitmap = 2;
+	static constexpr uint32_t kUi32SectionMainBitmap = 3;
+	static constexpr uint32_t kUi32SectionSlotRecord = 4;
+	static constexpr uint32_t kUi32SectionMainRecords = 5;
+	static constexpr uint32_t kUi32SectionSecRecords = 6;
+	static constexpr uint32_t kUi32SectionRecoveredMainRecords = 7;
+	static constexpr uint32_t kUi32SectionReservedBitmap = 8;
+	static constexpr uint32_t kUi32SectionAnotherBitmap = 9;
+
+	uint32_t ui32SlotCount = 0;
+	std::vector<uint64_t> vecValidBitmap;				// Бит слота установлен, если в слоте найден MainDesc или SecDesc
+	std::vector<uint64_t> vecMainBitmap;				// Бит слота установлен, если в слоте найден MainDesc
+	std::vector<uint64_t> vecReservedBitmap;			// Бит слота установлен, если в слоте найден зарезервированный дескриптор
+	std::vector<uint64_t> vecAnotherBitmap;				// Бит слота установлен, если в слоте другие данные
+	std::vector<uint32_t> vecSlotRecord;				// Номер записи слота в vecMainRecords или vecSecRecords
+	std::vector<WFSMainDescAdvInfo> vecMainRecords;		// Записи MainDesc
+	std::vector<WFSSecDescAdvInfo> vecSecRecords;		// Записи SecDesc
+	std::vector<WFSMainDescAdvInfo> vecRecoveredMainRecords;	// MainDesc, восстановленные по SecDesc
+
+	static bool testBit(const std::vector<uint64_t>& inVecBitmap, uint32_t inUi32Slot) {
+		return (inVecBitmap[inUi32Slot >> 6] >> (inUi32Slot & 63)) & 1;
+	}
+
+	static void setBit(std::vector<uint64_t>& inVecBitmap, uint32_t inUi32Slot, bool inBValue) {
+		uint64_t ui64Bit = 1ull << (inUi32Slot & 63);
+		inVecBitmap[inUi32Slot >> 6] = inBValue ? (inVecBitmap[inUi32Slot >> 6] | ui64Bit) : (inVecBitmap[inUi32Slot >> 6] & ~ui64Bit);
+	}
+
+	void markSlot(uint32_t inUi32Slot, bool inBIsMain, uint32_t inUi32Record);
+	void setKind(uint32_t inUi32Slot, SlotKind inEKind, uint32_t inUi32Record);
+};
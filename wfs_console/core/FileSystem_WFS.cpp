@@ -8,22 +8,448 @@
 * \param
 * std::unique_ptr<IFile> inFile - умный указатель на интерфейс IFile,
 * используемый для абстрактной работы с файлами (открытие, чтение, запись, закрытие и др.).
+*
+* uint32_t inUi32AnalysisThreads - количество потоков разбора IndexArea
+* (0 - по количеству ядер процессора).
 **/
-FileSystem_WFS::FileSystem_WFS(std::unique_ptr<IFile> inFile) : inputFile_(std::move(inFile)) {
+FileSystem_WFS::FileSystem_WFS(std::unique_ptr<IFile> inFile, uint32_t inUi32AnalysisThreads) : inputFile_(std::move(inFile)) {
+	ui32AnalysisThreads = inUi32AnalysisThreads != 0 ? inUi32AnalysisThreads : std::max(1u, std::thread::hardware_concurrency());
 	auto start = std::chrono::high_resolution_clock::now();
 	if (!isWFS()) {
 		throw std::runtime_error("FileSystem_WFS::FileSystem_WFS() - Invalid WFS header");
 	}
 
 	initSuperBlock();
+
+	durationOpen = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Время открытия: " << durationOpen.count() << " секунд" << std::endl;
+}
+
+/**
+* \brief
+* Разбирает IndexArea, строит цепочки видеофрагментов и выводит информацию о файловой системе.
+* Каждый этап замеряется отдельно. Цепочки, построенные выборочно (findChain), отбрасываются:
+* после разбора используются mapValidChains и mapIncompleteChains. Повторный вызов ничего не делает.
+*
+* Если задан файл индекса (setIndexCachePath) и его ключ совпадает с образом, результаты
+* загружаются из файла без разбора IndexArea; иначе после разбора файл индекса записывается.
+* Нарушения разбора и построения цепочек собираются в sinkAnomalies и выводятся после
+* разбора; сводка нарушений сохраняется в файле индекса и выводится и при загрузке.
+**/
+void FileSystem_WFS::analyze() {
+	if (bIsAnalyzed) {
+		return;
+	}
+	mapResolvedChains.clear();
+	mapResolvedMainDesc.clear();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	if (!strIndexCachePath.empty() && loadIndexCache()) {
+		bIsIndexAreaScanned = true;
+		bIsAnalyzed = true;
+		auto loaded = std::chrono::high_resolution_clock::now();
+		sinkAnomalies.print(std::cout, stWFSAllValue.ui64IndexAreaOffset);
+		printWFSInf();
+
+		std::chrono::duration<double> elapsedLoad = loaded - start;
+		std::chrono::duration<double> elapsed = durationOpen + elapsedLoad;
+		std::cout << "Индекс загружен из файла " << strIndexCachePath << std::endl;
+		std::cout << "Время загрузки индекса: " << elapsedLoad.count() << " секунд" << std::endl;
+		std::cout << "Время выполнения: " << elapsed.count() << " секунд" << std::endl;
+		return;
+	}
+
+	sinkAnomalies.clear();
 	analysisIndexArea();
+	bIsIndexAreaScanned = true;
+	auto scanned = std::chrono::high_resolution_clock::now();
 	rebuildUnwrittenVideoChain();
-	rebuildOverwrittenVideoChain();
+	rebuildOverwrittenVideoChain(sinkAnomalies);
+	rebuildLinkedRuns();
+	bIsAnalyzed = true;
+	auto rebuilt = std::chrono::high_resolution_clock::now();
+	sinkAnomalies.print(std::cout, stWFSAllValue.ui64IndexAreaOffset);
 	printWFSInf();
 
-	auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> elapsed = end - start;
+	std::chrono::duration<double> elapsedScan = scanned - start;
+	std::chrono::duration<double> elapsedRebuild = rebuilt - scanned;
+	std::chrono::duration<double> elapsed = durationOpen + (rebuilt - start);
+	std::cout << "Время разбора IndexArea: " << elapsedScan.count() << " секунд" << std::endl;
+	std::cout << "Время построения цепочек: " << elapsedRebuild.count() << " секунд" << std::endl;
 	std::cout << "Время выполнения: " << elapsed.count() << " секунд" << std::endl;
+
+	if (!strIndexCachePath.empty()) {
+		saveIndexCache();
+	}
+}
+
+bool FileSystem_WFS::isAnalyzed() const {
+	return bIsAnalyzed;
+}
+
+void FileSystem_WFS::setIndexCachePath(const std::string& inStringPath) {
+	strIndexCachePath = inStringPath;
+}
+
+void FileSystem_WFS::setAnomalySampleLimit(uint32_t inUi32SampleLimit) {
+	sinkAnomalies.reset(inUi32SampleLimit);
+}
+
+const AnomalySink& FileSystem_WFS::getAnomalies() const {
+	return sinkAnomalies;
+}
+
+std::string FileSystem_WFS::getAnomaliesJson() const {
+	return sinkAnomalies.toJson(stWFSAllValue.ui64IndexAreaOffset);
+}
+
+std::map<uint32_t, FragmentChain>& FileSystem_WFS::getValidChains() {
+	analyze();
+	return mapValidChains;
+}
+
+std::map<uint32_t, FragmentChain>& FileSystem_WFS::getIncompleteChains() {
+	analyze();
+	return mapIncompleteChains;
+}
+
+std::vector<FragmentChain>& FileSystem_WFS::getLinkedRuns() {
+	analyze();
+	return vecLinkedRuns;
+}
+
+/**
+* \brief
+* Возвращает цепочку видеофрагментов по номеру MainDesc.
+*
+* До разбора IndexArea читается только MainDesc из слота inUi32IndexMainDesc и SecDesc, на
+* которые ссылается цепочка, поэтому выгрузка одной цепочки не требует разбора всей IndexArea.
+* Такая цепочка содержит только непрерывную часть, указанную в MainDesc: SecDesc, найденные
+* при полном разборе среди перезаписанных дескрипторов (rebuildOverwrittenVideoChain),
+* в неё не входят. Если в слоте нет MainDesc, выполняется analyze() и цепочка ищется
+* среди всех цепочек, в том числе без MainDesc.
+*
+* \param
+* uint32_t inUi32IndexMainDesc - номер MainDesc (ключ mapValidChains или mapIncompleteChains).
+*
+* \return
+* Указатель на цепочку или nullptr, если цепочка не найдена.
+**/
+FragmentChain* FileSystem_WFS::findChain(uint32_t inUi32IndexMainDesc) {
+	if (!bIsAnalyzed) {
+		auto iterResolved = mapResolvedChains.find(inUi32IndexMainDesc);
+		if (iterResolved != mapResolvedChains.end()) {
+			return &iterResolved->second;
+		}
+
+		if (inUi32IndexMainDesc < stWFSAllValue.ui32CountAllVideoFragments) {
+			uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaMainDesc);
+			std::unique_ptr<uint8_t[]> pUi8Holder;
+			const uint8_t* pUi8Desc = readDataView(getDescOffset(stWFSAllValue.ui64IndexAreaOffset, inUi32IndexMainDesc), ui32SizeDescriptor, pUi8Holder).pData;
+
+			DescTraits stTraits;
+			AnomalyKind eKind;
+			DescClassifier::classify(pUi8Desc, inUi32IndexMainDesc, 1, &stTraits);
+			if ((stTraits.ui8Type == 0x02 || stTraits.ui8Type == 0x03) and isLikelyMainDesc(stTraits, eKind)) {
+				auto iterMainDesc = mapResolvedMainDesc.emplace(inUi32IndexMainDesc, makeMainDescInfo(pUi8Desc)).first;
+				FragmentChain& videoChain = mapResolvedChains[inUi32IndexMainDesc];
+				videoChain.pMainDes = &iterMainDesc->second;
+				AnomalySink sinkChain(sinkAnomalies.getSampleLimit());
+				if (rebuildValidChain(inUi32IndexMainDesc, videoChain, sinkChain)) {
+					markChainAdded(videoChain);
+				}
+				if (sinkChain.getTotal() != 0) {
+					sinkChain.print(std::cout, stWFSAllValue.ui64IndexAreaOffset);
+				}
+				return &videoChain;
+			}
+		}
+		analyze();
+	}
+
+	auto iterChain = mapValidChains.find(inUi32IndexMainDesc);
+	if (iterChain != mapValidChains.end()) {
+		return &iterChain->second;
+	}
+	iterChain = mapIncompleteChains.find(inUi32IndexMainDesc);
+	if (iterChain != mapIncompleteChains.end()) {
+		return &iterChain->second;
+	}
+	return nullptr;
+}
+
+/**
+* \brief
+* Обновляет результаты разбора образа, в который продолжается запись (диск работающего
+* регистратора). Оборудование записывает дескрипторы по кольцу слотов IndexArea после
+* зарезервированных и сохраняет в SuperBlock позицию последнего записанного дескриптора в DBS
+* от начала образа (ui32IndexAreaVideoFragmentPosLastWrite). Поэтому при изменении SuperBlock
+* перечитываются только дисковые блоки от прежней до новой позиции записи и MainDesc, на которые
+* ссылаются прочитанные SecDesc (у записываемой цепочки меняются количество SecDesc и время конца).
+* Позиция ui32IndexAreaVideoFragmentPosReWrite не используется: слоты, которые будут перезаписаны,
+* сохраняют содержимое до записи и при записи попадают в участок записи, а полный разбор
+* классифицирует дескрипторы по содержимому без учёта этой позиции.
+*
+* Изменившиеся слоты заменяются в таблице дескрипторов, счётчики дескрипторов корректируются,
+* затронутые цепочки с MainDesc перестраиваются (refreshValidChains), а цепочки из SecDesc вне
+* цепочек и последовательности по ссылкам строятся заново в памяти, без чтения IndexArea.
+* Результат совпадает с полным разбором изменённого образа. Если изменились размеры областей,
+* позиция записи находится вне кольца или в её дисковом блоке нет MainDesc и SecDesc (позиция
+* записана не в DBS), участок записи больше 1/kUi32RefreshMaxShare IndexArea
+* или регистратор с прошлого опроса прошёл всё кольцо (изменился слот за новой позицией записи,
+* который при записи меньше кольца не перезаписывается), выполняется полный разбор.
+*
+* Сводка нарушений sinkAnomalies (getAnomalies) не обновляется и относится к последнему полному
+* разбору: сборщик хранит только счётчики и примеры, поэтому нарушения перезаписанных слотов
+* нельзя исключить. Нарушения перечитанных слотов и перестроенных цепочек только выводятся.
+*
+* \return
+* true, если SuperBlock изменился и результаты разбора обновлены.
+**/
+bool FileSystem_WFS::refresh() {
+	if (!bIsAnalyzed) {
+		analyze();
+		return true;
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Кэшированные копии SuperBlock и IndexArea могли устареть, поэтому перед чтением они отбрасываются
+	uint64_t ui64OffsetSuperBlock = 0x3000;
+	inputFile_->advise(ui64OffsetSuperBlock, sizeof(WFSSuperBlock), FileAccessHint::DontNeed);
+	WFSSuperBlock stReadSuperBlock = readStruct<WFSSuperBlock>(ui64OffsetSuperBlock, sizeof(WFSSuperBlock));
+	if (!checkWFSSuperBlock(stReadSuperBlock)) {
+		throw std::runtime_error("FileSystem_WFS::refresh() - Invalid WFS SuperBlock");
+	}
+	if (std::memcmp(&stReadSuperBlock, &stWFSSuperBlock, sizeof(WFSSuperBlock)) == 0) {
+		return false;
+	}
+
+	WFSSuperBlock stOldSuperBlock = stWFSSuperBlock;
+	bool bIsSameLayout = stReadSuperBlock.ui32CountAllVideoFragments == stOldSuperBlock.ui32CountAllVideoFragments and
+		stReadSuperBlock.ui32ReservedVideoFragmentCount == stOldSuperBlock.ui32ReservedVideoFragmentCount and
+		stReadSuperBlock.ui32DiskBlockSize == stOldSuperBlock.ui32DiskBlockSize and
+		stReadSuperBlock.ui32VideoFragmentSizeDBS == stOldSuperBlock.ui32VideoFragmentSizeDBS and
+		stReadSuperBlock.ui32IndexAreaPosStart == stOldSuperBlock.ui32IndexAreaPosStart and
+		stReadSuperBlock.ui32DataAreaPosStart == stOldSuperBlock.ui32DataAreaPosStart;
+	applySuperBlock(stReadSuperBlock);
+
+	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaSecDesc);
+	uint32_t ui32SlotCount = stWFSAllValue.ui32CountAllVideoFragments;
+	uint32_t ui32RingBegin = stWFSAllValue.ui32ReservedVideoFragmentCount;
+	uint32_t ui32SlotsPerBlock = std::max<uint32_t>(stWFSAllValue.ui32DiskBlockSize / ui32SizeDescriptor, 1);
+
+	// Позиция записи хранится в DBS от начала образа и указывает на дисковый блок с последним записанным дескриптором
+	auto fnPosToSlot = [&](uint32_t inUi32Pos, uint32_t& outUi32Slot) -> bool {
+		uint64_t ui64Offset = static_cast<uint64_t>(inUi32Pos) * stWFSAllValue.ui32DiskBlockSize;
+		if (ui64Offset < stWFSAllValue.ui64IndexAreaOffset or (ui64Offset - stWFSAllValue.ui64IndexAreaOffset) % ui32SizeDescriptor != 0) {
+			return false;
+		}
+		uint64_t ui64Slot = (ui64Offset - stWFSAllValue.ui64IndexAreaOffset) / ui32SizeDescriptor;
+		if (ui64Slot >= ui32SlotCount) {
+			return false;
+		}
+		outUi32Slot = static_cast<uint32_t>(ui64Slot);
+		return true;
+	};
+	uint32_t ui32OldPos = 0;
+	uint32_t ui32NewPos = 0;
+	bool bIsInRing = ui32RingBegin < ui32SlotCount and
+		fnPosToSlot(stOldSuperBlock.ui32IndexAreaVideoFragmentPosLastWrite, ui32OldPos) and
+		fnPosToSlot(stReadSuperBlock.ui32IndexAreaVideoFragmentPosLastWrite, ui32NewPos);
+
+	/*
+	* Участок записи - от начала блока прежней позиции записи (SecDesc последнего записанного
+	* дескриптора получает ссылку на следующий) до конца блока новой позиции записи
+	*/
+	uint32_t ui32NewBlockFirst = ui32NewPos;
+	uint32_t ui32CountRange = 0;
+	if (bIsInRing) {
+		ui32OldPos = std::max(ui32OldPos, ui32RingBegin);
+		ui32NewBlockFirst = std::max(ui32NewPos, ui32RingBegin);
+		ui32NewPos = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(ui32NewPos) + ui32SlotsPerBlock - 1, ui32SlotCount - 1));
+		uint64_t ui64RingSize = ui32SlotCount - ui32RingBegin;
+		ui32CountRange = static_cast<uint32_t>((static_cast<uint64_t>(ui32NewPos) + ui64RingSize - ui32OldPos) % ui64RingSize + 1);
+	}
+	auto fnFullAnalysis = [this]() {
+		std::cout << "Изменения IndexArea не ограничены участком записи, выполняется полный разбор" << std::endl;
+		resetAnalysis();
+		analyze();
+	};
+	if (!bIsSameLayout or !bIsInRing or ui32CountRange >= ui32SlotCount - ui32RingBegin or
+		ui32CountRange > std::max(kUi32MinDescPerThread, ui32SlotCount / kUi32RefreshMaxShare)) {
+		fnFullAnalysis();
+		return true;
+	}
+
+	uint64_t ui64BytesRead = sizeof(WFSSuperBlock);
+	IndexAreaScanPart stPart;
+	stPart.sinkAnomalies.reset(sinkAnomalies.getSampleLimit());
+	std::vector<uint32_t> vecReadSlots;
+	auto fnReadSlots = [&](uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc) {
+		uint64_t ui64Offset = getDescOffset(stWFSAllValue.ui64IndexAreaOffset, inUi32FirstDesc);
+		uint64_t ui64Size = static_cast<uint64_t>(inUi32CountDesc) * ui32SizeDescriptor;
+		inputFile_->advise(ui64Offset, ui64Size, FileAccessHint::DontNeed);
+		std::unique_ptr<uint8_t[]> pUi8Data = readRawData(ui64Offset, ui64Size);
+		classifyIndexAreaRange(pUi8Data.get(), inUi32FirstDesc, inUi32CountDesc, stPart);
+		for (uint32_t ui32Desc = 0; ui32Desc < inUi32CountDesc; ui32Desc++) {
+			vecReadSlots.push_back(inUi32FirstDesc + ui32Desc);
+		}
+		ui64BytesRead += ui64Size;
+	};
+	/*
+	* Позиция записи хранится по модулю кольца, и после прохода всего кольца участок записи
+	* выглядит коротким. Слот за новой позицией записи в этом случае перезаписан, иначе он
+	* совпадает с таблицей дескрипторов. Нарушения в этом слоте не относятся к участку записи
+	*/
+	uint32_t ui32NextSlot = ui32NewPos + 1 < ui32SlotCount ? ui32NewPos + 1 : ui32RingBegin;
+	fnReadSlots(ui32NextSlot, 1);
+	stPart.sinkAnomalies.clear();
+
+	uint32_t ui32CountTail = std::min(ui32CountRange, ui32SlotCount - ui32OldPos);
+	fnReadSlots(ui32OldPos, ui32CountTail);
+	if (ui32CountTail < ui32CountRange) {
+		fnReadSlots(ui32RingBegin, ui32CountRange - ui32CountTail);
+	}
+
+	// В блоке новой позиции записи находится записанный дескриптор; иначе позиция записана не в DBS
+	auto fnIsInNewBlock = [&](uint32_t inUi32Slot) {
+		return inUi32Slot >= ui32NewBlockFirst and inUi32Slot <= ui32NewPos;
+	};
+	bool bIsNewBlockWritten = std::any_of(stPart.vecMainDesc.begin(), stPart.vecMainDesc.end(),
+		[&](const std::pair<uint32_t, WFSMainDescAdvInfo>& inPairMainDesc) { return fnIsInNewBlock(inPairMainDesc.first); }) or
+		std::any_of(stPart.vecSecDesc.begin(), stPart.vecSecDesc.end(),
+		[&](const WFSSecDescAdvInfo& inStSecDesc) { return fnIsInNewBlock(inStSecDesc.ui32IndexCurrentSecDesc); });
+	if (!bIsNewBlockWritten) {
+		fnFullAnalysis();
+		return true;
+	}
+
+	// MainDesc записываемых цепочек находятся вне участка записи и читаются по одному
+	std::sort(vecReadSlots.begin(), vecReadSlots.end());
+	std::vector<uint32_t> vecOwnerSlots;
+	for (const WFSSecDescAdvInfo& stSecDesc : stPart.vecSecDesc) {
+		if (stSecDesc.ui32IndexMainDesc < ui32SlotCount and !std::binary_search(vecReadSlots.begin(), vecReadSlots.end(), stSecDesc.ui32IndexMainDesc)) {
+			vecOwnerSlots.push_back(stSecDesc.ui32IndexMainDesc);
+		}
+	}
+	std::sort(vecOwnerSlots.begin(), vecOwnerSlots.end());
+	vecOwnerSlots.erase(std::unique(vecOwnerSlots.begin(), vecOwnerSlots.end()), vecOwnerSlots.end());
+	for (uint32_t ui32Slot : vecOwnerSlots) {
+		fnReadSlots(ui32Slot, 1);
+	}
+	std::sort(vecReadSlots.begin(), vecReadSlots.end());
+
+	// Новое содержимое прочитанных слотов; слоты без записей и отметок не прошли проверку
+	std::map<uint32_t, DescTable::SlotPatch> mapPatches;
+	for (uint32_t ui32Slot : vecReadSlots) {
+		mapPatches[ui32Slot].ui32Slot = ui32Slot;
+	}
+	for (const std::pair<uint32_t, WFSMainDescAdvInfo>& pairMainDesc : stPart.vecMainDesc) {
+		mapPatches[pairMainDesc.first].eKind = DescTable::SlotKind::Main;
+		mapPatches[pairMainDesc.first].stMainDesc = pairMainDesc.second;
+	}
+	for (const WFSSecDescAdvInfo& stSecDesc : stPart.vecSecDesc) {
+		mapPatches[stSecDesc.ui32IndexCurrentSecDesc].eKind = DescTable::SlotKind::Sec;
+		mapPatches[stSecDesc.ui32IndexCurrentSecDesc].stSecDesc = stSecDesc;
+	}
+	for (uint32_t ui32Slot : stPart.vecReservedSlots) {
+		mapPatches[ui32Slot].eKind = DescTable::SlotKind::Reserved;
+	}
+	for (uint32_t ui32Slot : stPart.vecAnotherSlots) {
+		mapPatches[ui32Slot].eKind = DescTable::SlotKind::Another;
+	}
+
+	auto fnCounter = [this](DescTable::SlotKind inEKind) -> uint32_t* {
+		switch (inEKind) {
+			case DescTable::SlotKind::Main: return &stWFSAllValue.ui32CountMainDesc;
+			case DescTable::SlotKind::Sec: return &stWFSAllValue.ui32CountSecDesc;
+			case DescTable::SlotKind::Reserved: return &stWFSAllValue.ui32CountReservedDesc;
+			case DescTable::SlotKind::Another: return &stWFSAllValue.ui32CountAnotherDesc;
+			default: return nullptr;
+		}
+	};
+
+	// Слоты, содержимое которых не изменилось (признаки обработки не сравниваются), не заменяются
+	std::vector<DescTable::SlotPatch> vecPatches;
+	std::vector<uint32_t> vecChangedSlots;
+	for (const auto& pairPatch : mapPatches) {
+		const DescTable::SlotPatch& stPatch = pairPatch.second;
+		DescTable::SlotKind eOldKind = tableDesc.getKind(stPatch.ui32Slot);
+		if (eOldKind == stPatch.eKind) {
+			if (eOldKind == DescTable::SlotKind::Main) {
+				WFSMainDescAdvInfo stOldMainDesc = *tableDesc.findMain(stPatch.ui32Slot);
+				stOldMainDesc.bIsAdd = false;
+				if (std::memcmp(&stOldMainDesc, &stPatch.stMainDesc, sizeof(WFSMainDescAdvInfo)) == 0) {
+					continue;
+				}
+			}
+			else if (eOldKind == DescTable::SlotKind::Sec) {
+				WFSSecDescAdvInfo stOldSecDesc = *tableDesc.findSec(stPatch.ui32Slot);
+				stOldSecDesc.bIsAdd = false;
+				stOldSecDesc.bIsRecovered = false;
+				if (std::memcmp(&stOldSecDesc, &stPatch.stSecDesc, sizeof(WFSSecDescAdvInfo)) == 0) {
+					continue;
+				}
+			}
+			else {
+				continue;
+			}
+		}
+
+		if (uint32_t* pUi32Counter = fnCounter(eOldKind)) {
+			(*pUi32Counter)--;
+		}
+		if (uint32_t* pUi32Counter = fnCounter(stPatch.eKind)) {
+			(*pUi32Counter)++;
+		}
+		vecPatches.push_back(stPatch);
+		vecChangedSlots.push_back(stPatch.ui32Slot);
+	}
+	stWFSAllValue.ui32CountAllDesc = stWFSAllValue.ui32CountMainDesc + stWFSAllValue.ui32CountSecDesc + stWFSAllValue.ui32CountReservedDesc;
+	if (std::binary_search(vecChangedSlots.begin(), vecChangedSlots.end(), ui32NextSlot)) {
+		fnFullAnalysis();
+		return true;
+	}
+
+	uint32_t ui32CountRebuilt = 0;
+	if (!vecPatches.empty()) {
+		tableDesc.patch(vecPatches);
+		ui32CountRebuilt = refreshValidChains(vecChangedSlots, stPart.sinkAnomalies);
+		mapIncompleteChains.clear();
+		rebuildOverwrittenVideoChain(stPart.sinkAnomalies);
+		rebuildLinkedRuns();
+	}
+
+	// Выводятся нарушения только в перечитанных слотах и перестроенных цепочках; sinkAnomalies не изменяется
+	if (stPart.sinkAnomalies.getTotal() != 0) {
+		stPart.sinkAnomalies.print(std::cout, stWFSAllValue.ui64IndexAreaOffset);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Обновление IndexArea: прочитано дескрипторов " << vecReadSlots.size() << " (" << ui64BytesRead << " байт вместе с SuperBlock), изменено "
+		<< vecChangedSlots.size() << ", перестроено цепочек с MainDesc " << ui32CountRebuilt << std::endl;
+	std::cout << "Время обновления: " << elapsed.count() << " секунд" << std::endl;
+	return true;
+}
+
+/**
+* \brief
+* Отбрасывает результаты разбора IndexArea перед повторным полным разбором.
+**/
+void FileSystem_WFS::resetAnalysis() {
+	bIsAnalyzed = false;
+	bIsIndexAreaScanned = false;
+	tableDesc.reset(0);
+	sinkAnomalies.clear();
+	mapValidChains.clear();
+	mapIncompleteChains.clear();
+	vecLinkedRuns.clear();
+	vecLinkedRunMainDesc.clear();
+	stWFSAllValue.ui32CountMainDesc = 0;
+	stWFSAllValue.ui32CountSecDesc = 0;
+	stWFSAllValue.ui32CountReservedDesc = 0;
+	stWFSAllValue.ui32CountAnotherDesc = 0;
+	stWFSAllValue.ui32CountAllDesc = 0;
 }
 
 /**
@@ -88,22 +514,24 @@ template <typename T> T FileSystem_WFS::readStruct(uint64_t inUi64Offset, uint32
 		throw std::runtime_error("FileSystem_WFS::readStruct() - Struct size exceeds buffer");
 	}
 
-	if (!inputFile_->setPosition(inUi64Offset, FILE_ORIGIN_BEGIN)) {
-		throw std::runtime_error("FileSystem_WFS::readStruct() - Failed to set file position");
+	T result;
+
+	// Если источник поддерживает прямой доступ к данным, структура копируется непосредственно из отображённых страниц
+	ByteView stView = inputFile_->view(inUi64Offset, sizeof(T));
+	if (!stView.empty()) {
+		std::memcpy(&result, stView.pData, sizeof(T));
+		return result;
 	}
 
-	std::unique_ptr<uint8_t[]> uiBuffer(new uint8_t[inUi32Size]);
-	uint32_t ui32BytesRead = 0;
-	if (!inputFile_->read(uiBuffer.get(), inUi32Size, ui32BytesRead)) {
+	uint64_t ui64BytesRead = 0;
+	if (!inputFile_->readAt(inUi64Offset, reinterpret_cast<uint8_t*>(&result), sizeof(T), ui64BytesRead)) {
 		throw std::runtime_error("FileSystem_WFS::readStruct() - Failed to read data");
 	}
 
-	if (ui32BytesRead != inUi32Size) {
+	if (ui64BytesRead != sizeof(T)) {
 		throw std::runtime_error("FileSystem_WFS::readStruct() - Incomplete read");
 	}
 
-	T result;
-	std::memcpy(&result, uiBuffer.get(), sizeof(T));
 	return result;
 }
 
@@ -114,29 +542,52 @@ template <typename T> T FileSystem_WFS::readStruct(uint64_t inUi64Offset, uint32
 * \param
 * uint64_t inUi64Offset - Смещение в файле, с которого начинается чтение.
 *
-* uint32_t inUi32Size - Количество байт, которое необходимо прочитать.
+* uint64_t inUi64Size - Количество байт, которое необходимо прочитать.
 *
 * \return
 * std::unique_ptr<uint8_t[]> - Указатель на буфер, содержащий прочитанные данные. 
 **/
-std::unique_ptr<uint8_t[]> FileSystem_WFS::readRawData(uint64_t inUi64Offset, uint32_t inUi32Size) {
-	if (!inputFile_->setPosition(inUi64Offset, FILE_ORIGIN_BEGIN)) {
-		throw std::runtime_error("FileSystem_WFS::readRawData() - Failed to set file position");
-	}
-
-	std::unique_ptr<uint8_t[]> uiBuffer(new uint8_t[inUi32Size]);
-	uint32_t ui32BytesRead = 0;
-	if (!inputFile_->read(uiBuffer.get(), inUi32Size, ui32BytesRead)) {
+std::unique_ptr<uint8_t[]> FileSystem_WFS::readRawData(uint64_t inUi64Offset, uint64_t inUi64Size) {
+	std::unique_ptr<uint8_t[]> uiBuffer(new uint8_t[inUi64Size]);
+	uint64_t ui64BytesRead = 0;
+	if (!inputFile_->readAt(inUi64Offset, uiBuffer.get(), inUi64Size, ui64BytesRead)) {
 		throw std::runtime_error("FileSystem_WFS::readRawData() - Failed to read data");
 	}
 
-	if (ui32BytesRead != inUi32Size) {
+	if (ui64BytesRead != inUi64Size) {
 		throw std::runtime_error("FileSystem_WFS::readRawData() - Incomplete read");
 	}
 
 	return uiBuffer;
 }
 
+/**
+* \brief
+* Предоставляет доступ только для чтения к указанному участку данных.
+* Если источник поддерживает прямой доступ (например, MmapFile), возвращается участок
+* отображённого образа без выделения памяти и копирования. Иначе данные читаются
+* в буфер pUi8Holder, который должен существовать, пока используется результат.
+*
+* \param
+* uint64_t inUi64Offset - Смещение в файле, с которого начинается участок.
+*
+* uint64_t inUi64Size - Размер участка в байтах.
+*
+* std::unique_ptr<uint8_t[]>& pUi8Holder - Буфер для данных, если прямой доступ недоступен.
+*
+* \return
+* ByteView - Участок данных.
+**/
+ByteView FileSystem_WFS::readDataView(uint64_t inUi64Offset, uint64_t inUi64Size, std::unique_ptr<uint8_t[]>& pUi8Holder) {
+	ByteView stView = inputFile_->view(inUi64Offset, inUi64Size);
+	if (!stView.empty()) {
+		return stView;
+	}
+
+	pUi8Holder = readRawData(inUi64Offset, inUi64Size);
+	return ByteView{ pUi8Holder.get(), inUi64Size };
+}
+
 /**
 * \brief
 * Проверка сигнатуры конца супер блока.
@@ -160,15 +611,27 @@ bool FileSystem_WFS::checkWFSSuperBlock(const WFSSuperBlock& inPStWFSSuperblock)
 * Инициализация внутренней структуры stWFSAllValue класса FileSystem_WFS на основании данных из супер блока.
 **/
 void FileSystem_WFS::initSuperBlock() {
-	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaMainDesc);
 	uint64_t ui64OffsetSuperBlock = 0x3000;
 
-	WFSSuperBlock stWFSSuperBlock = readStruct<WFSSuperBlock>(ui64OffsetSuperBlock, sizeof(WFSSuperBlock));
-	if (!checkWFSSuperBlock(stWFSSuperBlock)) {
+	WFSSuperBlock stReadSuperBlock = readStruct<WFSSuperBlock>(ui64OffsetSuperBlock, sizeof(WFSSuperBlock));
+	if (!checkWFSSuperBlock(stReadSuperBlock)) {
 		throw std::runtime_error("FileSystem_WFS::initSuperBlock() - Invalid WFS SuperBlock");
 	}
+	applySuperBlock(stReadSuperBlock);
+}
+
+/**
+* \brief
+* Заполняет значения stWFSAllValue, вычисляемые по SuperBlock, и запоминает SuperBlock.
+* Количество дескрипторов (результат разбора IndexArea) не изменяется.
+**/
+void FileSystem_WFS::applySuperBlock(const WFSSuperBlock& inStWFSSuperBlock) {
+	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaMainDesc);
+
+	stWFSSuperBlock = inStWFSSuperBlock;
 
 	stWFSAllValue.ui32DiskBlockSize					 = stWFSSuperBlock.ui32DiskBlockSize;
+	inputFile_->setBlockSizeHint(stWFSAllValue.ui32DiskBlockSize);
 	stWFSAllValue.ui32CountAllVideoFragments		 = stWFSSuperBlock.ui32CountAllVideoFragments;
 	stWFSAllValue.ui32ReservedVideoFragmentCount	 = stWFSSuperBlock.ui32ReservedVideoFragmentCount;
 	stWFSAllValue.ui32VideoFragmentSizeDBS			 = stWFSSuperBlock.ui32VideoFragmentSizeDBS;
@@ -177,13 +640,13 @@ void FileSystem_WFS::initSuperBlock() {
 	stWFSAllValue.ui64ReservedVideoFragmentSizeBytes = static_cast<uint64_t>(stWFSAllValue.ui32VideoFragmentSizeByte) * static_cast<uint64_t>(stWFSAllValue.ui32ReservedVideoFragmentCount);
 	stWFSAllValue.ui64UsedVideoFragmentSizeBytes	 = stWFSAllValue.ui64TotalVideoFragmentSizeBytes - stWFSAllValue.ui64ReservedVideoFragmentSizeBytes;
 
-	stWFSAllValue.stWFSTimeStampLastInDataBlock		 = convertTime(stWFSSuperBlock.ui32TimeStampLastInDataBlock);
-	stWFSAllValue.stWFSTimeStampLastWrite			 = convertTime(stWFSSuperBlock.ui32TimeStampLastWrite);
-	stWFSAllValue.stWFSTimeStampFistLast			 = convertTime(stWFSSuperBlock.ui32TimeStampFistWillReWrite);
-	stWFSAllValue.stWFSTimeStampFistVideo			 = convertTime(stWFSSuperBlock.ui32TimeStampFistVideo);
+	stWFSAllValue.stWFSTimeStampLastInDataBlock		 = WFSTime::toDateTime(stWFSSuperBlock.ui32TimeStampLastInDataBlock);
+	stWFSAllValue.stWFSTimeStampLastWrite			 = WFSTime::toDateTime(stWFSSuperBlock.ui32TimeStampLastWrite);
+	stWFSAllValue.stWFSTimeStampFistLast			 = WFSTime::toDateTime(stWFSSuperBlock.ui32TimeStampFistWillReWrite);
+	stWFSAllValue.stWFSTimeStampFistVideo			 = WFSTime::toDateTime(stWFSSuperBlock.ui32TimeStampFistVideo);
 
 	stWFSAllValue.ui32IndexAreaPosStart				 = stWFSSuperBlock.ui32IndexAreaPosStart;
-	stWFSAllValue.ui64IndexAreaOffset				 = stWFSSuperBlock.ui32DiskBlockSize * stWFSAllValue.ui32IndexAreaPosStart;
+	stWFSAllValue.ui64IndexAreaOffset				 = static_cast<uint64_t>(stWFSAllValue.ui32DiskBlockSize) * static_cast<uint64_t>(stWFSAllValue.ui32IndexAreaPosStart);
 
 	stWFSAllValue.ui64IndexAreaDescSizeReservedByte	 = static_cast<uint64_t>(stWFSAllValue.ui32ReservedVideoFragmentCount) * static_cast<uint64_t>(ui32SizeDescriptor);
 	stWFSAllValue.ui64IndexAreaOffsetFirstRecord	 = stWFSAllValue.ui64IndexAreaOffset + stWFSAllValue.ui64IndexAreaDescSizeReservedByte;
@@ -246,14 +709,17 @@ void FileSystem_WFS::printWFSInf() {
 	printf("0x%07X %9u - Позиция в IndexArea первого допустимого дескриптора фрагмента после дескрипторов фрагментов, которые будут перезаписаны (DBS)\n", stWFSAllValue.ui32IndexAreaVideoFragmentPosReWrite, stWFSAllValue.ui32IndexAreaVideoFragmentPosReWrite);
 	printf("0x%07llX %9llu - Позиция в IndexArea первого допустимого дескриптора фрагмента после дескрипторов фрагментов, которые будут перезаписаны (байты)\n", stWFSAllValue.ui64IndexAreaVideoFragmentPosReWriteOffset, stWFSAllValue.ui64IndexAreaVideoFragmentPosReWriteOffset);
 
-	std::cout << "---------------------------------------------------------------------" << std::endl;
-	std::cout << "Информация о количестве дескрипторов после их проверки:" << std::endl;
-	std::cout << "---------------------------------------------------------------------" << std::endl;
-	printf("%-6u - Кол-во основных дескрипторов\n", stWFSAllValue.ui32CountMainDesc);
-	printf("%-6u - Кол-во вторичных дескрипторов\n", stWFSAllValue.ui32CountSecDesc);
-	printf("%-6u - Кол-во зарезервированных дескрипторов\n", stWFSAllValue.ui32CountReservedDesc);
-	printf("%-6u - Кол-во других данных в IndexArea\n", stWFSAllValue.ui32CountAnotherDesc);
-	printf("%-6u - Кол-во всех дескрипторов в IndexArea\n", stWFSAllValue.ui32CountAllDesc);
+	// Количество дескрипторов известно только после разбора IndexArea
+	if (bIsIndexAreaScanned) {
+		std::cout << "---------------------------------------------------------------------" << std::endl;
+		std::cout << "Информация о количестве дескрипторов после их проверки:" << std::endl;
+		std::cout << "---------------------------------------------------------------------" << std::endl;
+		printf("%-6u - Кол-во основных дескрипторов\n", stWFSAllValue.ui32CountMainDesc);
+		printf("%-6u - Кол-во вторичных дескрипторов\n", stWFSAllValue.ui32CountSecDesc);
+		printf("%-6u - Кол-во зарезервированных дескрипторов\n", stWFSAllValue.ui32CountReservedDesc);
+		printf("%-6u - Кол-во других данных в IndexArea\n", stWFSAllValue.ui32CountAnotherDesc);
+		printf("%-6u - Кол-во всех дескрипторов в IndexArea\n", stWFSAllValue.ui32CountAllDesc);
+	}
 
 	std::cout << "---------------------------------------------------------------------" << std::endl;
 	std::cout << "DataArea information" << std::endl;
@@ -279,7 +745,7 @@ void FileSystem_WFS::printWFSInf() {
 * 
 * - Unknown / Other (неопознанные или ошибочные)
 * 
-* Результаты сохраняются в ассоциативные контейнеры: mapMainDesc, mapSecDesc, mapValidChains.
+* Результаты сохраняются в таблицу дескрипторов tableDesc и ассоциативный контейнер mapValidChains.
 * Также формируется карта связей для построения цепочек видеофрагментов.
 **/
 void FileSystem_WFS::analysisIndexArea() {
@@ -288,438 +754,1173 @@ void FileSystem_WFS::analysisIndexArea() {
 	std::cout << "---------------------------------------------------------------------" << std::endl;
 
 	uint64_t ui64OffsetIndexArea = stWFSAllValue.ui64IndexAreaOffset;	// Смещение на расположение IndexArea
-	uint32_t ui32SizeIndexArea;											// Размер IndexArea
 	uint64_t ui64SizeIndexArea;											// Размер IndexArea
 	ui64SizeIndexArea = stWFSAllValue.ui64IndexAreaOffsetEnd - stWFSAllValue.ui64IndexAreaOffset;
-	if (ui64SizeIndexArea > 0xFFFFFFFF) {
-		/*
-		* Очень большой размер IndexArea, надо читать по частям и это тоже неправильно, так как размер
-		* может быть очень большой - 4 GB
-		*/
-		throw std::runtime_error("FileSystem_WFS::analysisIndexArea() - IndexArea size too large (> 4GB)");
+
+	/*
+	* IndexArea читается строго последовательно: подсказка позволяет ядру выполнять
+	* агрессивное упреждающее чтение, а при отображении в память данные разбираются
+	* непосредственно на страницах образа без копирования в кучу
+	*/
+	inputFile_->advise(ui64OffsetIndexArea, ui64SizeIndexArea, FileAccessHint::Sequential);
+
+	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaSecDesc);	// Размер дескриптора видеофрагмента
+
+	/*
+	* IndexArea разбирается окнами по kUi64IndexAreaWindowSize: объём памяти под данные не зависит
+	* от размера диска, а размер IndexArea не ограничен 4 ГБ. Дескрипторы разбираются независимо
+	* друг от друга, поэтому результат не зависит от размера окна. Буфер окна выделяется один раз
+	* и используется повторно; при отображении в память буфер не нужен.
+	*/
+	uint32_t ui32DescPerWindow = static_cast<uint32_t>(kUi64IndexAreaWindowSize / ui32SizeDescriptor);
+	uint64_t ui64BufferSize = static_cast<uint64_t>(std::min(ui32DescPerWindow, stWFSAllValue.ui32CountAllVideoFragments)) * ui32SizeDescriptor;
+	std::unique_ptr<uint8_t[]> pUi8Window;
+	tableDesc.reset(stWFSAllValue.ui32CountAllVideoFragments);
+	if (stWFSAllValue.ui32CountAllVideoFragments != 0) {
+		inputFile_->advise(ui64OffsetIndexArea, ui64BufferSize, FileAccessHint::WillNeed);
+	}
+
+	uint32_t ui32WindowFirst = 0;
+	while (ui32WindowFirst < stWFSAllValue.ui32CountAllVideoFragments) {
+		uint32_t ui32WindowCount = std::min(ui32DescPerWindow, stWFSAllValue.ui32CountAllVideoFragments - ui32WindowFirst);
+		uint64_t ui64WindowOffset = ui64OffsetIndexArea + static_cast<uint64_t>(ui32WindowFirst) * ui32SizeDescriptor;
+		uint64_t ui64WindowSize = static_cast<uint64_t>(ui32WindowCount) * ui32SizeDescriptor;
+
+		// Следующее окно запрашивается заранее, пока разбирается текущее
+		if (ui32WindowFirst + ui32WindowCount < stWFSAllValue.ui32CountAllVideoFragments) {
+			uint32_t ui32NextCount = std::min(ui32DescPerWindow, stWFSAllValue.ui32CountAllVideoFragments - ui32WindowFirst - ui32WindowCount);
+			inputFile_->advise(ui64WindowOffset + ui64WindowSize, static_cast<uint64_t>(ui32NextCount) * ui32SizeDescriptor, FileAccessHint::WillNeed);
+		}
+
+		ByteView stIndexArea = inputFile_->view(ui64WindowOffset, ui64WindowSize);
+		if (stIndexArea.empty()) {
+			if (!pUi8Window) {
+				pUi8Window.reset(new uint8_t[ui64BufferSize]);
+			}
+			uint64_t ui64BytesRead = 0;
+			if (!inputFile_->readAt(ui64WindowOffset, pUi8Window.get(), ui64WindowSize, ui64BytesRead)) {
+				throw std::runtime_error("FileSystem_WFS::analysisIndexArea() - Failed to read IndexArea");
+			}
+			if (ui64BytesRead != ui64WindowSize) {
+				throw std::runtime_error("FileSystem_WFS::analysisIndexArea() - Incomplete read of IndexArea");
+			}
+			stIndexArea = ByteView{ pUi8Window.get(), ui64WindowSize };
+		}
+
+		scanIndexAreaWindow(stIndexArea.pData, ui32WindowFirst, ui32WindowCount);
+		ui32WindowFirst += ui32WindowCount;
+	}
+	stWFSAllValue.ui32CountAllDesc = stWFSAllValue.ui32CountMainDesc + stWFSAllValue.ui32CountSecDesc + stWFSAllValue.ui32CountReservedDesc;
+
+	// Массив записей MainDesc больше не растёт, поэтому цепочки получают указатели на записи
+	for (auto iterChain = mapValidChains.begin(); iterChain != mapValidChains.end(); ++iterChain) {
+		iterChain->second.pMainDes = tableDesc.findMain(iterChain->first);
+	}
+
+	// Дальнейшие обращения к IndexArea (построение цепочек) выполняются выборочно
+	inputFile_->advise(ui64OffsetIndexArea, ui64SizeIndexArea, FileAccessHint::Normal);
+}
+
+/**
+* \brief
+* Разбирает окно IndexArea. Диапазон дескрипторов окна делится на равные части между
+* потоками (не более ui32AnalysisThreads и не менее kUi32MinDescPerThread дескрипторов
+* на поток). Каждый поток заполняет собственный IndexAreaScanPart, после чего части
+* объединяются в порядке индексов дескрипторов, поэтому результат и собранные нарушения
+* совпадают с однопоточным разбором.
+*
+* \param
+* const uint8_t* inPUi8Data - данные окна.
+*
+* uint32_t inUi32FirstDesc - индекс первого дескриптора окна.
+*
+* uint32_t inUi32CountDesc - количество дескрипторов в окне.
+**/
+void FileSystem_WFS::scanIndexAreaWindow(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc) {
+	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaSecDesc);
+	uint32_t ui32Workers = (inUi32CountDesc + kUi32MinDescPerThread - 1) / kUi32MinDescPerThread;
+	ui32Workers = std::max<uint32_t>(1, std::min(ui32Workers, ui32AnalysisThreads));
+	uint32_t ui32DescPerWorker = (inUi32CountDesc + ui32Workers - 1) / ui32Workers;
+
+	std::vector<IndexAreaScanPart> vecParts(ui32Workers);
+	for (IndexAreaScanPart& stPart : vecParts) {
+		stPart.sinkAnomalies.reset(sinkAnomalies.getSampleLimit());
+	}
+	auto fnWorker = [&](uint32_t ui32Worker) {
+		uint32_t ui32Begin = std::min(inUi32CountDesc, ui32Worker * ui32DescPerWorker);
+		uint32_t ui32End = std::min(inUi32CountDesc, ui32Begin + ui32DescPerWorker);
+		classifyIndexAreaRange(inPUi8Data + static_cast<uint64_t>(ui32Begin) * ui32SizeDescriptor, inUi32FirstDesc + ui32Begin, ui32End - ui32Begin, vecParts[ui32Worker]);
+	};
+
+	if (ui32Workers == 1) {
+		fnWorker(0);
 	}
 	else {
-		ui32SizeIndexArea = static_cast<uint32_t>(ui64SizeIndexArea);
+		std::vector<std::exception_ptr> vecExceptions(ui32Workers);
+		std::vector<std::thread> vecThreads;
+		for (uint32_t ui32Worker = 1; ui32Worker < ui32Workers; ui32Worker++) {
+			vecThreads.emplace_back([&fnWorker, &vecExceptions, ui32Worker]() {
+				try {
+					fnWorker(ui32Worker);
+				}
+				catch (...) {
+					vecExceptions[ui32Worker] = std::current_exception();
+				}
+			});
+		}
+		try {
+			fnWorker(0);
+		}
+		catch (...) {
+			vecExceptions[0] = std::current_exception();
+		}
+		for (std::thread& thread : vecThreads) {
+			thread.join();
+		}
+		for (const std::exception_ptr& pException : vecExceptions) {
+			if (pException) {
+				std::rethrow_exception(pException);
+			}
+		}
+	}
+
+	for (IndexAreaScanPart& stPart : vecParts) {
+		mergeIndexAreaScanPart(stPart);
 	}
-	std::unique_ptr<uint8_t[]> pUi8ReadData = readRawData(ui64OffsetIndexArea, ui32SizeIndexArea);
+}
 
-	void* vPointerCurPos;										// Текущая позиция области памяти с которой осуществляется работа
+/**
+* \brief
+* Классифицирует дескрипторы IndexArea из непрерывного диапазона. Не изменяет состояние
+* объекта и может выполняться одновременно для разных диапазонов.
+*
+* \param
+* const uint8_t* inPUi8Data - данные первого дескриптора диапазона.
+*
+* uint32_t inUi32FirstDesc - индекс первого дескриптора диапазона.
+*
+* uint32_t inUi32CountDesc - количество дескрипторов.
+*
+* IndexAreaScanPart& outPart - результат разбора диапазона.
+**/
+void FileSystem_WFS::classifyIndexAreaRange(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, IndexAreaScanPart& outPart) {
+	const void* vPointerCurPos;									// Текущая позиция области памяти с которой осуществляется работа
 	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaSecDesc);	// Размер дескриптора видеофрагмента
+	DescTraits arrTraits[kUi32ClassifyBlockSize];				// Признаки текущего блока дескрипторов
+
+	for (uint32_t ui32MainCycleIteration = inUi32FirstDesc; ui32MainCycleIteration < inUi32FirstDesc + inUi32CountDesc; ui32MainCycleIteration++) {
+		// Признаки дескрипторов вычисляются векторным классификатором сразу для блока
+		uint32_t ui32RelativeDesc = ui32MainCycleIteration - inUi32FirstDesc;
+		if (ui32RelativeDesc % kUi32ClassifyBlockSize == 0) {
+			uint32_t ui32BlockCount = std::min(kUi32ClassifyBlockSize, inUi32CountDesc - ui32RelativeDesc);
+			DescClassifier::classify(inPUi8Data + static_cast<uint64_t>(ui32RelativeDesc) * ui32SizeDescriptor, ui32MainCycleIteration, ui32BlockCount, arrTraits);
+		}
+		const DescTraits& stTraits = arrTraits[ui32RelativeDesc % kUi32ClassifyBlockSize];
 
-	for (uint32_t ui32MainCycleIteration = 0; ui32MainCycleIteration < stWFSAllValue.ui32CountAllVideoFragments; ui32MainCycleIteration++) {
 		/*
 		* Работа с главными дескрипторами описания видеофрагментов
 		* 
 		* Какой-то особенный видеофрагмент
 		* Позиция IndexArea + Размер зарезервированных + 0x35D4
-		* if (vPointerCurPos == reinterpret_cast<void*>(reinterpret_cast<uint64_t>(pUi8ReadData.get()) + (ui32SizeDescriptorVideoFragment * 0x35D4)))
+		* if (vPointerCurPos == stIndexArea.pData + (ui32SizeDescriptorVideoFragment * 0x35D4))
 		* 0x17600 + 0x800 + 0x35D4 = 0x1B3D4
 		* Данный видеофрагмент находится в SuperBlock копии которая располагается по смещению 0x83000
 		* Также установлено что по смещению 0x83000 располагается SuperBlock,
 		* некоторые данные в нем отличаются. Нахождение данного блока вызвано какой-то ошибкой
 		*/
-		uint64_t ui64OffsetIterIndexVideoDesc = stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(ui32MainCycleIteration) * static_cast<uint64_t>(ui32SizeDescriptor);
-		vPointerCurPos = reinterpret_cast<void*>(reinterpret_cast<uint64_t>(pUi8ReadData.get()) + ui32MainCycleIteration * ui32SizeDescriptor);
-		uint8_t ui8TypeDescriptor = *reinterpret_cast<uint8_t*>(reinterpret_cast<uint64_t>(vPointerCurPos) + 1);
+		vPointerCurPos = inPUi8Data + static_cast<uint64_t>(ui32RelativeDesc) * ui32SizeDescriptor;
+		const uint8_t* pUi8Raw = static_cast<const uint8_t*>(vPointerCurPos);
+		uint8_t ui8TypeDescriptor = stTraits.ui8Type;
+		AnomalyKind eKind;
 		if (ui8TypeDescriptor == 0x02 || ui8TypeDescriptor == 0x03) {
-			if (isLikelyMainDesc(ui32MainCycleIteration, ui32SizeDescriptor, vPointerCurPos)) {
-				stWFSAllValue.ui32CountMainDesc++;
-
-				// Работаем с данными в областью памяти (vPointerCurPos) как со структурой WFSIndexAreaMainDesc
-				WFSIndexAreaMainDesc* stWFSIndexAreaMainDesc = reinterpret_cast<WFSIndexAreaMainDesc*>(vPointerCurPos);
-				WFSMainDescAdvInfo stIndexAreaMainDesc;
-
-				stIndexAreaMainDesc.ui16CountSecDesc = (uint32_t)(stWFSIndexAreaMainDesc->ui16CountSecDesc);
-				stIndexAreaMainDesc.ui32IndexNextSecDesc = stWFSIndexAreaMainDesc->ui32IndexNextSecDesc;
-				if (stIndexAreaMainDesc.ui32IndexNextSecDesc == 0xFFFFFFFF) {
-					stIndexAreaMainDesc.ui64OffsetNextSecDesc = 0;
-				}
-				else {
-					stIndexAreaMainDesc.ui64OffsetNextSecDesc = stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(stIndexAreaMainDesc.ui32IndexNextSecDesc) * static_cast<uint64_t>(ui32SizeDescriptor);
-				}
-				
-				stIndexAreaMainDesc.ui32IndexCurrentMainDesc		= stWFSIndexAreaMainDesc->ui32IndexCurrentMainDesc;
-				stIndexAreaMainDesc.ui64OffsetCurrentMainDesc		= ui64OffsetIterIndexVideoDesc;
-				stIndexAreaMainDesc.stTimeStampStartVideoStream		= convertTime(stWFSIndexAreaMainDesc->ui32TimeStampStartVideoStream);
-				stIndexAreaMainDesc.stTimeStampEndVideoStream		= convertTime(stWFSIndexAreaMainDesc->ui32TimeStampEndVideoStream);
-				stIndexAreaMainDesc.ui16LastVideoFragmentSizeDBS	= stWFSIndexAreaMainDesc->ui16LastVideoFragmentSizeDBS;
-				stIndexAreaMainDesc.ui8RecordOrderVideo				= stWFSIndexAreaMainDesc->ui8RecordOrderVideo;
-				stIndexAreaMainDesc.ui8CameraNumber					= (stWFSIndexAreaMainDesc->ui8CameraNumber - 0x02) / 0x04 + 1;
-
-				mapMainDesc[ui32MainCycleIteration] = stIndexAreaMainDesc;
-				mapValidChains[ui32MainCycleIteration].pMainDes = &mapMainDesc[ui32MainCycleIteration];
+			if (isLikelyMainDesc(stTraits, eKind)) {
+				outPart.ui32CountMainDesc++;
+				outPart.vecMainDesc.emplace_back(ui32MainCycleIteration, makeMainDescInfo(vPointerCurPos));
 			}
 			else {
-				std::cout << "FileSystem_WFS::analysisIndexArea() - Current data not MainDescriptor video fragment" << std::endl;
-				dumpHex(vPointerCurPos, ui32SizeDescriptor, ui64OffsetIterIndexVideoDesc);
+				outPart.sinkAnomalies.record(eKind, ui32MainCycleIteration, pUi8Raw);
 			}
 			continue;
 		}
 		if (ui8TypeDescriptor == 0x01) {
-			if (isLikelySecDesc(ui32SizeDescriptor, vPointerCurPos)) {
-				stWFSAllValue.ui32CountSecDesc++;
-
-				// Работаем с данными в областью памяти (vPointerCurPos) как со структурой structWFSIndexAreaSecondaryDescriptor
-				WFSIndexAreaSecDesc* stWFSIndexAreaSecondaryDesc = reinterpret_cast<WFSIndexAreaSecDesc*>(vPointerCurPos);
-				WFSSecDescAdvInfo stIndexAreaSecDesc;
-
-				stIndexAreaSecDesc.ui16RelativeIndexCurSecDesc	= (uint32_t)(stWFSIndexAreaSecondaryDesc->ui16RelativeIndexCurSecDesc);
-				stIndexAreaSecDesc.ui32IndexNextSecDesc			= stWFSIndexAreaSecondaryDesc->ui32IndexNextSecDesc;
-				stIndexAreaSecDesc.ui64OffsetNextSecDesc		= stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(stIndexAreaSecDesc.ui32IndexNextSecDesc) * static_cast<uint64_t>(ui32SizeDescriptor);
-				stIndexAreaSecDesc.ui32IndexCurrentSecDesc		= ui32MainCycleIteration;
-				stIndexAreaSecDesc.ui64OffsetCurrentSecDesc		= stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(stIndexAreaSecDesc.ui32IndexCurrentSecDesc) * static_cast<uint64_t>(ui32SizeDescriptor);
-				stIndexAreaSecDesc.ui32IndexPrevSecDesc			= stWFSIndexAreaSecondaryDesc->ui32IndexPrevSecDesc;
-				stIndexAreaSecDesc.ui64OffsetPrevSecDesc		= stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(stIndexAreaSecDesc.ui32IndexPrevSecDesc) * static_cast<uint64_t>(ui32SizeDescriptor);
-				stIndexAreaSecDesc.stTimeStampStartVideoSegment	= convertTime(stWFSIndexAreaSecondaryDesc->ui32TimeStampStartVideoFragment);
-				stIndexAreaSecDesc.stTimeStampEndVideoSegment	= convertTime(stWFSIndexAreaSecondaryDesc->ui32TimeStampEndVideoFragment);
-				stIndexAreaSecDesc.ui16LastVideoFragmentSizeDBS	= stWFSIndexAreaSecondaryDesc->ui16LastVideoFragmentSizeDBS;
-				stIndexAreaSecDesc.ui32IndexMainDesc			= stWFSIndexAreaSecondaryDesc->ui32IndexMainDesc;
-				stIndexAreaSecDesc.ui64OffsetMainDesc			= stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(stIndexAreaSecDesc.ui32IndexMainDesc) * static_cast<uint64_t>(ui32SizeDescriptor);
-				stIndexAreaSecDesc.ui8RecordOrderVideo			= stWFSIndexAreaSecondaryDesc->ui8RecordOrderVideo;
-				stIndexAreaSecDesc.ui8CameraNumber				= (stWFSIndexAreaSecondaryDesc->ui8CameraNumber - 0x02) / 0x04 + 1;
-
-				mapSecDesc[ui32MainCycleIteration] = stIndexAreaSecDesc;
+			if (isLikelySecDesc(stTraits, eKind)) {
+				outPart.ui32CountSecDesc++;
+				outPart.vecSecDesc.push_back(makeSecDescInfo(vPointerCurPos, ui32MainCycleIteration));
 			}
 			else {
-				std::cout << "FileSystem_WFS::analysisIndexArea() - Current data not Secondary Descriptor video fragment" << std::endl;
-				dumpHex(vPointerCurPos, ui32SizeDescriptor, ui64OffsetIterIndexVideoDesc);
+				outPart.sinkAnomalies.record(eKind, ui32MainCycleIteration, pUi8Raw);
 			}
 			continue;
 		}
 		if (ui8TypeDescriptor == 0xFE) {
-			/*
-				Вычисление адреса зарезервированного дескриптора видеофрагмента. Для работы как с числом
-				значение указателя (адрес) необходимо преобразовать в соответствующий тип данных - reinterpret_cast<uint64_t>(pUi8ReadData.get())
-			*/
 
-			// Подсчет количества нулевых и не нулевых байт
-			uint32_t ui32CountZeroValue = 0;
-			uint32_t ui32CountNotZeroValue = 0;
-			for (uint8_t ui8ChildrenCycleIteration = 0; ui8ChildrenCycleIteration < ui32SizeDescriptor; ui8ChildrenCycleIteration++) {
-				uint8_t ui8ValueByte = *reinterpret_cast<uint8_t*>(reinterpret_cast<uint64_t>(vPointerCurPos) + ui8ChildrenCycleIteration);
-				if (ui8ValueByte == 0)
-					ui32CountZeroValue++;
-				else
-					ui32CountNotZeroValue++;
-			}
-			if ((ui32CountNotZeroValue == 1) and (ui32CountZeroValue == 31) and (ui32CountNotZeroValue + ui32CountZeroValue) == ui32SizeDescriptor) {
-				stWFSAllValue.ui32CountReservedDesc++;
+			// Количество нулевых и не нулевых байт
+			uint32_t ui32CountZeroValue = stTraits.ui8ZeroCount;
+			uint32_t ui32CountNotZeroValue = ui32SizeDescriptor - ui32CountZeroValue;
+			if ((ui32CountNotZeroValue == 1) and (ui32CountZeroValue == 31)) {
+				outPart.ui32CountReservedDesc++;
+				outPart.vecReservedSlots.push_back(ui32MainCycleIteration);
 			}
 			else {
-				std::cout << "FileSystem_WFS::analysisIndexArea() - Current data not Reserved Descriptor video fragment" << std::endl;
-				dumpHex(vPointerCurPos, ui32SizeDescriptor, ui64OffsetIterIndexVideoDesc);
+				outPart.sinkAnomalies.record(AnomalyKind::ReservedDescDamaged, ui32MainCycleIteration, pUi8Raw);
 			}
 			continue;
 		}
 		else {
-			std::cout << "FileSystem_WFS::analysisIndexArea() - Current data Another Descriptor video fragment" << std::endl;
-			dumpHex(vPointerCurPos, ui32SizeDescriptor, ui64OffsetIterIndexVideoDesc);
+			outPart.sinkAnomalies.record(AnomalyKind::AnotherDesc, ui32MainCycleIteration, pUi8Raw);
 
-			stWFSAllValue.ui32CountAnotherDesc++;
+			outPart.ui32CountAnotherDesc++;
+			outPart.vecAnotherSlots.push_back(ui32MainCycleIteration);
 			continue;
 		}
 	}
-	stWFSAllValue.ui32CountAllDesc = stWFSAllValue.ui32CountMainDesc + stWFSAllValue.ui32CountSecDesc + stWFSAllValue.ui32CountReservedDesc;
 }
 
 /**
 * \brief
-* Вывод участка данных в консоль.
-*
-* \param
-* const void* vPointOffsetPrintData - указатель на начало данных выводимой области.
-* 
-* uint32_t ui32SizePrintData - размер выводимой области.
-* 
-* uint64_t ui64OffsetInFWS - относительный адрес выводимой области исследуемых данных.
+* Добавляет результат разбора части IndexArea к общим счётчикам и контейнерам дескрипторов
+* и нарушениям. Части передаются в порядке возрастания индексов.
 **/
-void FileSystem_WFS::dumpHex(const void* vPointOffsetPrintData, uint32_t ui32SizePrintData, uint64_t ui64OffsetInFWS) {
-	for (uint8_t ui32IterRow = 0; ui32IterRow < (ui32SizePrintData + 15) / 16; ui32IterRow++) {
-		std::cout << "\t0x" << std::hex << ui64OffsetInFWS + static_cast<uint64_t>(ui32IterRow) * 16 << ": ";
-		for (uint8_t ui8Column = 0; ui8Column < 16; ui8Column++) {
-			uint8_t ui8PrintByte = *reinterpret_cast<uint8_t*>(reinterpret_cast<uint64_t>(vPointOffsetPrintData) + static_cast<uint64_t>(ui32IterRow) * 16 + ui8Column);
-			std::cout << std::setw(2) << std::setfill('0') << std::hex << static_cast<int>(ui8PrintByte) << " ";
-		}
-		std::cout << std::dec << std::endl;
+void FileSystem_WFS::mergeIndexAreaScanPart(IndexAreaScanPart& inPart) {
+	stWFSAllValue.ui32CountMainDesc += inPart.ui32CountMainDesc;
+	stWFSAllValue.ui32CountSecDesc += inPart.ui32CountSecDesc;
+	stWFSAllValue.ui32CountReservedDesc += inPart.ui32CountReservedDesc;
+	stWFSAllValue.ui32CountAnotherDesc += inPart.ui32CountAnotherDesc;
+
+	// Указатели на MainDesc выдаются цепочкам после разбора всей IndexArea (analysisIndexArea)
+	for (const std::pair<uint32_t, WFSMainDescAdvInfo>& pairMainDesc : inPart.vecMainDesc) {
+		tableDesc.addMain(pairMainDesc.first, pairMainDesc.second);
+		mapValidChains.emplace_hint(mapValidChains.end(), pairMainDesc.first, FragmentChain());
 	}
+	for (const WFSSecDescAdvInfo& stSecDesc : inPart.vecSecDesc) {
+		tableDesc.addSec(stSecDesc.ui32IndexCurrentSecDesc, stSecDesc);
+	}
+	for (uint32_t ui32Slot : inPart.vecReservedSlots) {
+		tableDesc.markReserved(ui32Slot);
+	}
+	for (uint32_t ui32Slot : inPart.vecAnotherSlots) {
+		tableDesc.markAnother(ui32Slot);
+	}
+	// Записи части перенесены в таблицу: память освобождается до объединения следующей части
+	std::vector<std::pair<uint32_t, WFSMainDescAdvInfo>>().swap(inPart.vecMainDesc);
+	std::vector<WFSSecDescAdvInfo>().swap(inPart.vecSecDesc);
+	std::vector<uint32_t>().swap(inPart.vecReservedSlots);
+	std::vector<uint32_t>().swap(inPart.vecAnotherSlots);
+
+	sinkAnomalies.merge(inPart.sinkAnomalies);
 }
 
 /**
 * \brief
-* Наполнение ассоциативного массива mapValidChains информацией MainDesc
-* и непрерывной цепочкой SecDesc
+* Формирует запись MainDesc из дескриптора IndexArea.
+*
+* \param
+* const void* inPointDesc - данные дескриптора, прошедшего проверку isLikelyMainDesc.
 **/
-void FileSystem_WFS::rebuildUnwrittenVideoChain() {
-	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaMainDesc);
-
-	uint32_t ui32CountMainDescWithoutSecDesc = 0;
-	uint32_t ui32CountAddSecDesc = 0;
-	uint32_t ui32CountMainDesc = 0;
+WFSMainDescAdvInfo FileSystem_WFS::makeMainDescInfo(const void* inPointDesc) {
+	// Работаем с данными в областью памяти (inPointDesc) как со структурой WFSIndexAreaMainDesc
+	const WFSIndexAreaMainDesc* stWFSIndexAreaMainDesc = reinterpret_cast<const WFSIndexAreaMainDesc*>(inPointDesc);
+	WFSMainDescAdvInfo stIndexAreaMainDesc;
+
+	stIndexAreaMainDesc.ui16CountSecDesc = (uint32_t)(stWFSIndexAreaMainDesc->ui16CountSecDesc);
+	stIndexAreaMainDesc.ui32IndexNextSecDesc = stWFSIndexAreaMainDesc->ui32IndexNextSecDesc;
+	stIndexAreaMainDesc.ui32IndexCurrentMainDesc		= stWFSIndexAreaMainDesc->ui32IndexCurrentMainDesc;
+	stIndexAreaMainDesc.ui32TimeStampStartVideoStream	= stWFSIndexAreaMainDesc->ui32TimeStampStartVideoStream;
+	stIndexAreaMainDesc.ui32TimeStampEndVideoStream		= stWFSIndexAreaMainDesc->ui32TimeStampEndVideoStream;
+	stIndexAreaMainDesc.ui16LastVideoFragmentSizeDBS	= stWFSIndexAreaMainDesc->ui16LastVideoFragmentSizeDBS;
+	stIndexAreaMainDesc.ui8RecordOrderVideo				= stWFSIndexAreaMainDesc->ui8RecordOrderVideo;
+	stIndexAreaMainDesc.ui8CameraNumber					= (stWFSIndexAreaMainDesc->ui8CameraNumber - 0x02) / 0x04 + 1;
+	return stIndexAreaMainDesc;
+};
 
-	for (auto iterFragChain = mapValidChains.begin(); iterFragChain != mapValidChains.end(); ++iterFragChain) {
-		ui32CountMainDesc++;
-		
-		uint32_t ui32IndexCurrentMainDesc = iterFragChain->first;
-		FragmentChain& videoChainCurMainDesc = iterFragChain->second;
+/**
+* \brief
+* Формирует запись SecDesc из дескриптора IndexArea.
+*
+* \param
+* const void* inPointDesc - данные дескриптора, прошедшего проверку isLikelySecDesc.
+*
+* uint32_t inUi32IndexDesc - номер дескриптора в IndexArea.
+**/
+WFSSecDescAdvInfo FileSystem_WFS::makeSecDescInfo(const void* inPointDesc, uint32_t inUi32IndexDesc) {
+	// Работаем с данными в областью памяти (inPointDesc) как со структурой structWFSIndexAreaSecondaryDescriptor
+	const WFSIndexAreaSecDesc* stWFSIndexAreaSecondaryDesc = reinterpret_cast<const WFSIndexAreaSecDesc*>(inPointDesc);
+	WFSSecDescAdvInfo stIndexAreaSecDesc;
+
+	stIndexAreaSecDesc.ui16RelativeIndexCurSecDesc	= (uint32_t)(stWFSIndexAreaSecondaryDesc->ui16RelativeIndexCurSecDesc);
+	stIndexAreaSecDesc.ui32IndexNextSecDesc			= stWFSIndexAreaSecondaryDesc->ui32IndexNextSecDesc;
+	stIndexAreaSecDesc.ui32IndexCurrentSecDesc		= inUi32IndexDesc;
+	stIndexAreaSecDesc.ui32IndexPrevSecDesc			= stWFSIndexAreaSecondaryDesc->ui32IndexPrevSecDesc;
+	stIndexAreaSecDesc.ui32TimeStampStartVideoSegment	= stWFSIndexAreaSecondaryDesc->ui32TimeStampStartVideoFragment;
+	stIndexAreaSecDesc.ui32TimeStampEndVideoSegment	= stWFSIndexAreaSecondaryDesc->ui32TimeStampEndVideoFragment;
+	stIndexAreaSecDesc.ui16LastVideoFragmentSizeDBS	= stWFSIndexAreaSecondaryDesc->ui16LastVideoFragmentSizeDBS;
+	stIndexAreaSecDesc.ui32IndexMainDesc			= stWFSIndexAreaSecondaryDesc->ui32IndexMainDesc;
+	stIndexAreaSecDesc.ui8RecordOrderVideo			= stWFSIndexAreaSecondaryDesc->ui8RecordOrderVideo;
+	stIndexAreaSecDesc.ui8CameraNumber				= (stWFSIndexAreaSecondaryDesc->ui8CameraNumber - 0x02) / 0x04 + 1;
+	return stIndexAreaSecDesc;
+};
 
-		uint16_t ui16CountSecDesc = videoChainCurMainDesc.pMainDes->ui16CountSecDesc;
-		uint32_t ui32IndexNextSecDesc = videoChainCurMainDesc.pMainDes->ui32IndexNextSecDesc;
+/**
+* \brief
+* Возвращает запись SecDesc слота inUi32Slot. После разбора IndexArea запись берётся из
+* tableDesc, до разбора дескриптор читается и проверяется выборочно и добавляется в tableDesc.
+* Добавление может переместить записи tableDesc, поэтому указатель действителен только
+* до следующего вызова.
+*
+* \param
+* AnomalySink& outAnomalies - сборщик нарушений; в него записывается отклонённый дескриптор
+* с типом SecDesc.
+*
+* \return
+* Указатель на запись или nullptr, если в слоте нет SecDesc.
+**/
+WFSSecDescAdvInfo* FileSystem_WFS::lookupSecDesc(uint32_t inUi32Slot, AnomalySink& outAnomalies) {
+	if (bIsIndexAreaScanned or tableDesc.isValid(inUi32Slot)) {
+		return tableDesc.findSec(inUi32Slot);
+	}
+	if (inUi32Slot >= stWFSAllValue.ui32CountAllVideoFragments) {
+		return nullptr;
+	}
+	if (tableDesc.getSlotCount() != stWFSAllValue.ui32CountAllVideoFragments) {
+		tableDesc.reset(stWFSAllValue.ui32CountAllVideoFragments);
+	}
 
-		uint64_t ui64OffsetCurrentMainDesc = stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(ui32IndexCurrentMainDesc) * static_cast<uint64_t>(ui32SizeDescriptor);
+	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaSecDesc);
+	std::unique_ptr<uint8_t[]> pUi8Holder;
+	const uint8_t* pUi8Desc = readDataView(getDescOffset(stWFSAllValue.ui64IndexAreaOffset, inUi32Slot), ui32SizeDescriptor, pUi8Holder).pData;
 
-		uint8_t ui8CameraNumber = videoChainCurMainDesc.pMainDes->ui8CameraNumber;
-		bool isFirst = true;
-		bool isConsistentCameraNumber = true;
+	DescTraits stTraits;
+	AnomalyKind eKind;
+	DescClassifier::classify(pUi8Desc, inUi32Slot, 1, &stTraits);
+	if (stTraits.ui8Type != 0x01) {
+		return nullptr;
+	}
+	if (!isLikelySecDesc(stTraits, eKind)) {
+		outAnomalies.record(eKind, inUi32Slot, pUi8Desc);
+		return nullptr;
+	}
+	return tableDesc.addSec(inUi32Slot, makeSecDescInfo(pUi8Desc, inUi32Slot));
+};
 
-		/*
-		* Проверка 1
-		* Возможно, что MainDesc отсутствуют вторичные дескрипторы
+/**
+* \brief
+* Наполнение цепочки inFragmentChain непрерывной цепочкой SecDesc, указанной в MainDesc
+* с номером inUi32IndexCurrentMainDesc (inFragmentChain.pMainDes). Признаки bIsAdd не
+* изменяются (см. markChainAdded), поэтому разные цепочки можно строить одновременно.
+*
+* \param
+* AnomalySink& outAnomalies - сборщик нарушений цепочки.
+* std::vector<uint32_t>* outPVecReadSlots - если задан, в него добавляются номера всех
+* прочитанных при обходе слотов SecDesc (используется refreshValidChains).
+*
+* \return
+* true, если цепочка построена (MainDesc и добавленные SecDesc отмечаются как добавленные),
+* false, если MainDesc не ссылается на корректный первый SecDesc.
+**/
+bool FileSystem_WFS::rebuildValidChain(uint32_t inUi32IndexCurrentMainDesc, FragmentChain& inFragmentChain, AnomalySink& outAnomalies, std::vector<uint32_t>* outPVecReadSlots) {
+	// Все обращения обхода к SecDesc выполняются через fnLookupSecDesc
+	auto fnLookupSecDesc = [this, &outAnomalies, outPVecReadSlots](uint32_t inUi32Slot) {
+		if (outPVecReadSlots != nullptr) {
+			outPVecReadSlots->push_back(inUi32Slot);
+		}
+		return lookupSecDesc(inUi32Slot, outAnomalies);
+	};
+
+	uint32_t ui32IndexCurrentMainDesc = inUi32IndexCurrentMainDesc;
+	FragmentChain& videoChainCurMainDesc = inFragmentChain;
+
+	uint16_t ui16CountSecDesc = videoChainCurMainDesc.pMainDes->ui16CountSecDesc;
+	uint32_t ui32IndexNextSecDesc = videoChainCurMainDesc.pMainDes->ui32IndexNextSecDesc;
+
+	uint8_t ui8CameraNumber = videoChainCurMainDesc.pMainDes->ui8CameraNumber;
+
+	/*
+	* Проверка 1
+	* Возможно, что MainDesc отсутствуют вторичные дескрипторы
+	*/
+	if (ui16CountSecDesc == 0 and (ui32IndexNextSecDesc == 0 or ui32IndexNextSecDesc == 0xFFFFFFFF)) {
+		return true;
+	}
+
+	/*
+	* Проверка 2
+	* Возможно, что MainDesc ссылается на не существующий SecDesc
+	* Например, у MainDesc номер которого ui32IndexCurrentMainDesc	= 98264
+	* if (ui32MainCycleIteration  == 4294967295)
+	* Надо разобраться с ui32IndexCurrentMainDesc и ui32IndexNextSecDesc нормально их переименовать!!!!
+	*/
+	if ((ui32IndexNextSecDesc > 0) and (ui32IndexNextSecDesc <= stWFSAllValue.ui32CountAllVideoFragments)) {
+		/*
+		* Возможно, что первого фрагмента SecDesc который указан в MainDesc не существует
+		* Поэтому необходимо осуществить проверку по индексу
 		*/
-		if (ui16CountSecDesc == 0 and (ui32IndexNextSecDesc == 0 or ui32IndexNextSecDesc == 0xFFFFFFFF)) {
-			videoChainCurMainDesc.pMainDes->bIsAdd = true;
-			ui32CountMainDescWithoutSecDesc++;
-			continue;
+		WFSSecDescAdvInfo* pSecDesc = fnLookupSecDesc(ui32IndexNextSecDesc);
+		if (pSecDesc == nullptr) {
+			outAnomalies.record(AnomalyKind::ChainFirstSecNotFound, ui32IndexNextSecDesc, nullptr, ui32IndexCurrentMainDesc, 1);
+			return false;
+		}
+
+		uint32_t ui32IndexCurrentSecDesc = pSecDesc->ui32IndexCurrentSecDesc;
+		uint32_t ui32IndexPrevSecDesc = pSecDesc->ui32IndexPrevSecDesc;
+
+
+		if (ui32IndexCurrentSecDesc != ui32IndexNextSecDesc) {
+			outAnomalies.record(AnomalyKind::ChainFirstSecMismatch, ui32IndexNextSecDesc, nullptr, ui32IndexCurrentMainDesc, 1, ui32IndexCurrentSecDesc);
+			return false;
 		}
 
 		/*
-		* Проверка 2
-		* Возможно, что MainDesc ссылается на не существующий SecDesc
-		* Например, у MainDesc номер которого ui32IndexCurrentMainDesc	= 98264
-		* if (ui32MainCycleIteration  == 4294967295)
-		* Надо разобраться с ui32IndexCurrentMainDesc и ui32IndexNextSecDesc нормально их переименовать!!!!
+		* Можно проверить чему равен ui32IndexPrevSecDesc у первого вторичного дескриптора
+		* У первого SecDesc это будет номер MainDesc
 		*/
-		if ((ui32IndexNextSecDesc > 0) and (ui32IndexNextSecDesc <= stWFSAllValue.ui32CountAllVideoFragments)) {
-			/*
-			* Возможно, что первого фрагмента SecDesc который указан в MainDesc не существует
-			* Поэтому необходимо осуществить проверку по индексу
-			*/
-			auto iterMapSecDesc = mapSecDesc.find(ui32IndexNextSecDesc);
-			if (iterMapSecDesc == mapSecDesc.end()) {
-				std::cout << "Warning: Secondary descriptor not found for index " << ui32IndexNextSecDesc << std::endl;
+		if (ui32IndexPrevSecDesc != ui32IndexCurrentMainDesc) {
+			outAnomalies.record(AnomalyKind::ChainFirstSecNoBackLink, ui32IndexNextSecDesc, nullptr, ui32IndexCurrentMainDesc, 1, ui32IndexPrevSecDesc);
+			return false;
+		}
 
-				std::unique_ptr<uint8_t[]> pUi8ReadData = readRawData(ui64OffsetCurrentMainDesc, ui32SizeDescriptor);
-				dumpHex(pUi8ReadData.get(), ui32SizeDescriptor, videoChainCurMainDesc.pMainDes->ui64OffsetCurrentMainDesc);
-				continue;
-			}
+		// Проверка номера камеры
+		if (ui8CameraNumber != pSecDesc->ui8CameraNumber) {
+			outAnomalies.record(AnomalyKind::ChainCameraMismatch, ui32IndexCurrentSecDesc, nullptr, ui32IndexCurrentMainDesc, 1, pSecDesc->ui8CameraNumber);
+		}
 
-			uint32_t ui32IndexCurrentSecDesc = iterMapSecDesc->second.ui32IndexCurrentSecDesc;
-			uint32_t ui32IndexPrevSecDesc = iterMapSecDesc->second.ui32IndexPrevSecDesc;
+		// Далее осуществляется добавление первого фрагмента, информация о котором находится в MainDesc
+		videoChainCurMainDesc.setSecSlot(0, pSecDesc->ui32IndexCurrentSecDesc);
+	}
+	else {
+		outAnomalies.record(AnomalyKind::ChainBadFirstIndex, ui32IndexCurrentMainDesc, nullptr, ui32IndexCurrentMainDesc, 1, ui32IndexNextSecDesc);
+		return false;
+	}
 
+	/*
+	* Цикл для создания цепочки фрагментов уже на основании информации из SecDesc те начиная со 2 SecDesc
+	*/
+	for (uint32_t ui32IterSecDesc = 2; ui32IterSecDesc <= ui16CountSecDesc; ui32IterSecDesc++) {
+		/*
+		* На основании предыдущего (уже добавленного в цепочку) SecDesc имеется значение 
+		* ui32IndexNextSecDesc о следующем значение те о 2
+		*/
+		WFSSecDescAdvInfo* pSecDesc = fnLookupSecDesc(ui32IndexNextSecDesc);
+		if (pSecDesc == nullptr) {
+			outAnomalies.record(AnomalyKind::ChainSecNotFound, ui32IndexNextSecDesc, nullptr, ui32IndexCurrentMainDesc, static_cast<uint16_t>(ui32IterSecDesc), ui16CountSecDesc);
+			break;
+		}
 
-			if (ui32IndexCurrentSecDesc != ui32IndexNextSecDesc) {
-				std::cout << "Warning: Descriptor mismatch at " << ui32IndexNextSecDesc << std::endl;
+		// Получение из уже добавленного SecDesc следующий SecDesc
+		ui32IndexNextSecDesc = pSecDesc->ui32IndexNextSecDesc;
 
-				std::unique_ptr<uint8_t[]> pUi8ReadData = readRawData(ui64OffsetCurrentMainDesc, ui32SizeDescriptor);
-				dumpHex(pUi8ReadData.get(), ui32SizeDescriptor, videoChainCurMainDesc.pMainDes->ui64OffsetCurrentMainDesc);
-				continue;
-			}
+		// Переход на следующий SecDesc
+		pSecDesc = fnLookupSecDesc(ui32IndexNextSecDesc);
+		if (pSecDesc == nullptr) {
+			outAnomalies.record(AnomalyKind::ChainSecNotFound, ui32IndexNextSecDesc, nullptr, ui32IndexCurrentMainDesc, static_cast<uint16_t>(ui32IterSecDesc), ui16CountSecDesc);
+			break;
+		}
+		uint32_t ui32IndexCurrentSecDesc = pSecDesc->ui32IndexCurrentSecDesc;
 
-			/*
-			* Можно проверить чему равен ui32IndexPrevSecDesc у первого вторичного дескриптора
-			* У первого SecDesc это будет номер MainDesc
-			*/
-			if (ui32IndexPrevSecDesc != ui32IndexCurrentMainDesc) {
-				std::cout << "Warning: the first SecDesc does not reference the MainDesc" << std::endl;
+		uint32_t ui32OrderNextSecDesc = pSecDesc->ui16RelativeIndexCurSecDesc;
+		if (ui32IterSecDesc != ui32OrderNextSecDesc) {
+			outAnomalies.record(AnomalyKind::ChainOrderMismatch, ui32IndexCurrentSecDesc, nullptr, ui32IndexCurrentMainDesc, static_cast<uint16_t>(ui32IterSecDesc), ui32OrderNextSecDesc);
+			continue;
+		}
 
-				std::unique_ptr<uint8_t[]> pUi8ReadData = readRawData(ui64OffsetCurrentMainDesc, ui32SizeDescriptor);
-				dumpHex(pUi8ReadData.get(), ui32SizeDescriptor, videoChainCurMainDesc.pMainDes->ui64OffsetCurrentMainDesc);
-				continue;
-			}
+		// Проверка номера камеры
+		if (ui8CameraNumber != pSecDesc->ui8CameraNumber) {
+			outAnomalies.record(AnomalyKind::ChainCameraMismatch, ui32IndexCurrentSecDesc, nullptr, ui32IndexCurrentMainDesc, static_cast<uint16_t>(ui32IterSecDesc), pSecDesc->ui8CameraNumber);
+		}
+		videoChainCurMainDesc.setSecSlot(static_cast<uint16_t>(ui32IterSecDesc - 1), pSecDesc->ui32IndexCurrentSecDesc);
+	}
+	return true;
+};
 
-			// Проверка номера камеры
-			if (ui8CameraNumber != iterMapSecDesc->second.ui8CameraNumber) {
-				std::cout << "Inconsistent camera numbers for recovery MainDesc " << std::endl;
-			}
+/**
+* \brief
+* Отмечает MainDesc и SecDesc построенной цепочки как добавленные (bIsAdd).
+**/
+void FileSystem_WFS::markChainAdded(FragmentChain& inFragmentChain) {
+	inFragmentChain.pMainDes->bIsAdd = true;
+	for (uint32_t ui32Slot : inFragmentChain.vecSecSlot) {
+		if (ui32Slot != FragmentChain::kUi32NoSlot) {
+			tableDesc.findSec(ui32Slot)->bIsAdd = true;
+		}
+	}
+};
 
-			// Далее осуществляется добавление первого фрагмента, информация о котором находится в MainDesc
-			iterMapSecDesc->second.bIsAdd = true;
-			videoChainCurMainDesc.pSecDes[0] = &iterMapSecDesc->second;
-			ui32CountAddSecDesc++;
+/**
+* \brief
+* Наполнение ассоциативного массива mapValidChains информацией MainDesc
+* и непрерывной цепочкой SecDesc.
+*
+* Цепочки строятся независимо друг от друга в ui32AnalysisThreads потоках с перераспределением
+* работы (WorkStealing), так как длина цепочек сильно различается. Построение только читает
+* tableDesc, а нарушения собираются в сборщик каждого потока. Затем сборщики объединяются
+* в sinkAnomalies и в порядке номеров MainDesc устанавливаются признаки bIsAdd. Последовательный обход не отклоняет
+* SecDesc, уже добавленный в другую цепочку, поэтому такой SecDesc входит в обе цепочки,
+* и результат совпадает с однопоточным построением.
+**/
+void FileSystem_WFS::rebuildUnwrittenVideoChain() {
+	std::vector<std::map<uint32_t, FragmentChain>::iterator> vecChains;
+	vecChains.reserve(mapValidChains.size());
+	for (auto iterFragChain = mapValidChains.begin(); iterFragChain != mapValidChains.end(); ++iterFragChain) {
+		vecChains.push_back(iterFragChain);
+	}
+	rebuildValidChains(vecChains, sinkAnomalies);
+}
+
+/**
+* \brief
+* Строит цепочки inVecChains (в порядке возрастания номеров MainDesc) в ui32AnalysisThreads
+* потоках, добавляет их нарушения в outAnomalies и отмечает построенные цепочки как добавленные.
+**/
+void FileSystem_WFS::rebuildValidChains(const std::vector<std::map<uint32_t, FragmentChain>::iterator>& inVecChains, AnomalySink& outAnomalies) {
+	uint32_t ui32CountChains = static_cast<uint32_t>(inVecChains.size());
+
+	uint32_t ui32Workers = std::max<uint32_t>(1, std::min(ui32AnalysisThreads, ui32CountChains / kUi32MinChainsPerThread));
+	std::vector<uint8_t> vecIsBuilt(ui32CountChains, 0);
+	std::vector<AnomalySink> vecSinks(ui32Workers, AnomalySink(outAnomalies.getSampleLimit()));	// Нарушения каждого рабочего потока
+
+	WorkStealing::run(ui32CountChains, ui32Workers, kUi32ChainGrain, [&](uint32_t ui32Worker, uint32_t ui32Chain) {
+		vecIsBuilt[ui32Chain] = rebuildValidChain(inVecChains[ui32Chain]->first, inVecChains[ui32Chain]->second, vecSinks[ui32Worker]) ? 1 : 0;
+	});
+
+	for (const AnomalySink& sinkWorker : vecSinks) {
+		outAnomalies.merge(sinkWorker);
+	}
+	for (uint32_t ui32Chain = 0; ui32Chain < ui32CountChains; ui32Chain++) {
+		if (vecIsBuilt[ui32Chain] != 0) {
+			markChainAdded(inVecChains[ui32Chain]->second);
+		}
+	}
+}
+
+/**
+* \brief
+* Обновляет mapValidChains после замены слотов inVecChangedSlots в таблице дескрипторов.
+* Цепочки добавляются и удаляются по изменившимся слотам MainDesc. Заново, с записью нарушений
+* в outAnomalies, строятся цепочки, обход которых читает изменившийся слот. Полная цепочка читает при обходе
+* только свои SecDesc; для неполной цепочки и цепочки, дополненной SecDesc вне цепочек
+* (rebuildOverwrittenVideoChain), прочитанные слоты определяются пробным обходом. Признаки
+* bIsAdd и bIsRecovered SecDesc сбрасываются и выставляются заново по цепочкам.
+*
+* \param
+* const std::vector<uint32_t>& inVecChangedSlots - изменившиеся слоты в порядке возрастания.
+*
+* \return
+* Количество перестроенных цепочек.
+**/
+uint32_t FileSystem_WFS::refreshValidChains(const std::vector<uint32_t>& inVecChangedSlots, AnomalySink& outAnomalies) {
+	auto fnIsChanged = [&inVecChangedSlots](uint32_t inUi32Slot) {
+		return std::binary_search(inVecChangedSlots.begin(), inVecChangedSlots.end(), inUi32Slot);
+	};
+
+	for (uint32_t ui32Slot : inVecChangedSlots) {
+		if (tableDesc.isMain(ui32Slot)) {
+			mapValidChains.emplace(ui32Slot, FragmentChain());
 		}
 		else {
-			std::cout << "In current MainDesc: " << ui32IndexCurrentMainDesc << std::endl;
-			std::cout << "\tSec Des not correct: " << ui32IndexNextSecDesc << std::endl;
+			mapValidChains.erase(ui32Slot);
+		}
+	}
 
-			std::unique_ptr<uint8_t[]> pUi8ReadData = readRawData(ui64OffsetCurrentMainDesc, ui32SizeDescriptor);
-			dumpHex(pUi8ReadData.get(), ui32SizeDescriptor, iterFragChain->second.pMainDes->ui64OffsetCurrentMainDesc);
-			continue;
+	// Записи таблицы могли переместиться, поэтому указатели на MainDesc назначаются заново
+	std::vector<std::map<uint32_t, FragmentChain>::iterator> vecChains;
+	std::vector<uint32_t> vecReadSlots;
+	AnomalySink sinkDiscard(0);
+	for (auto iterChain = mapValidChains.begin(); iterChain != mapValidChains.end(); ++iterChain) {
+		FragmentChain& videoChain = iterChain->second;
+		videoChain.pMainDes = tableDesc.findMain(iterChain->first);
+
+		bool bIsRebuilt = fnIsChanged(iterChain->first);
+		bool bHasRecovered = false;
+		for (size_t szPos = 0; !bIsRebuilt and szPos < videoChain.vecSecSlot.size(); szPos++) {
+			uint32_t ui32Slot = videoChain.vecSecSlot[szPos];
+			if (ui32Slot != FragmentChain::kUi32NoSlot) {
+				bIsRebuilt = fnIsChanged(ui32Slot);
+				bHasRecovered = bHasRecovered or tableDesc.findSec(ui32Slot)->bIsRecovered;
+			}
 		}
 
-		/*
-		* Цикл для создания цепочки фрагментов уже на основании информации из SecDesc те начиная со 2 SecDesc
-		*/
-		for (uint32_t ui32IterSecDesc = 2; ui32IterSecDesc <= ui16CountSecDesc; ui32IterSecDesc++) {
+		if (!bIsRebuilt and !videoChain.pMainDes->bIsAdd) {
+			// Обход не построенной цепочки читает только первый SecDesc
+			bIsRebuilt = fnIsChanged(videoChain.pMainDes->ui32IndexNextSecDesc);
+		}
+		else if (!bIsRebuilt and (bHasRecovered or videoChain.countSec() != videoChain.pMainDes->ui16CountSecDesc)) {
 			/*
-			* На основании предыдущего (уже добавленного в цепочку) SecDesc имеется значение 
-			* ui32IndexNextSecDesc о следующем значение те о 2
+			* Обход неполной цепочки мог прочитать слоты вне цепочки, а цепочку с SecDesc вне
+			* цепочек нужно вернуть к результату обхода. Пробный обход без записи нарушений находит
+			* прочитанные слоты: до первого изменившегося слота он совпадает с прежним обходом
 			*/
-			auto iterMapSecDesc = mapSecDesc.find(ui32IndexNextSecDesc);
-			if (iterMapSecDesc == mapSecDesc.end()) {
-				std::cout << "Warning: Secondary descriptor not found in Video Chain " << ui32IndexCurrentMainDesc << std::endl;
-				std::cout << "\tCurrent item " << ui32IterSecDesc << " in chain " << ui16CountSecDesc << std::endl;
-				std::cout << "\tIndex SecDesc: " << ui32IndexNextSecDesc << std::endl;
-				break;
+			FragmentChain chainCheck;
+			chainCheck.pMainDes = videoChain.pMainDes;
+			vecReadSlots.clear();
+			rebuildValidChain(iterChain->first, chainCheck, sinkDiscard, &vecReadSlots);
+			bIsRebuilt = std::any_of(vecReadSlots.begin(), vecReadSlots.end(), fnIsChanged);
+			if (!bIsRebuilt) {
+				videoChain.vecSecSlot = std::move(chainCheck.vecSecSlot);
 			}
+		}
 
-			// Получение из уже добавленного SecDesc следующий SecDesc
-			ui32IndexNextSecDesc = iterMapSecDesc->second.ui32IndexNextSecDesc;
-
-			// Переход на следующий SecDesc
-			iterMapSecDesc = mapSecDesc.find(ui32IndexNextSecDesc);
-			if (iterMapSecDesc == mapSecDesc.end()) {
-				std::cout << "Warning: Secondary descriptor not found in Video Chain " << ui32IndexCurrentMainDesc << std::endl;
-				std::cout << "\tCurrent item " << ui32IterSecDesc << " in chain " << ui16CountSecDesc << std::endl;
-				std::cout << "\tIndex SecDesc: " << ui32IndexNextSecDesc << std::endl;
-				break;
-			}
-			uint32_t ui32IndexCurrentSecDesc = iterMapSecDesc->second.ui32IndexCurrentSecDesc;
-
-			uint32_t ui32OrderNextSecDesc = iterMapSecDesc->second.ui16RelativeIndexCurSecDesc;
-			if (ui32IterSecDesc != ui32OrderNextSecDesc) {
-				uint32_t ui32ChainSecSize = videoChainCurMainDesc.pSecDes.size();
-				auto lastIt = std::prev(videoChainCurMainDesc.pSecDes.end());
-				uint32_t ui32NextSecDesc = lastIt->second->ui32IndexNextSecDesc;
-
-				std::cout << "Erase data:" << std::endl;
-				std::cout << "\tCurrent MainDesc: " << ui32IndexCurrentMainDesc << std::endl;
-				std::cout << "\tAmount all SecDesc from MainDesc: " << ui16CountSecDesc << std::endl;
-				std::cout << "\tCurrent SecDesc incorrect: " << ui32IterSecDesc << std::endl;
-				std::cout << "\tCurrent SecDesc from prev Sec: " << ui32OrderNextSecDesc << std::endl;
-				std::cout << "\tAmount SecDesc in chain: " << ui32ChainSecSize << std::endl;
-				std::cout << "\tNext SecDesc: " << ui32NextSecDesc << std::endl;
-				continue;
-			}
+		if (bIsRebuilt) {
+			videoChain.vecSecSlot.clear();
+			videoChain.pMainDes->bIsAdd = false;
+			vecChains.push_back(iterChain);
+		}
+	}
 
-			// Проверка номера камеры
-			if (ui8CameraNumber != iterMapSecDesc->second.ui8CameraNumber) {
-				std::cout << "Inconsistent camera numbers for recovery MainDesc " << std::endl;
-			}
-			iterMapSecDesc->second.bIsAdd = true;
-			videoChainCurMainDesc.pSecDes[ui32IterSecDesc - 1] = &iterMapSecDesc->second;
-			ui32CountAddSecDesc++;
+	for (WFSSecDescAdvInfo& stSecDesc : tableDesc.getSecRecords()) {
+		stSecDesc.bIsAdd = false;
+		stSecDesc.bIsRecovered = false;
+	}
+	for (auto& pairChain : mapValidChains) {
+		if (pairChain.second.pMainDes->bIsAdd) {
+			markChainAdded(pairChain.second);
 		}
-		videoChainCurMainDesc.pMainDes->bIsAdd = true;
 	}
-}
+	rebuildValidChains(vecChains, outAnomalies);
+	return static_cast<uint32_t>(vecChains.size());
+};
 
 /**
 * \brief
 * Дополнение mapValidChains невключенноми раннее SecDesc и наполнение 
-* mapIncompleteChains восстановленными MainDesc и оставшимися SecDesc
+* mapIncompleteChains восстановленными MainDesc и оставшимися SecDesc.
+*
+* SecDesc вне цепочек (bIsAdd == false) собираются в массив пар (ui32IndexMainDesc,
+* ui16RelativeIndexCurSecDesc), который сортируется поразрядно. Сортировка устойчива, поэтому
+* при совпадении позиции в цепочке остаётся SecDesc с наибольшим номером слота, как при обходе
+* в порядке слотов. Затем массив обходится один раз группами по ui32IndexMainDesc: группа
+* дополняет цепочку mapValidChains (обход mapValidChains идёт параллельно, без поиска) или
+* образует цепочку mapIncompleteChains, для которой в том же проходе проверяется номер камеры
+* и вычисляются границы времени.
+*
+* \param
+* AnomalySink& outAnomalies - сборщик нарушений (разные номера камер SecDesc одной цепочки).
 **/
-void FileSystem_WFS::rebuildOverwrittenVideoChain() {
-	uint32_t ui32SizeDescriptor = sizeof(WFSIndexAreaMainDesc);
-	uint32_t ui32AmountNotAdd = 0;
+void FileSystem_WFS::rebuildOverwrittenVideoChain(AnomalySink& outAnomalies) {
+	std::vector<WFSSecDescAdvInfo>& vecSecDesc = tableDesc.getSecRecords();
 
+	std::vector<OrphanSecDesc> vecOrphans;
+	for (WFSSecDescAdvInfo& stSecDesc : vecSecDesc) {
+		if (stSecDesc.bIsAdd == false) {
+			/*
+			* Скорее всего видеофрагмент уже переписан поэтому вторичный дескриптор который добавлен в цепочку стоит пометить
+			*/
+			stSecDesc.bIsAdd = true;
+			stSecDesc.bIsRecovered = true;
+			vecOrphans.push_back(OrphanSecDesc{ stSecDesc.ui32IndexMainDesc, stSecDesc.ui32IndexCurrentSecDesc, stSecDesc.ui16RelativeIndexCurSecDesc });
+		}
+	}
+	sortOrphanSecDesc(vecOrphans);
 
-	for (auto iterMapSecDesc = mapSecDesc.begin(); iterMapSecDesc != mapSecDesc.end(); ++iterMapSecDesc) {
-		WFSSecDescAdvInfo& iterSecDesc = iterMapSecDesc->second;
-		if (iterSecDesc.bIsAdd == false) {
-			ui32AmountNotAdd++;
-
-			uint32_t ui32IndexMainDesc = iterSecDesc.ui32IndexMainDesc;
+	/*
+	* На восстановленные MainDesc ссылаются цепочки, поэтому место под них (не более одного
+	* на группу SecDesc вне цепочек) резервируется заранее
+	*/
+	uint32_t ui32CountGroups = 0;
+	for (size_t szOrphan = 0; szOrphan < vecOrphans.size(); szOrphan++) {
+		if (szOrphan == 0 || vecOrphans[szOrphan].ui32IndexMainDesc != vecOrphans[szOrphan - 1].ui32IndexMainDesc) {
+			ui32CountGroups++;
+		}
+	}
+	tableDesc.reserveRecoveredMain(ui32CountGroups);
+
+	auto iterValidChain = mapValidChains.begin();
+	size_t szGroupBegin = 0;
+	while (szGroupBegin < vecOrphans.size()) {
+		uint32_t ui32IndexMainDesc = vecOrphans[szGroupBegin].ui32IndexMainDesc;
+		size_t szGroupEnd = szGroupBegin;
+		while (szGroupEnd < vecOrphans.size() && vecOrphans[szGroupEnd].ui32IndexMainDesc == ui32IndexMainDesc) {
+			szGroupEnd++;
+		}
 
-			auto iterFragmentChain = mapValidChains.find(ui32IndexMainDesc);
-			if (iterFragmentChain == mapValidChains.end()) {
-				auto itChain = mapIncompleteChains.find(ui32IndexMainDesc);
-				if (itChain == mapIncompleteChains.end() || itChain->second.pMainDes == nullptr) {
-					WFSMainDescAdvInfo stIndexAreaMainDesc{};
-					stIndexAreaMainDesc.ui16CountSecDesc++;
-					stIndexAreaMainDesc.ui32IndexCurrentMainDesc = ui32IndexMainDesc;
-					stIndexAreaMainDesc.ui64OffsetCurrentMainDesc = stWFSAllValue.ui64IndexAreaOffset + static_cast<uint64_t>(ui32IndexMainDesc) * static_cast<uint64_t>(ui32SizeDescriptor);
-					stIndexAreaMainDesc.bIsAdd = true;
+		while (iterValidChain != mapValidChains.end() && iterValidChain->first < ui32IndexMainDesc) {
+			++iterValidChain;
+		}
+		bool bIsValidChain = iterValidChain != mapValidChains.end() && iterValidChain->first == ui32IndexMainDesc;
 
-					mapMainDesc[ui32IndexMainDesc] = stIndexAreaMainDesc;
-					mapIncompleteChains[ui32IndexMainDesc].pMainDes = &mapMainDesc[ui32IndexMainDesc];
-				}
-				else {
-					mapMainDesc[ui32IndexMainDesc].ui16CountSecDesc++;
-				}
-				iterSecDesc.bIsAdd = true;
-				iterSecDesc.bIsRecovered = true;
-				mapIncompleteChains[ui32IndexMainDesc].pSecDes[iterSecDesc.ui16RelativeIndexCurSecDesc] = &iterMapSecDesc->second;
-				continue;
-			}
-			else {
-				iterSecDesc.bIsAdd = true;
-				/*
-				* Скорее всего видеофрагмент уже переписан поэтому вторичный дескриптор который добавлен в цепочку стоит пометить
-				*/
-				iterSecDesc.bIsRecovered = true;
-				iterFragmentChain->second.pSecDes[iterSecDesc.ui16RelativeIndexCurSecDesc] = &iterMapSecDesc->second;
-			}
+		FragmentChain* pFragmentChain = nullptr;
+		if (bIsValidChain) {
+			pFragmentChain = &iterValidChain->second;
+		}
+		else {
+			WFSMainDescAdvInfo stIndexAreaMainDesc{};
+			stIndexAreaMainDesc.ui16CountSecDesc = static_cast<uint16_t>(szGroupEnd - szGroupBegin);
+			stIndexAreaMainDesc.ui32IndexCurrentMainDesc = ui32IndexMainDesc;
+			stIndexAreaMainDesc.bIsAdd = true;
+
+			// Группы следуют в порядке возрастания номеров, поэтому цепочка добавляется в конец контейнера
+			pFragmentChain = &mapIncompleteChains.emplace_hint(mapIncompleteChains.end(), ui32IndexMainDesc, FragmentChain())->second;
+			pFragmentChain->pMainDes = tableDesc.addRecoveredMain(stIndexAreaMainDesc);
+			pFragmentChain->vecSecSlot.assign(static_cast<size_t>(vecOrphans[szGroupEnd - 1].ui16RelativeIndex) + 1, FragmentChain::kUi32NoSlot);
 		}
-	}
 
-	// Заполнение MainDesc в неполных цепочках
-	for (auto iterIncomFragChain = mapIncompleteChains.begin(); iterIncomFragChain != mapIncompleteChains.end(); ++iterIncomFragChain) {
-		auto chainSedDesc = iterIncomFragChain->second.pSecDes;
 		uint8_t ui8CameraNumber = 0;
 		bool isFirst = true;
 		bool isConsistentCameraNumber = true;
 
-		WFSDateTime stMinStartDate = { 9999, 99, 99, 99, 99, 99 };
-		WFSDateTime stMaxEndDate = { 0, 0, 0, 0, 0, 0 };
+		// Упакованные метки сравниваются как числа
+		uint32_t ui32MinStartTime = UINT32_MAX;
+		uint32_t ui32MaxEndTime = 0;
 
-		for (auto iterSecDesc = chainSedDesc.begin(); iterSecDesc != chainSedDesc.end(); ++iterSecDesc) {
-			WFSSecDescAdvInfo* pSecDesc = iterSecDesc->second;
-			if (pSecDesc == nullptr) {
+		for (size_t szOrphan = szGroupBegin; szOrphan < szGroupEnd; szOrphan++) {
+			// Из SecDesc с одинаковой позицией в цепочке остаётся последний
+			if (szOrphan + 1 < szGroupEnd && vecOrphans[szOrphan + 1].ui16RelativeIndex == vecOrphans[szOrphan].ui16RelativeIndex) {
 				continue;
 			}
+			const OrphanSecDesc& stOrphan = vecOrphans[szOrphan];
+			pFragmentChain->setSecSlot(stOrphan.ui16RelativeIndex, stOrphan.ui32Slot);
+			if (bIsValidChain) {
+				continue;
+			}
+
+			const WFSSecDescAdvInfo* pSecDesc = tableDesc.findSec(stOrphan.ui32Slot);
 			if (isFirst) {
 				ui8CameraNumber = pSecDesc->ui8CameraNumber;
 				isFirst = false;
 			}
 			else if (pSecDesc->ui8CameraNumber != ui8CameraNumber) {
 				isConsistentCameraNumber = false;
-				break;
 			}
-			if (pSecDesc->stTimeStampStartVideoSegment.CompareTo(stMinStartDate) < 0) {
-				stMinStartDate = pSecDesc->stTimeStampStartVideoSegment;
+			ui32MinStartTime = std::min(ui32MinStartTime, pSecDesc->ui32TimeStampStartVideoSegment);
+			ui32MaxEndTime = std::max(ui32MaxEndTime, pSecDesc->ui32TimeStampEndVideoSegment);
+		}
+
+		// Заполнение MainDesc неполной цепочки
+		if (!bIsValidChain) {
+			if (isConsistentCameraNumber) {
+				pFragmentChain->pMainDes->ui8CameraNumber = ui8CameraNumber;
+				pFragmentChain->pMainDes->ui32TimeStampStartVideoStream = ui32MinStartTime;
+				pFragmentChain->pMainDes->ui32TimeStampEndVideoStream = ui32MaxEndTime;
 			}
-			if (pSecDesc->stTimeStampEndVideoSegment.CompareTo(stMaxEndDate) > 0) {
-				stMaxEndDate = pSecDesc->stTimeStampEndVideoSegment;
+			else {
+				outAnomalies.record(AnomalyKind::RecoveredCameraMismatch, ui32IndexMainDesc, nullptr, ui32IndexMainDesc);
 			}
 		}
+		szGroupBegin = szGroupEnd;
+	}
+}
 
-		if (isConsistentCameraNumber && iterIncomFragChain->second.pMainDes!= nullptr) {
-			iterIncomFragChain->second.pMainDes->ui8CameraNumber = ui8CameraNumber;
-			iterIncomFragChain->second.pMainDes->stTimeStampStartVideoStream = stMinStartDate;
-			iterIncomFragChain->second.pMainDes->stTimeStampEndVideoStream = stMaxEndDate;
+/**
+* \brief
+* Устойчивая поразрядная сортировка SecDesc вне цепочек по (ui32IndexMainDesc,
+* ui16RelativeIndex): три прохода по 16 бит, начиная с младших. Записи с одинаковым
+* ключом сохраняют исходный порядок (порядок слотов).
+**/
+void FileSystem_WFS::sortOrphanSecDesc(std::vector<OrphanSecDesc>& inVecOrphans) {
+	static constexpr uint32_t kUi32Buckets = 0x10000;
+	auto fnDigit = [](const OrphanSecDesc& inStOrphan, uint32_t inUi32Pass) -> uint32_t {
+		if (inUi32Pass == 0) {
+			return inStOrphan.ui16RelativeIndex;
 		}
-		else {
-			std::cout << "Inconsistent camera numbers for recovery MainDesc " << std::endl;
+		return (inStOrphan.ui32IndexMainDesc >> ((inUi32Pass - 1) * 16)) & 0xFFFF;
+	};
+
+	std::vector<OrphanSecDesc> vecBuffer(inVecOrphans.size());
+	std::vector<uint32_t> vecPositions(kUi32Buckets);
+	for (uint32_t ui32Pass = 0; ui32Pass < 3; ui32Pass++) {
+		std::fill(vecPositions.begin(), vecPositions.end(), 0);
+		for (const OrphanSecDesc& stOrphan : inVecOrphans) {
+			vecPositions[fnDigit(stOrphan, ui32Pass)]++;
+		}
+		// Проход пропускается, если у всех записей одинаковый разряд
+		if (inVecOrphans.empty() || vecPositions[fnDigit(inVecOrphans[0], ui32Pass)] == inVecOrphans.size()) {
+			continue;
+		}
+		uint32_t ui32Position = 0;
+		for (uint32_t& ui32Bucket : vecPositions) {
+			uint32_t ui32Count = ui32Bucket;
+			ui32Bucket = ui32Position;
+			ui32Position += ui32Count;
+		}
+		for (const OrphanSecDesc& stOrphan : inVecOrphans) {
+			vecBuffer[vecPositions[fnDigit(stOrphan, ui32Pass)]++] = stOrphan;
+		}
+		inVecOrphans.swap(vecBuffer);
+	}
+}
+
+/**
+* \brief
+* Восстановление последовательностей SecDesc по ссылкам ui32IndexPrevSecDesc/ui32IndexNextSecDesc.
+*
+* Группировка по ui32IndexMainDesc (rebuildOverwrittenVideoChain) не объединяет SecDesc с
+* повреждённым номером MainDesc или позицией в цепочке. Здесь граф ссылок строится по всем
+* SecDesc за один проход в порядке слотов. Ребро a -> b добавляется, если ссылки согласованы:
+*
+* - прямое: a.ui32IndexNextSecDesc == b и b.ui32IndexPrevSecDesc == a;
+*
+* - через пропуск: a и b ссылаются на один и тот же слот X (a.next == b.prev == X), в котором
+* больше нет SecDesc, связанного с b (дескриптор перезаписан), b следует через позицию после a,
+* номера камер совпадают и b начинается не раньше окончания a.
+*
+* У каждого SecDesc не более одного следующего и одного предыдущего; ребро, замыкающее
+* цикл, определяется системой непересекающихся множеств и отбрасывается. Поэтому каждая
+* компонента - упорядоченная последовательность, которая обходится от начала. В vecLinkedRuns
+* попадают последовательности, содержащие SecDesc вне цепочек MainDesc (bIsRecovered) и
+* объединяющие то, что группировка по номеру MainDesc разделяет: SecDesc с разными номерами
+* MainDesc или с позицией в цепочке, не соответствующей позиции в последовательности.
+**/
+void FileSystem_WFS::rebuildLinkedRuns() {
+	static constexpr uint32_t kUi32None = 0xFFFFFFFF;
+	static constexpr uint32_t kUi32Conflict = 0xFFFFFFFE;
+
+	std::vector<WFSSecDescAdvInfo>& vecSecDesc = tableDesc.getSecRecords();
+	uint32_t ui32CountSec = static_cast<uint32_t>(vecSecDesc.size());
+	uint32_t ui32SlotCount = tableDesc.getSlotCount();
+	vecLinkedRuns.clear();
+	vecLinkedRunMainDesc.clear();
+
+	auto fnRecord = [&](const WFSSecDescAdvInfo* inPSecDesc) -> uint32_t {
+		return static_cast<uint32_t>(inPSecDesc - vecSecDesc.data());
+	};
+
+	/*
+	* Для слота X, в котором нет SecDesc, ссылающегося на b, запоминается b (b.prev == X).
+	* Если на X ссылаются несколько SecDesc, пропуск неоднозначен и не используется
+	*/
+	std::vector<uint32_t> vecGapNext(ui32SlotCount, kUi32None);
+	for (uint32_t ui32Record = 0; ui32Record < ui32CountSec; ui32Record++) {
+		const WFSSecDescAdvInfo& stSecDesc = vecSecDesc[ui32Record];
+		uint32_t ui32Prev = stSecDesc.ui32IndexPrevSecDesc;
+		if (ui32Prev >= ui32SlotCount) {
+			continue;
 		}
+		const WFSSecDescAdvInfo* pPrevSecDesc = tableDesc.findSec(ui32Prev);
+		if (pPrevSecDesc != nullptr && pPrevSecDesc->ui32IndexNextSecDesc == stSecDesc.ui32IndexCurrentSecDesc) {
+			continue;
+		}
+		vecGapNext[ui32Prev] = (vecGapNext[ui32Prev] == kUi32None) ? ui32Record : kUi32Conflict;
+	}
+
+	std::vector<uint32_t> vecNext(ui32CountSec, kUi32None);
+	std::vector<uint32_t> vecPrev(ui32CountSec, kUi32None);
+	std::vector<uint8_t> vecIsGapAfter(ui32CountSec, 0);
+	std::vector<uint32_t> vecParent(ui32CountSec);
+	for (uint32_t ui32Record = 0; ui32Record < ui32CountSec; ui32Record++) {
+		vecParent[ui32Record] = ui32Record;
 	}
+	auto fnFind = [&](uint32_t inUi32Record) {
+		while (vecParent[inUi32Record] != inUi32Record) {
+			vecParent[inUi32Record] = vecParent[vecParent[inUi32Record]];
+			inUi32Record = vecParent[inUi32Record];
+		}
+		return inUi32Record;
+	};
 
-	ui32AmountNotAdd = 0;
-	for (auto iterMapSecDesc = mapSecDesc.begin(); iterMapSecDesc != mapSecDesc.end(); ++iterMapSecDesc) {
-		WFSSecDescAdvInfo iterSecDesc = iterMapSecDesc->second;
-		if (iterSecDesc.bIsAdd == false) {
-			ui32AmountNotAdd++;
+	for (uint32_t ui32Record = 0; ui32Record < ui32CountSec; ui32Record++) {
+		const WFSSecDescAdvInfo& stSecDesc = vecSecDesc[ui32Record];
+		uint32_t ui32NextSlot = stSecDesc.ui32IndexNextSecDesc;
+		if (ui32NextSlot >= ui32SlotCount) {
+			continue;
+		}
+
+		uint32_t ui32NextRecord = kUi32None;
+		bool bIsGap = false;
+		const WFSSecDescAdvInfo* pNextSecDesc = tableDesc.findSec(ui32NextSlot);
+		if (pNextSecDesc != nullptr && pNextSecDesc->ui32IndexPrevSecDesc == stSecDesc.ui32IndexCurrentSecDesc) {
+			ui32NextRecord = fnRecord(pNextSecDesc);
+		}
+		else if (vecGapNext[ui32NextSlot] < kUi32Conflict) {
+			const WFSSecDescAdvInfo& stGapSecDesc = vecSecDesc[vecGapNext[ui32NextSlot]];
+			if (stGapSecDesc.ui16RelativeIndexCurSecDesc == stSecDesc.ui16RelativeIndexCurSecDesc + 2 and
+				stGapSecDesc.ui8CameraNumber == stSecDesc.ui8CameraNumber and
+				stGapSecDesc.ui32TimeStampStartVideoSegment >= stSecDesc.ui32TimeStampEndVideoSegment) {
+				ui32NextRecord = vecGapNext[ui32NextSlot];
+				bIsGap = true;
+			}
 		}
+		if (ui32NextRecord == kUi32None or vecPrev[ui32NextRecord] != kUi32None) {
+			continue;
+		}
+
+		uint32_t ui32Root = fnFind(ui32Record);
+		uint32_t ui32NextRoot = fnFind(ui32NextRecord);
+		if (ui32Root == ui32NextRoot) {
+			continue;
+		}
+		vecParent[ui32NextRoot] = ui32Root;
+		vecNext[ui32Record] = ui32NextRecord;
+		vecPrev[ui32NextRecord] = ui32Record;
+		vecIsGapAfter[ui32Record] = bIsGap ? 1 : 0;
 	}
 
-	if (ui32AmountNotAdd != 0) {
-		std::cout << "Amount SecDesc wich not add: " << ui32AmountNotAdd << std::endl;
+	// Обход последовательностей от начала; позиции пропусков остаются пустыми
+	uint32_t ui32CountRunSec = 0;
+	uint32_t ui32MaxRunSize = 0;
+	std::vector<uint32_t> vecRunSlots;
+	for (uint32_t ui32Head = 0; ui32Head < ui32CountSec; ui32Head++) {
+		if (vecPrev[ui32Head] != kUi32None or vecNext[ui32Head] == kUi32None) {
+			continue;
+		}
+
+		bool bIsRecovered = false;
+		bool bIsRegrouped = false;
+		vecRunSlots.clear();
+		for (uint32_t ui32Record = ui32Head; ui32Record != kUi32None; ui32Record = vecNext[ui32Record]) {
+			const WFSSecDescAdvInfo& stSecDesc = vecSecDesc[ui32Record];
+			const WFSSecDescAdvInfo& stHeadSecDesc = vecSecDesc[ui32Head];
+			bIsRecovered = bIsRecovered or stSecDesc.bIsRecovered;
+			if (stSecDesc.ui32IndexMainDesc != stHeadSecDesc.ui32IndexMainDesc or
+				stSecDesc.ui16RelativeIndexCurSecDesc != stHeadSecDesc.ui16RelativeIndexCurSecDesc + vecRunSlots.size()) {
+				bIsRegrouped = true;
+			}
+			vecRunSlots.push_back(stSecDesc.ui32IndexCurrentSecDesc);
+			if (vecIsGapAfter[ui32Record] != 0) {
+				vecRunSlots.push_back(FragmentChain::kUi32NoSlot);
+			}
+		}
+		if (!bIsRecovered or !bIsRegrouped) {
+			continue;
+		}
+
+		// Позиция в цепочке хранится в uint16_t, поэтому длинная последовательность делится на части
+		for (size_t szBegin = 0; szBegin < vecRunSlots.size(); szBegin += 0xFFFF) {
+			size_t szEnd = std::min(vecRunSlots.size(), szBegin + 0xFFFF);
+			FragmentChain stRun;
+			stRun.vecSecSlot.assign(vecRunSlots.begin() + szBegin, vecRunSlots.begin() + szEnd);
+			vecLinkedRuns.push_back(std::move(stRun));
+		}
+		ui32CountRunSec += static_cast<uint32_t>(vecRunSlots.size() - std::count(vecRunSlots.begin(), vecRunSlots.end(), FragmentChain::kUi32NoSlot));
+		ui32MaxRunSize = std::max(ui32MaxRunSize, static_cast<uint32_t>(vecRunSlots.size()));
 	}
+
+	/*
+	* MainDesc последовательности описывает её как восстановленную цепочку: номер MainDesc
+	* берётся из первого SecDesc, время - по крайним SecDesc, камера - по первому SecDesc.
+	* Записи создаются после заполнения vecLinkedRuns, поэтому указатели на них не меняются
+	*/
+	vecLinkedRunMainDesc.resize(vecLinkedRuns.size());
+	for (size_t szRun = 0; szRun < vecLinkedRuns.size(); szRun++) {
+		FragmentChain& stRun = vecLinkedRuns[szRun];
+		auto iterFirst = std::find_if(stRun.vecSecSlot.begin(), stRun.vecSecSlot.end(), [](uint32_t inUi32Slot) { return inUi32Slot != FragmentChain::kUi32NoSlot; });
+		auto iterLast = std::find_if(stRun.vecSecSlot.rbegin(), stRun.vecSecSlot.rend(), [](uint32_t inUi32Slot) { return inUi32Slot != FragmentChain::kUi32NoSlot; });
+		const WFSSecDescAdvInfo* pFirstSecDesc = tableDesc.findSec(*iterFirst);
+		const WFSSecDescAdvInfo* pLastSecDesc = tableDesc.findSec(*iterLast);
+		WFSMainDescAdvInfo& stMainDesc = vecLinkedRunMainDesc[szRun];
+		stMainDesc.ui16CountSecDesc = static_cast<uint16_t>(stRun.vecSecSlot.size());
+		stMainDesc.ui32IndexCurrentMainDesc = pFirstSecDesc->ui32IndexMainDesc;
+		stMainDesc.ui32TimeStampStartVideoStream = pFirstSecDesc->ui32TimeStampStartVideoSegment;
+		stMainDesc.ui32TimeStampEndVideoStream = pLastSecDesc->ui32TimeStampEndVideoSegment;
+		stMainDesc.ui8CameraNumber = pFirstSecDesc->ui8CameraNumber;
+		stMainDesc.bIsAdd = true;
+		stRun.pMainDes = &stMainDesc;
+	}
+
+	std::cout << "Восстановлено последовательностей по ссылкам SecDesc: " << vecLinkedRuns.size()
+		<< " (SecDesc: " << ui32CountRunSec << ", наибольшая длина: " << ui32MaxRunSize << ")" << std::endl;
 }
 
+/**
+* \brief
+* Вычисляет ключ образа для файла индекса: хэш заголовка WFS, SuperBlock (содержит позиции
+* записи и метки времени, меняющиеся при каждой записи оборудованием), размера и времени
+* изменения образа, а также размеров записей, сохраняемых в файле индекса.
+*
+* \return
+* Ключ образа.
+**/
+uint64_t FileSystem_WFS::computeIndexKey() {
+	std::unique_ptr<uint8_t[]> pUi8Header = readRawData(0, sizeof(WFSHeader));
+	std::unique_ptr<uint8_t[]> pUi8SuperBlock = readRawData(0x3000, sizeof(WFSSuperBlock));
+	uint64_t arrUi64Image[] = {
+		inputFile_->getSize(),
+		inputFile_->getModificationTime(),
+		sizeof(WFSAllValue),
+		sizeof(WFSMainDescAdvInfo),
+		sizeof(WFSSecDescAdvInfo)
+	};
+
+	uint64_t ui64Key = IndexCache::hash(pUi8Header.get(), sizeof(WFSHeader));
+	ui64Key = IndexCache::hash(pUi8SuperBlock.get(), sizeof(WFSSuperBlock), ui64Key);
+	return IndexCache::hash(arrUi64Image, sizeof(arrUi64Image), ui64Key);
+};
+
+/**
+* \brief
+* Загружает результаты разбора из файла индекса strIndexCachePath: таблицу дескрипторов,
+* счётчики дескрипторов и все цепочки. Массивы копируются из отображённого в память файла
+* целиком, разбор IndexArea и построение цепочек не выполняются.
+*
+* \return
+* true, если файл индекса соответствует образу и загружен; иначе состояние не меняется.
+**/
+bool FileSystem_WFS::loadIndexCache() {
+	IndexCacheReader reader;
+	if (!reader.open(strIndexCachePath, computeIndexKey())) {
+		return false;
+	}
+
+	WFSAllValue stLoadedAllValue;
+	ByteView stAllValue = reader.section(kUi32SectionAllValue);
+	if (stAllValue.ui64Size != sizeof(WFSAllValue)) {
+		return false;
+	}
+	std::memcpy(&stLoadedAllValue, stAllValue.pData, sizeof(WFSAllValue));
+
+	if (!tableDesc.load(reader) || tableDesc.getSlotCount() != stWFSAllValue.ui32CountAllVideoFragments || !loadIndexCacheChains(reader) ||
+		!sinkAnomalies.load(reader, kUi32SectionAnomalies)) {
+		tableDesc.reset(0);
+		sinkAnomalies.clear();
+		mapValidChains.clear();
+		mapIncompleteChains.clear();
+		vecLinkedRuns.clear();
+		vecLinkedRunMainDesc.clear();
+		return false;
+	}
+	stWFSAllValue = stLoadedAllValue;
+	return true;
+};
+
+/**
+* \brief
+* Восстанавливает цепочки из файла индекса. Указатели на MainDesc назначаются заново: для
+* mapValidChains - записи tableDesc, для mapIncompleteChains - восстановленные MainDesc
+* (они созданы в порядке ключей цепочек), для vecLinkedRuns - vecLinkedRunMainDesc.
+* Каждая позиция цепочки должна указывать на SecDesc таблицы.
+*
+* \return
+* true, если все цепочки согласованы с таблицей дескрипторов.
+**/
+bool FileSystem_WFS::loadIndexCacheChains(const IndexCacheReader& inReader) {
+	PackedChains stValid;
+	PackedChains stIncomplete;
+	PackedChains stRuns;
+	if (!stValid.load(inReader, kUi32SectionValidChains) ||
+		!stIncomplete.load(inReader, kUi32SectionIncompleteChains) ||
+		!stRuns.load(inReader, kUi32SectionLinkedRuns) ||
+		!inReader.readArray(kUi32SectionLinkedRunMainDesc, vecLinkedRunMainDesc)) {
+		return false;
+	}
+	std::vector<WFSMainDescAdvInfo>& vecRecoveredMain = tableDesc.getRecoveredMainRecords();
+	if (stIncomplete.vecKeys.size() != vecRecoveredMain.size() || stRuns.vecKeys.size() != vecLinkedRunMainDesc.size()) {
+		return false;
+	}
+
+	// Позиции цепочки копируются из плоского массива с проверкой ссылок на SecDesc
+	auto fnUnpack = [this](const PackedChains& inPacked, size_t inSzChain, size_t& ioSzSlot, FragmentChain& outFragmentChain) {
+		auto iterBegin = inPacked.vecSlots.begin() + ioSzSlot;
+		ioSzSlot += inPacked.vecSizes[inSzChain];
+		outFragmentChain.vecSecSlot.assign(iterBegin, inPacked.vecSlots.begin() + ioSzSlot);
+		for (uint32_t ui32Slot : outFragmentChain.vecSecSlot) {
+			if (ui32Slot != FragmentChain::kUi32NoSlot && tableDesc.findSec(ui32Slot) == nullptr) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	size_t szSlot = 0;
+	for (size_t szChain = 0; szChain < stValid.vecKeys.size(); szChain++) {
+		FragmentChain& videoChain = mapValidChains.emplace_hint(mapValidChains.end(), stValid.vecKeys[szChain], FragmentChain())->second;
+		videoChain.pMainDes = tableDesc.findMain(stValid.vecKeys[szChain]);
+		if (videoChain.pMainDes == nullptr || !fnUnpack(stValid, szChain, szSlot, videoChain)) {
+			return false;
+		}
+	}
+
+	szSlot = 0;
+	for (size_t szChain = 0; szChain < stIncomplete.vecKeys.size(); szChain++) {
+		FragmentChain& videoChain = mapIncompleteChains.emplace_hint(mapIncompleteChains.end(), stIncomplete.vecKeys[szChain], FragmentChain())->second;
+		videoChain.pMainDes = &vecRecoveredMain[szChain];
+		if (!fnUnpack(stIncomplete, szChain, szSlot, videoChain)) {
+			return false;
+		}
+	}
+
+	szSlot = 0;
+	vecLinkedRuns.resize(stRuns.vecKeys.size());
+	for (size_t szRun = 0; szRun < vecLinkedRuns.size(); szRun++) {
+		vecLinkedRuns[szRun].pMainDes = &vecLinkedRunMainDesc[szRun];
+		if (!fnUnpack(stRuns, szRun, szSlot, vecLinkedRuns[szRun])) {
+			return false;
+		}
+	}
+	return true;
+};
+
+/**
+* \brief
+* Записывает результаты разбора в файл индекса strIndexCachePath. Ошибка записи не прерывает
+* работу: выводится предупреждение, и при следующем запуске выполняется полный разбор.
+**/
+void FileSystem_WFS::saveIndexCache() {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	PackedChains stValid;
+	PackedChains stIncomplete;
+	PackedChains stRuns;
+	for (const auto& pairChain : mapValidChains) {
+		stValid.add(pairChain.first, pairChain.second);
+	}
+	for (const auto& pairChain : mapIncompleteChains) {
+		stIncomplete.add(pairChain.first, pairChain.second);
+	}
+	for (size_t szRun = 0; szRun < vecLinkedRuns.size(); szRun++) {
+		stRuns.add(static_cast<uint32_t>(szRun), vecLinkedRuns[szRun]);
+	}
+
+	IndexCacheWriter writer;
+	writer.addSection(kUi32SectionAllValue, &stWFSAllValue, sizeof(WFSAllValue));
+	tableDesc.save(writer);
+	stValid.save(writer, kUi32SectionValidChains);
+	stIncomplete.save(writer, kUi32SectionIncompleteChains);
+	stRuns.save(writer, kUi32SectionLinkedRuns);
+	writer.addArray(kUi32SectionLinkedRunMainDesc, vecLinkedRunMainDesc);
+	sinkAnomalies.save(writer, kUi32SectionAnomalies);
+
+	if (!writer.write(strIndexCachePath, computeIndexKey())) {
+		std::cout << "Не удалось записать файл индекса " << strIndexCachePath << std::endl;
+		return;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Индекс сохранён в файл " << strIndexCachePath << std::endl;
+	std::cout << "Время сохранения индекса: " << elapsed.count() << " секунд" << std::endl;
+};
+
+void FileSystem_WFS::PackedChains::add(uint32_t inUi32Key, const FragmentChain& inFragmentChain) {
+	vecKeys.push_back(inUi32Key);
+	vecSizes.push_back(static_cast<uint32_t>(inFragmentChain.vecSecSlot.size()));
+	vecSlots.insert(vecSlots.end(), inFragmentChain.vecSecSlot.begin(), inFragmentChain.vecSecSlot.end());
+};
+
+void FileSystem_WFS::PackedChains::save(IndexCacheWriter& inWriter, uint32_t inUi32FirstSection) const {
+	inWriter.addArray(inUi32FirstSection, vecKeys);
+	inWriter.addArray(inUi32FirstSection + 1, vecSizes);
+	inWriter.addArray(inUi32FirstSection + 2, vecSlots);
+};
+
+/**
+* \brief
+* Читает три раздела цепочек, начиная с inUi32FirstSection.
+*
+* \return
+* true, если разделы есть и сумма размеров цепочек равна количеству позиций.
+**/
+bool FileSystem_WFS::PackedChains::load(const IndexCacheReader& inReader, uint32_t inUi32FirstSection) {
+	if (!inReader.readArray(inUi32FirstSection, vecKeys) ||
+		!inReader.readArray(inUi32FirstSection + 1, vecSizes) ||
+		!inReader.readArray(inUi32FirstSection + 2, vecSlots) ||
+		vecKeys.size() != vecSizes.size()) {
+		return false;
+	}
+	uint64_t ui64CountSlots = 0;
+	for (uint32_t ui32Size : vecSizes) {
+		ui64CountSlots += ui32Size;
+	}
+	return ui64CountSlots == vecSlots.size();
+};
+
 /**
 * \brief
 * Проверяет, является ли дескриптор Main.
 *
 * \param
-* uint32_t inUi32IndexDesc - индекс проверяемого дескриптора.
+* const DescTraits& inStTraits - признаки дескриптора, вычисленные DescClassifier.
 *
-* uint32_t inUi32SizeDescVideoFragment - размер дескриптора.
-* 
-* const void* inPoitCurrentPosition - указатель на начало области проверяемого дескриптора.
+* AnomalyKind& outEKind - причина отклонения дескриптора.
 *
 * \return
 * Возвращает true, если проверяемый дескриптор является Main, иначе — false.
 **/
-bool FileSystem_WFS::isLikelyMainDesc(uint32_t inUi32IndexDesc, uint32_t inUi32SizeDescVideoFragment, const void* inPoitCurrentPosition) {
+bool FileSystem_WFS::isLikelyMainDesc(const DescTraits& inStTraits, AnomalyKind& outEKind) {
 	/*
 	* Далее реализована некоторая логика по определению является обрабатываемые 32 байта
 	* дескриптором видеофрагмента. Для этого предложена логика по подсчету нулевых элементов.
@@ -744,53 +1945,31 @@ bool FileSystem_WFS::isLikelyMainDesc(uint32_t inUi32IndexDesc, uint32_t inUi32S
 		max zero - 22
 		min not zero - 10
 	*/
-	uint32_t ui32CountZeroValue = 0;
-	uint32_t ui32CountNotZeroValue = 0;
-	for (uint32_t ui32ChildrenCycleIteration = 0; ui32ChildrenCycleIteration < inUi32SizeDescVideoFragment; ui32ChildrenCycleIteration++) {
-		uint8_t ui8ValueByte;
-
-		ui8ValueByte = *reinterpret_cast<uint8_t*>(reinterpret_cast<uint64_t>(inPoitCurrentPosition) + ui32ChildrenCycleIteration);
-		if (ui8ValueByte == 0) {
-			ui32CountZeroValue++;
-		}
-		else {
-			ui32CountNotZeroValue++;
-		}
-	}
-	if ((ui32CountNotZeroValue >= 10) and (ui32CountZeroValue <= 22) and (ui32CountNotZeroValue + ui32CountZeroValue) == inUi32SizeDescVideoFragment) {
-		WFSIndexAreaMainDesc* stWFSIndexAreaMainDesc = (WFSIndexAreaMainDesc*)inPoitCurrentPosition;
-
-		if (inUi32IndexDesc != stWFSIndexAreaMainDesc->ui32IndexCurrentMainDesc) {
-			std::cout << "FileSystem_WFS::isLikelyMainDesc() - Current MainDescriptor video fragment not same ui32IndexCurrentMainDesc" << std::endl;
-			std::cout << "\tCurrent MainDescriptor video fragment - " << inUi32IndexDesc << std::endl;
-			std::cout << "\tMainDescriptor video fragment from struct - " << stWFSIndexAreaMainDesc->ui32IndexCurrentMainDesc << std::endl;
+	uint32_t ui32CountZeroValue = inStTraits.ui8ZeroCount;
+	uint32_t ui32CountNotZeroValue = DescClassifier::kUi32DescSize - ui32CountZeroValue;
+	if ((ui32CountNotZeroValue >= 10) and (ui32CountZeroValue <= 22)) {
+		if (!(inStTraits.ui8Flags & DescClassifier::kUi8DescIndexMatch)) {
+			outEKind = AnomalyKind::MainDescIndexMismatch;
 			return false;
 		}
 
-		WFSDateTime startVideoStream = convertTime(stWFSIndexAreaMainDesc->ui32TimeStampStartVideoStream);
-		if (!isValidDateTime(startVideoStream)) {
-			std::cout << "FileSystem_WFS::isLikelyMainDesc() - Current MainDescriptor video fragment not have correct time Start video stream" << std::endl;
-			std::cout << "\tError date time - ";
-			printWFSDateTime(startVideoStream);
-			std::cout << std::endl;
+		if (!(inStTraits.ui8Flags & DescClassifier::kUi8DescStartTimeValid)) {
+			outEKind = AnomalyKind::MainDescBadStartTime;
 			return false;
 		}
 
-		WFSDateTime endVideoStream = convertTime(stWFSIndexAreaMainDesc->ui32TimeStampEndVideoStream);
-		if (!isValidDateTime(endVideoStream)) {
-			std::cout << "FileSystem_WFS::isLikelyMainDesc() - Current MainDescriptor video fragment not have correct time End video stream" << std::endl;
-			std::cout << "\tError date time - ";
-			printWFSDateTime(endVideoStream);
-			std::cout << std::endl;
+		if (!(inStTraits.ui8Flags & DescClassifier::kUi8DescEndTimeValid)) {
+			outEKind = AnomalyKind::MainDescBadEndTime;
 			return false;
 		}
 
-		if (stWFSIndexAreaMainDesc->ui32IndexPrevSecDesc != 0) {
-			std::cout << "FileSystem_WFS::isLikelyMainDesc() - Current MainDescriptor video fragment not have correct ui32IndexPrevSecDesc" << std::endl;
+		if (!(inStTraits.ui8Flags & DescClassifier::kUi8DescPrevZero)) {
+			outEKind = AnomalyKind::MainDescBadPrev;
 			return false;
 		}
 		return true;
 	}
+	outEKind = AnomalyKind::MainDescRejected;
 	return false;
 }
 
@@ -799,14 +1978,14 @@ bool FileSystem_WFS::isLikelyMainDesc(uint32_t inUi32IndexDesc, uint32_t inUi32S
 * Проверяет, является ли дескриптор Desc.
 *
 * \param
-* uint32_t inUi32SizeDescVideoFragment - размер дескриптора.
+* const DescTraits& inStTraits - признаки дескриптора, вычисленные DescClassifier.
 *
-* const void* inPoitCurrentPosition - указатель на начало области проверяемого дескриптора.
+* AnomalyKind& outEKind - причина отклонения дескриптора.
 *
 * \return
 * Возвращает true, если проверяемый дескриптор является Desc, иначе — false.
 **/
-bool FileSystem_WFS::isLikelySecDesc(uint32_t inUi32SizeDescVideoFragment, const void* inPoitCurrentPosition) {
+bool FileSystem_WFS::isLikelySecDesc(const DescTraits& inStTraits, AnomalyKind& outEKind) {
 	/*
 	* Далее реализована некоторая логика по определению является обрабатываемые 32 байта
 	* дескриптором видеофрагмента. Для этого предложена логика по подсчету нулевых элементов.
@@ -832,120 +2011,24 @@ bool FileSystem_WFS::isLikelySecDesc(uint32_t inUi32SizeDescVideoFragment, const
 		min not zero - 13
 	*/
 
-	uint32_t ui32CountZeroValue = 0;
-	uint32_t ui32CountNotZeroValue = 0;
-	for (uint32_t ui8ChildrenCycleIteration = 0; ui8ChildrenCycleIteration < inUi32SizeDescVideoFragment; ui8ChildrenCycleIteration++) {
-		uint8_t ui8ValueByte;
-
-		ui8ValueByte = *reinterpret_cast<uint8_t*>(reinterpret_cast<uint64_t>(inPoitCurrentPosition) + ui8ChildrenCycleIteration);
-		if (ui8ValueByte == 0)
-			ui32CountZeroValue++;
-		else
-			ui32CountNotZeroValue++;
-	}
-	if ((ui32CountNotZeroValue >= 13) and (ui32CountZeroValue <= 19) and (ui32CountNotZeroValue + ui32CountZeroValue) == inUi32SizeDescVideoFragment) {
-		WFSIndexAreaSecDesc* stWFSIndexAreaSecDesc = (WFSIndexAreaSecDesc*)inPoitCurrentPosition;
-		WFSDateTime startVideoFragment = convertTime(stWFSIndexAreaSecDesc->ui32TimeStampStartVideoFragment);
-
-		if (!isValidDateTime(startVideoFragment)) {
-			std::cout << "FileSystem_WFS::isLikelySecDesc() - Current Secondary Descriptor video fragment not have correct time" << std::endl;
-			std::cout << "\tError date time - ";
-			printWFSDateTime(startVideoFragment);
-			std::cout << std::endl;
+	uint32_t ui32CountZeroValue = inStTraits.ui8ZeroCount;
+	uint32_t ui32CountNotZeroValue = DescClassifier::kUi32DescSize - ui32CountZeroValue;
+	if ((ui32CountNotZeroValue >= 13) and (ui32CountZeroValue <= 19)) {
+		if (!(inStTraits.ui8Flags & DescClassifier::kUi8DescStartTimeValid)) {
+			outEKind = AnomalyKind::SecDescBadStartTime;
 			return false;
 		}
 
-		WFSDateTime endVideoFragment = convertTime(stWFSIndexAreaSecDesc->ui32TimeStampEndVideoFragment);
-		if (!isValidDateTime(endVideoFragment)) {
-			std::cout << "FileSystem_WFS::isLikelySecDesc() - Current Secondary Descriptor video fragment not have correct time" << std::endl;
-			std::cout << "\tError date time - ";
-			printWFSDateTime(endVideoFragment);
-			std::cout << std::endl;
+		if (!(inStTraits.ui8Flags & DescClassifier::kUi8DescEndTimeValid)) {
+			outEKind = AnomalyKind::SecDescBadEndTime;
 			return false;
 		}
 		return true;
 	}
+	outEKind = AnomalyKind::SecDescRejected;
 	return false;
 }
 
-/**
-* \brief
-* Функция для представления даты и времени из формата хранения WFS
-* в структуру данных
-*
-* \param
-* uint32_t inDwTimeValue - значение времени в формате WFS
-* 
-* \return
-* WFSDateTime - структура, хранящая информацию о дате и времени
-**/
-WFSDateTime FileSystem_WFS::convertTime(uint32_t inUi32TimeValue) {
-	/*
-		Временные метки файловой системы WFS хранятся в обратном порядке (little-endian).
-		Так значение 0xe8c7885c в памяти стоит рассматривать как 0x5C88C7E8
-		Исходя из описания формата хранения в следующей последовательности хранятся
-		год		- 6 бит
-		месяц	- 4 бит
-		день	- 5 бит
-		часы	- 5 бит
-		минуты	- 6 бит
-		секунды	- 6 бит
-
-		Пример представления числа 0x5C88C7E8:
-		ГГГГГГММММДДДДДЧЧЧЧЧммммммсссссс
-		01011100100010001100011111101000
-
-		Получается:
-		010111	23	Год
-		0010	2	Месяц
-		00100	4	День
-		01100	12	Час
-		011111	31	Минута
-		101000	40	Секунда
-		04.02.2023 12:31:40
-
-		Работа алгоритма заключается в том что изначальное
-		число сдвигается на нужное количество бит и потом
-		вычисляется логическая операция "&" по битовой маске
-		интересующего значения
-	*/
-	uint8_t ui8ShiftYear = 26;
-	uint8_t ui8ShiftMonth = 22;
-	uint8_t ui8ShiftDay = 17;
-	uint8_t ui8ShiftHour = 12;
-	uint8_t ui8ShiftMinuts = 6;
-	uint8_t ui8ShiftSeconds = 0;
-
-	uint8_t ui8MaskYear = 63;		// mask - 111111 6 единиц
-	uint8_t ui8MaskMonth = 15;		// mask - 1111 4 единиц
-	uint8_t ui8MaskDay = 31;		// mask - 11111 5 единиц
-	uint8_t ui8MaskHour = 31;		// mask - 11111 5 единиц
-	uint8_t ui8MaskMinuts = 63;		// mask - 111111 6 единиц
-	uint8_t ui8MaskSeconds = 63;	// mask - 111111 6 единиц
-
-	WFSDateTime stDataWFS;
-
-	stDataWFS.ui16Year = inUi32TimeValue >> ui8ShiftYear;
-	stDataWFS.ui16Year = 2000 + (stDataWFS.ui16Year & ui8MaskYear);
-
-	stDataWFS.ui8Month = inUi32TimeValue >> ui8ShiftMonth;
-	stDataWFS.ui8Month = stDataWFS.ui8Month & ui8MaskMonth;
-
-	stDataWFS.ui8Day = inUi32TimeValue >> ui8ShiftDay;
-	stDataWFS.ui8Day = stDataWFS.ui8Day & ui8MaskDay;
-
-	stDataWFS.ui8Hour = inUi32TimeValue >> ui8ShiftHour;
-	stDataWFS.ui8Hour = stDataWFS.ui8Hour & ui8MaskHour;
-
-	stDataWFS.ui8Minute = inUi32TimeValue >> ui8ShiftMinuts;
-	stDataWFS.ui8Minute = stDataWFS.ui8Minute & ui8MaskMinuts;
-
-	stDataWFS.ui8Second = inUi32TimeValue >> ui8ShiftSeconds;
-	stDataWFS.ui8Second = stDataWFS.ui8Second & ui8MaskSeconds;
-
-	return stDataWFS;
-}
-
 /**
 * \brief
 * Отображает дату и время, содержащиеся в структуре WFSDateTime
@@ -957,47 +2040,10 @@ WFSDateTime FileSystem_WFS::convertTime(uint32_t inUi32TimeValue) {
 * void
 *
 **/
-void FileSystem_WFS::printWFSDateTime(const WFSDateTime& inStDataWFS) {
-	printf("%02u.%02u.%04u %02u:%02u:%02u", inStDataWFS.ui8Day, inStDataWFS.ui8Month, inStDataWFS.ui16Year, inStDataWFS.ui8Hour, inStDataWFS.ui8Minute, inStDataWFS.ui8Second);
-}
-
-/**
-* \brief
-* Проверяет корректность значений даты и времени в структуре WFSDateTime
-*
-* Функция проверяет поля структуры даты и времени, что они находятся в допустимых диапазонах:
-*
-* - Год: от 2000 до 2099
-*
-* - Месяц: 1–12
-*
-* - День: 1–31
-*
-* - Часы: 0–23
-*
-* - Минуты и секунды: 0–59
-*
-* \param
-* WFSDateTime& inStDateWFS - структура времени и даты проверяемая.
-*
-* \return
-* bool - true если значения корректны, иначе false.
-**/
-bool FileSystem_WFS::isValidDateTime(const WFSDateTime& inStDateWFS) {
-	if (inStDateWFS.ui16Year < 2000 || inStDateWFS.ui16Year > 2099)
-		return false;
-	if (inStDateWFS.ui8Month < 1 || inStDateWFS.ui8Month > 12)
-		return false;
-	if (inStDateWFS.ui8Day < 1 || inStDateWFS.ui8Day > 31)
-		return false;
-	if (inStDateWFS.ui8Hour > 23)
-		return false;
-	if (inStDateWFS.ui8Minute > 59)
-		return false;
-	if (inStDateWFS.ui8Second > 59)
-		return false;
-
-	return true;
+void FileSystem_WFS::printWFSDateTime(const WFSDateTime& inStDataWFS, std::ostream& outStream) {
+	char szDateTime[32];
+	snprintf(szDateTime, sizeof(szDateTime), "%02u.%02u.%04u %02u:%02u:%02u", inStDataWFS.ui8Day, inStDataWFS.ui8Month, inStDataWFS.ui16Year, inStDataWFS.ui8Hour, inStDataWFS.ui8Minute, inStDataWFS.ui8Second);
+	outStream << szDateTime;
 }
 
 void FileSystem_WFS::printValidChains(FragmentChain& inFragmentChain) {
@@ -1006,9 +2052,9 @@ void FileSystem_WFS::printValidChains(FragmentChain& inFragmentChain) {
 	std::cout << "[ ] - " << inFragmentChain.pMainDes->ui32IndexCurrentMainDesc << std::endl;
 	//std::cout << " └────";
 	for (uint16_t ui16Iter = 0; ui16Iter < ui16LocAmountSecDesc; ui16Iter++) {
-		auto iterSecDesc = inFragmentChain.pSecDes.find(ui16Iter);
-		if (iterSecDesc != inFragmentChain.pSecDes.end()) {
-			std::cout << "\t[" << ui16Iter << "] - " << iterSecDesc->second->ui32IndexCurrentSecDesc << std::endl;
+		uint32_t ui32SecSlot = inFragmentChain.getSecSlot(ui16Iter);
+		if (ui32SecSlot != FragmentChain::kUi32NoSlot) {
+			std::cout << "\t[" << ui16Iter << "] - " << ui32SecSlot << std::endl;
 		}
 		else {
 			std::cout << "\t[" << ui16Iter << "] - X" << std::endl;
@@ -1020,10 +2066,9 @@ void FileSystem_WFS::printIncompleteChains(FragmentChain& inFragmentChain) {
 	std::cout << "New Video Chain" << std::endl;
 	std::cout << "[ ] - X"  << std::endl;
 	//std::cout << " └────";
-	for (uint16_t ui16Iter = 0; ui16Iter < 0xFFFF; ui16Iter++) {
-		auto iterSecDesc = inFragmentChain.pSecDes.find(ui16Iter);
-		if (iterSecDesc != inFragmentChain.pSecDes.end()) {
-			std::cout << "\t[" << ui16Iter << "] - " << iterSecDesc->second->ui32IndexCurrentSecDesc << std::endl;
+	for (size_t szIter = 0; szIter < inFragmentChain.vecSecSlot.size(); szIter++) {
+		if (inFragmentChain.vecSecSlot[szIter] != FragmentChain::kUi32NoSlot) {
+			std::cout << "\t[" << szIter << "] - " << inFragmentChain.vecSecSlot[szIter] << std::endl;
 		}
 	}
 }
@@ -1042,7 +2087,51 @@ void FileSystem_WFS::printAllChains() {
 
 /**
 * \brief
-* Сохранение цепочки видеофрагментов в один файл.
+* Формирует список участков образа, составляющих цепочку видеофрагментов, в порядке воспроизведения.
+* Первым идёт видеофрагмент MainDesc, далее видеофрагменты SecDesc; размер последнего
+* определяется полем ui16LastVideoFragmentSizeDBS. Отсутствующие SecDesc пропускаются.
+*
+* \param
+* const FragmentChain& inFragmentChain - структура с данными о расположении видеофрагментов.
+*
+* \return
+* std::vector<FragmentExtent> - Участки образа для последовательной записи.
+**/
+std::vector<FragmentExtent> FileSystem_WFS::collectChainExtents(const FragmentChain& inFragmentChain) {
+	uint16_t ui16LocAmountSecDesc = inFragmentChain.pMainDes->ui16CountSecDesc;
+	uint32_t ui32SizeVideoFragment = stWFSAllValue.ui32VideoFragmentSizeByte;
+
+	std::vector<FragmentExtent> vecExtents;
+	vecExtents.reserve(static_cast<size_t>(ui16LocAmountSecDesc) + 1);
+	vecExtents.push_back({ stWFSAllValue.ui64DataAreaOffsetStart + static_cast<uint64_t>(inFragmentChain.pMainDes->ui32IndexCurrentMainDesc) * static_cast<uint64_t>(stWFSAllValue.ui32VideoFragmentSizeByte), ui32SizeVideoFragment });
+
+	for (uint16_t ui16Iter = 0; ui16Iter < ui16LocAmountSecDesc; ui16Iter++) {
+		const WFSSecDescAdvInfo* pSecDesc = getSecDesc(inFragmentChain.getSecSlot(ui16Iter));
+		if (pSecDesc != nullptr) {
+			if (ui16Iter == ui16LocAmountSecDesc - 1) {
+				ui32SizeVideoFragment = pSecDesc->ui16LastVideoFragmentSizeDBS * stWFSAllValue.ui32DiskBlockSize;
+			}
+			vecExtents.push_back({ stWFSAllValue.ui64DataAreaOffsetStart + static_cast<uint64_t>(pSecDesc->ui32IndexCurrentSecDesc) * static_cast<uint64_t>(stWFSAllValue.ui32VideoFragmentSizeByte), ui32SizeVideoFragment });
+		}
+	}
+	return vecExtents;
+}
+
+/**
+* \brief
+* Устанавливает количество видеофрагментов, одновременно читаемых при сохранении цепочки.
+* Значение 1 отключает асинхронное чтение: видеофрагменты читаются пакетами через readv.
+*
+* \param
+* uint32_t inUi32QueueDepth - Глубина очереди чтения.
+**/
+void FileSystem_WFS::setExportQueueDepth(uint32_t inUi32QueueDepth) {
+	ui32ExportQueueDepth = (inUi32QueueDepth == 0) ? 1 : inUi32QueueDepth;
+}
+
+/**
+* \brief
+* Сохранение цепочки видеофрагментов в один файл. Существующий файл перезаписывается.
 *
 * \param
 * const FragmentChain& inFragmentChain - структура с данными о расположении видеофрагментов.
@@ -1050,31 +2139,224 @@ void FileSystem_WFS::printAllChains() {
 * const std::string& inString - полный путь к файлу.
 **/
 void FileSystem_WFS::saveVideoChain(const FragmentChain& inFragmentChain, const std::string& inString) {
-	uint16_t ui16LocAmountSecDesc = inFragmentChain.pMainDes->ui16CountSecDesc;
-	uint32_t ui32SizeVideoFragment = stWFSAllValue.ui32VideoFragmentSizeByte;
-	uint64_t ui64OffsetCurrentFragment = stWFSAllValue.ui64DataAreaOffsetStart + static_cast<uint64_t>(inFragmentChain.pMainDes->ui32IndexCurrentMainDesc) * static_cast<uint64_t>(stWFSAllValue.ui32VideoFragmentSizeByte);
+	saveExtents(collectChainExtents(inFragmentChain), inString);
+}
 
-	std::unique_ptr<uint8_t[]> pUi8ReadData = readRawData(ui64OffsetCurrentFragment, ui32SizeVideoFragment);
+/**
+* \brief
+* Возвращает запись SecDesc по номеру слота IndexArea, сохранённому в цепочке.
+*
+* \param
+* uint32_t inUi32Slot - номер слота (FragmentChain::vecSecSlot).
+*
+* \return
+* Указатель на запись или nullptr, если позиция цепочки пуста или в слоте нет SecDesc.
+**/
+WFSSecDescAdvInfo* FileSystem_WFS::getSecDesc(uint32_t inUi32Slot) {
+	return tableDesc.findSec(inUi32Slot);
+}
+
+/**
+* \brief
+* Возвращает способ, которым была выполнена последняя выгрузка (saveVideoChain или saveSecFragmentVideo):
+* "copy_file_range", "splice", "mmap", "async/thread-pool" или "readv".
+* Если копирование ядром выполнено не для всех данных и остаток записан через буфер,
+* возвращается "mixed/" и имя способа копирования ядром, например "mixed/copy_file_range".
+**/
+const std::string& FileSystem_WFS::getLastExportStrategy() const {
+	return strLastExportStrategy;
+}
+
+/**
+* \brief
+* Запись участков образа в файл. Файл открывается один раз, место под итоговый размер
+* резервируется заранее. Способ выгрузки выбирается в порядке предпочтения:
+*	1. копирование ядром (copy_file_range, splice) без передачи данных через пространство пользователя;
+*	2. запись непосредственно из отображённого образа (MmapFile);
+*	3. асинхронное чтение пулом потоков при глубине очереди больше 1;
+*	4. пакетное чтение через readv.
+*
+* \param
+* const std::vector<FragmentExtent>& inVecExtents - участки образа в порядке записи.
+*
+* const std::string& inString - полный путь к файлу.
+**/
+void FileSystem_WFS::saveExtents(const std::vector<FragmentExtent>& inVecExtents, const std::string& inString) {
+	uint64_t ui64TotalSize = 0;
+	for (const FragmentExtent& stExtent : inVecExtents) {
+		ui64TotalSize += stExtent.ui32Size;
+	}
+	std::unique_ptr<IOutputSink> pSink = IOutputSink::create();
+	if (!pSink->open(inString, ui64TotalSize)) {
+		throw std::runtime_error("FileSystem_WFS::saveExtents() - Can't create output file");
+	}
 
-	if (!inputFile_->writeToFileAppend(inString, pUi8ReadData, ui32SizeVideoFragment)) {
-		throw std::runtime_error("FileSystem_WFS::saveVideoChain() - Failed to write MainDescriptor data");
+	bool bBuffered = false;
+	if (saveExtentsKernel(inVecExtents, *pSink, bBuffered)) {
+		strLastExportStrategy = pSink->getKernelCopyName() ? pSink->getKernelCopyName() : "readv";
+		if (bBuffered && pSink->getKernelCopyName()) {
+			strLastExportStrategy = "mixed/" + strLastExportStrategy;
+		}
+	}
+	else if (!inputFile_->view(inVecExtents.front().ui64Offset, inVecExtents.front().ui32Size).empty()) {
+		saveExtentsFromView(inVecExtents, *pSink);
+		strLastExportStrategy = "mmap";
+	}
+	else if (ui32ExportQueueDepth > 1) {
+		saveExtentsAsync(inVecExtents, *pSink);
+	}
+	else {
+		saveExtentsBatched(inVecExtents, *pSink);
+		strLastExportStrategy = "readv";
 	}
 
-	for (uint16_t ui16Iter = 0; ui16Iter < ui16LocAmountSecDesc; ui16Iter++) {
-		auto iterSecDesc = inFragmentChain.pSecDes.find(ui16Iter);
-		if (iterSecDesc != inFragmentChain.pSecDes.end()) {
-			if (ui16Iter == ui16LocAmountSecDesc - 1) {
-				ui32SizeVideoFragment = iterSecDesc->second->ui16LastVideoFragmentSizeDBS * stWFSAllValue.ui32DiskBlockSize;
+	if (!pSink->close()) {
+		throw std::runtime_error("FileSystem_WFS::saveExtents() - Failed to write video fragment data");
+	}
+}
+
+/**
+* \brief
+* Запись участков образа в файл копированием ядром. Доступность проверяется на первом
+* непустом участке; если копирование прервалось на середине участка, остаток дописывается через буфер.
+*
+* \param
+* bool& outBBuffered - true, если часть данных записана через буфер.
+*
+* \return
+* false, если копирование ядром недоступно и ничего не записано.
+**/
+bool FileSystem_WFS::saveExtentsKernel(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink, bool& outBBuffered) {
+	outBBuffered = false;
+	int iSourceDescriptor = inputFile_->getNativeDescriptor();
+	if (iSourceDescriptor < 0) {
+		return false;
+	}
+
+	bool bStarted = false;
+	for (const FragmentExtent& stExtent : inVecExtents) {
+		if (stExtent.ui32Size == 0) {
+			continue;
+		}
+
+		auto timeStart = std::chrono::steady_clock::now();
+		uint64_t ui64Copied = inSink.copyFrom(iSourceDescriptor, stExtent.ui64Offset, stExtent.ui32Size);
+		if (ui64Copied != 0) {
+			// Чтение образа ядром не проходит через inputFile_, поэтому учитывается явно (InstrumentedFile)
+			uint64_t ui64Ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeStart).count());
+			inputFile_->recordKernelRead(stExtent.ui64Offset, ui64Copied, ui64Ns);
+		}
+		if (ui64Copied == 0 && !bStarted) {
+			return false;
+		}
+		bStarted = true;
+
+		if (ui64Copied < stExtent.ui32Size) {
+			outBBuffered = true;
+			std::unique_ptr<uint8_t[]> pUi8Holder;
+			ByteView stRest = readDataView(stExtent.ui64Offset + ui64Copied, stExtent.ui32Size - ui64Copied, pUi8Holder);
+			if (!inSink.write(stRest.pData, static_cast<size_t>(stExtent.ui32Size - ui64Copied))) {
+				throw std::runtime_error("FileSystem_WFS::saveExtents() - Failed to write video fragment data");
 			}
-			
-			ui64OffsetCurrentFragment = stWFSAllValue.ui64DataAreaOffsetStart + static_cast<uint64_t>(iterSecDesc->second->ui32IndexCurrentSecDesc) * static_cast<uint64_t>(stWFSAllValue.ui32VideoFragmentSizeByte);
+		}
+	}
+	return bStarted;
+}
+
+/**
+* \brief
+* Запись участков образа в файл непосредственно из отображённых страниц.
+* Следующий видеофрагмент запрашивается заранее, так как фрагменты цепочки разбросаны по DataArea.
+* Фрагмент без прямого доступа (например, на границе частей разбитого образа) читается в буфер.
+**/
+void FileSystem_WFS::saveExtentsFromView(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink) {
+	for (size_t szIter = 0; szIter < inVecExtents.size(); szIter++) {
+		if (szIter + 1 < inVecExtents.size()) {
+			inputFile_->advise(inVecExtents[szIter + 1].ui64Offset, inVecExtents[szIter + 1].ui32Size, FileAccessHint::WillNeed);
+		}
+
+		std::unique_ptr<uint8_t[]> pUi8Holder;
+		ByteView stFragment = readDataView(inVecExtents[szIter].ui64Offset, inVecExtents[szIter].ui32Size, pUi8Holder);
+		if (!inSink.write(stFragment.pData, inVecExtents[szIter].ui32Size)) {
+			throw std::runtime_error("FileSystem_WFS::saveExtents() - Failed to write video fragment data");
+		}
+	}
+}
+
+/**
+* \brief
+* Запись участков образа в файл с асинхронным чтением: до ui32ExportQueueDepth
+* видеофрагментов читаются одновременно, запись выполняется строго в порядке цепочки.
+**/
+void FileSystem_WFS::saveExtentsAsync(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink) {
+	std::vector<ReadExtent> vecReadExtents;
+	vecReadExtents.reserve(inVecExtents.size());
+	for (const FragmentExtent& stExtent : inVecExtents) {
+		vecReadExtents.push_back({ stExtent.ui64Offset, stExtent.ui32Size });
+	}
+
+	std::unique_ptr<AsyncReader> pReader = AsyncReader::create(*inputFile_, ui32ExportQueueDepth);
+	strLastExportStrategy = std::string("async/") + pReader->name();
+	bool bResult = pReader->readOrdered(vecReadExtents, [&](size_t /*szIndex*/, const uint8_t* pUi8Data, uint64_t ui64Size) {
+		if (!inSink.write(pUi8Data, static_cast<size_t>(ui64Size))) {
+			throw std::runtime_error("FileSystem_WFS::saveExtents() - Failed to write video fragment data");
+		}
+	});
+
+	if (!bResult) {
+		throw std::runtime_error("FileSystem_WFS::saveExtents() - Failed to read video fragment data");
+	}
+}
 
-			pUi8ReadData = readRawData(ui64OffsetCurrentFragment, ui32SizeVideoFragment);
+/**
+* \brief
+* Запись участков образа в файл с пакетным чтением: видеофрагменты читаются через readv
+* пакетами объёмом до kUi64ExportBatchSize в один буфер, каждый пакет передаётся в файл назначения целиком.
+**/
+void FileSystem_WFS::saveExtentsBatched(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink) {
+	std::unique_ptr<uint8_t[]> pUi8Batch;
+	uint64_t ui64BatchCapacity = 0;
+	std::vector<ReadRequest> vecRequests;
+
+	size_t szFirst = 0;
+	while (szFirst < inVecExtents.size()) {
+		// Пакет содержит хотя бы один видеофрагмент, даже если он больше kUi64ExportBatchSize
+		size_t szLast = szFirst;
+		uint64_t ui64BatchSize = 0;
+		while (szLast < inVecExtents.size() && (szLast == szFirst || ui64BatchSize + inVecExtents[szLast].ui32Size <= kUi64ExportBatchSize)) {
+			ui64BatchSize += inVecExtents[szLast].ui32Size;
+			szLast++;
+		}
 
-			if (!inputFile_->writeToFileAppend(inString, pUi8ReadData, ui32SizeVideoFragment)) {
-				throw std::runtime_error("FileSystem_WFS::saveVideoChain() - Failed to write secondary fragment index " + std::to_string(ui16Iter));
+		if (ui64BatchSize > ui64BatchCapacity) {
+			pUi8Batch.reset(new uint8_t[ui64BatchSize]);
+			ui64BatchCapacity = ui64BatchSize;
+		}
+
+		vecRequests.clear();
+		uint64_t ui64BufferOffset = 0;
+		for (size_t szIter = szFirst; szIter < szLast; szIter++) {
+			ReadRequest stRequest;
+			stRequest.ui64Offset = inVecExtents[szIter].ui64Offset;
+			stRequest.pUi8Buffer = pUi8Batch.get() + ui64BufferOffset;
+			stRequest.ui64Size = inVecExtents[szIter].ui32Size;
+			vecRequests.push_back(stRequest);
+			ui64BufferOffset += inVecExtents[szIter].ui32Size;
+		}
+
+		if (!inputFile_->readv(vecRequests)) {
+			throw std::runtime_error("FileSystem_WFS::saveExtents() - Failed to read video fragment data");
+		}
+		for (const ReadRequest& stRequest : vecRequests) {
+			if (stRequest.ui64BytesRead != stRequest.ui64Size) {
+				throw std::runtime_error("FileSystem_WFS::saveExtents() - Incomplete read");
 			}
 		}
+
+		if (!inSink.write(pUi8Batch.get(), static_cast<size_t>(ui64BatchSize))) {
+			throw std::runtime_error("FileSystem_WFS::saveExtents() - Failed to write video fragment data");
+		}
+		szFirst = szLast;
 	}
 }
 
@@ -1100,9 +2382,5 @@ void FileSystem_WFS::saveSecFragmentVideo(const WFSSecDescAdvInfo& inSecDesc, co
 	
 	uint64_t ui64OffsetCurrentFragment = stWFSAllValue.ui64DataAreaOffsetStart + static_cast<uint64_t>(inSecDesc.ui32IndexCurrentSecDesc) * static_cast<uint64_t>(stWFSAllValue.ui32VideoFragmentSizeByte);
 
-	std::unique_ptr<uint8_t[]> pUi8ReadData = readRawData(ui64OffsetCurrentFragment, ui32SizeVideoFragment);
-
-	if (!inputFile_->writeToFile(inString, pUi8ReadData, ui32SizeVideoFragment)) {
-		throw std::runtime_error("FileSystem_WFS::saveSecFragmentVideo() - Can't write to file");
-	}
+	saveExtents({ { ui64OffsetCurrentFragment, ui32SizeVideoFragment } }, inString);
 }
\ No newline at end of file
@@ -1,58 +1,200 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 #include <list>
 #include <iostream>
 #include <iomanip>
-#include <unordered_map>
 #include <map>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
 #include "struct_wfs.h"
+#include "AnomalySink.h"
+#include "DescClassifier.h"
+#include "DescTable.h"
+#include "IndexCache.h"
+#include "WFSTime.h"
+#include "WorkStealing.h"
 #include "../io/IFile.h"
+#include "../io/AsyncReader.h"
+#include "../io/IOutputSink.h"
 
 class FileSystem_WFS
 {
 public:
-	explicit FileSystem_WFS(std::unique_ptr<IFile> inFile);
-	std::map<uint32_t, FragmentChain> mapValidChains;				// Ассоциативный контейнер видеофрагментов с MainDesc
-	std::map<uint32_t, FragmentChain> mapIncompleteChains;			// Ассоциативный контейнер видеофрагментов без MainDesc
+	explicit FileSystem_WFS(std::unique_ptr<IFile> inFile, uint32_t inUi32AnalysisThreads = 0);
+
+	// Разбирает IndexArea и строит все цепочки видеофрагментов (повторный вызов ничего не делает)
+	void analyze();
+	bool isAnalyzed() const;
+
+	// Перечитывает SuperBlock и, если он изменился, обновляет таблицу дескрипторов и цепочки по участку
+	// IndexArea между прежней и новой позицией записи. false, если SuperBlock не изменился
+	bool refresh();
+
+	// Файл индекса образа. Если путь задан, analyze() загружает результаты разбора из файла, а при
+	// отсутствии файла или несовпадении ключа образа выполняет полный разбор и сохраняет результаты
+	void setIndexCachePath(const std::string& inStringPath);
+
+	// Количество событий каждого вида нарушений, сохраняемых для отчёта (по умолчанию AnomalySink::kUi32DefaultSampleLimit)
+	void setAnomalySampleLimit(uint32_t inUi32SampleLimit);
+
+	// Нарушения, обнаруженные последним полным разбором IndexArea и построением цепочек (analyze()).
+	// refresh() их не обновляет
+	const AnomalySink& getAnomalies() const;
+
+	// Отчёт о нарушениях в формате JSON (смещения дескрипторов - относительно начала образа)
+	std::string getAnomaliesJson() const;
+
+	// Цепочки видеофрагментов с MainDesc и без него. При первом обращении выполняется analyze()
+	std::map<uint32_t, FragmentChain>& getValidChains();
+	std::map<uint32_t, FragmentChain>& getIncompleteChains();
+
+	// Последовательности SecDesc, восстановленные по ссылкам ui32IndexPrevSecDesc/ui32IndexNextSecDesc.
+	// При первом обращении выполняется analyze()
+	std::vector<FragmentChain>& getLinkedRuns();
+
+	// Цепочка с номером MainDesc inUi32IndexMainDesc (nullptr, если не найдена). До analyze() цепочка
+	// с MainDesc строится выборочным чтением дескрипторов; указатель действителен до вызова analyze()
+	FragmentChain* findChain(uint32_t inUi32IndexMainDesc);
+
+	// Вывод информации о файловой системе (количество дескрипторов - только после analyze())
+	void printWFSInf();
 
 	// Сохраняет цепочку видеофрагментов в файл
 	void saveVideoChain(const FragmentChain& inFragmentChain, const std::string& inString);
 
+	// Задаёт количество видеофрагментов, одновременно читаемых при сохранении цепочки
+	void setExportQueueDepth(uint32_t inUi32QueueDepth);
+
 	// Сохраняет видеофрагмент в файл
 	void saveSecFragmentVideo(const WFSSecDescAdvInfo& inSecDesc, const std::string& inString);
 
+	// Запись SecDesc по номеру слота из FragmentChain::vecSecSlot (nullptr, если слот пуст)
+	WFSSecDescAdvInfo* getSecDesc(uint32_t inUi32Slot);
+
+	// Способ, которым была выполнена последняя выгрузка
+	const std::string& getLastExportStrategy() const;
+
 private:
+	static constexpr uint64_t kUi64ExportBatchSize = 0x4000000;	// Объём пакетного чтения при сохранении цепочки (64 МБ)
+	static constexpr uint64_t kUi64IndexAreaWindowSize = 0x4000000;	// Размер окна потокового разбора IndexArea (64 МБ, кратен размеру дескриптора)
+	static constexpr uint32_t kUi32DefaultExportQueueDepth = 8;	// Глубина очереди асинхронного чтения при сохранении цепочки
+	static constexpr uint32_t kUi32MinDescPerThread = 0x4000;		// Наименьшее количество дескрипторов на поток разбора IndexArea
+	static constexpr uint32_t kUi32ClassifyBlockSize = 256;		// Дескрипторов, классифицируемых одним вызовом DescClassifier
+	static constexpr uint32_t kUi32MinChainsPerThread = 1024;		// Наименьшее количество цепочек на поток построения
+	static constexpr uint32_t kUi32ChainGrain = 32;				// Цепочек, забираемых потоком построения за раз
+	static constexpr uint32_t kUi32RefreshMaxShare = 8;			// Обновление выполняется полным разбором, если изменилось больше 1/8 IndexArea
+
+	// Номера разделов файла индекса (разделы 1-15 занимает DescTable)
+	static constexpr uint32_t kUi32SectionAllValue = 0x10;			// stWFSAllValue
+	static constexpr uint32_t kUi32SectionValidChains = 0x20;		// mapValidChains (три раздела PackedChains)
+	static constexpr uint32_t kUi32SectionIncompleteChains = 0x30;	// mapIncompleteChains (три раздела PackedChains)
+	static constexpr uint32_t kUi32SectionLinkedRuns = 0x40;		// vecLinkedRuns (три раздела PackedChains)
+	static constexpr uint32_t kUi32SectionLinkedRunMainDesc = 0x50;	// vecLinkedRunMainDesc
+	static constexpr uint32_t kUi32SectionAnomalies = 0x60;			// sinkAnomalies (два раздела)
+
+	// Результат разбора непрерывного диапазона дескрипторов IndexArea одним потоком
+	struct IndexAreaScanPart {
+		uint32_t ui32CountMainDesc = 0;
+		uint32_t ui32CountSecDesc = 0;
+		uint32_t ui32CountReservedDesc = 0;
+		uint32_t ui32CountAnotherDesc = 0;
+		std::vector<std::pair<uint32_t, WFSMainDescAdvInfo>> vecMainDesc;	// MainDesc в порядке индексов
+		std::vector<WFSSecDescAdvInfo> vecSecDesc;							// SecDesc в порядке индексов (индекс - ui32IndexCurrentSecDesc)
+		std::vector<uint32_t> vecReservedSlots;								// Слоты зарезервированных дескрипторов
+		std::vector<uint32_t> vecAnotherSlots;								// Слоты с другими данными
+		AnomalySink sinkAnomalies;											// Неопознанные дескрипторы
+	};
+
+	// SecDesc, не вошедший в цепочки при обходе по MainDesc
+	struct OrphanSecDesc {
+		uint32_t ui32IndexMainDesc;		// Номер MainDesc из SecDesc
+		uint32_t ui32Slot;				// Номер слота SecDesc
+		uint16_t ui16RelativeIndex;		// Позиция SecDesc в цепочке
+	};
+
+	// Цепочки видеофрагментов в виде плоских массивов для файла индекса
+	struct PackedChains {
+		std::vector<uint32_t> vecKeys;		// Ключ цепочки (номер MainDesc или номер последовательности)
+		std::vector<uint32_t> vecSizes;		// Количество позиций цепочки
+		std::vector<uint32_t> vecSlots;		// Позиции всех цепочек подряд
+
+		void add(uint32_t inUi32Key, const FragmentChain& inFragmentChain);
+		void save(IndexCacheWriter& inWriter, uint32_t inUi32FirstSection) const;
+		bool load(const IndexCacheReader& inReader, uint32_t inUi32FirstSection);
+	};
+
+	uint32_t ui32ExportQueueDepth = kUi32DefaultExportQueueDepth;
+	uint32_t ui32AnalysisThreads = 1;
+	std::string strLastExportStrategy;
+
 	WFSAllValue stWFSAllValue;
+	WFSSuperBlock stWFSSuperBlock{};							// SuperBlock, по которому заполнен stWFSAllValue
 	std::unique_ptr<IFile> inputFile_;
-	std::map<uint32_t, WFSMainDescAdvInfo> mapMainDesc;		// Ассоциативный контейнер MainDesc
-	std::map<uint32_t, WFSSecDescAdvInfo> mapSecDesc;			// Ассоциативный контейнер SecDesc
+	DescTable tableDesc;										// Таблица MainDesc и SecDesc по номеру слота IndexArea
+	AnomalySink sinkAnomalies;									// Нарушения, обнаруженные при разборе
+	std::map<uint32_t, FragmentChain> mapValidChains;				// Ассоциативный контейнер видеофрагментов с MainDesc
+	std::map<uint32_t, FragmentChain> mapIncompleteChains;			// Ассоциативный контейнер видеофрагментов без MainDesc
+	std::vector<FragmentChain> vecLinkedRuns;						// Последовательности SecDesc, восстановленные по ссылкам
+	std::vector<WFSMainDescAdvInfo> vecLinkedRunMainDesc;			// MainDesc последовательностей vecLinkedRuns
+
+	// === Выборочное построение цепочек до разбора IndexArea ===
+	bool bIsIndexAreaScanned = false;							// IndexArea разобрана, tableDesc содержит все дескрипторы
+	bool bIsAnalyzed = false;									// Все цепочки построены
+	std::map<uint32_t, WFSMainDescAdvInfo> mapResolvedMainDesc;	// MainDesc, прочитанные выборочно
+	std::map<uint32_t, FragmentChain> mapResolvedChains;		// Цепочки, построенные выборочно
+	std::chrono::duration<double> durationOpen{};				// Время открытия (заголовок и SuperBlock)
+	std::string strIndexCachePath;								// Файл индекса (пустая строка - индекс не используется)
 
 	// === Анализ и проверка структуры WFS ===
 	template <typename T> T readStruct(uint64_t inUi64Offset, uint32_t inUi32Size);
-	std::unique_ptr<uint8_t[]> readRawData(uint64_t inUi64Offset, uint32_t inUi32Size);
+	std::unique_ptr<uint8_t[]> readRawData(uint64_t inUi64Offset, uint64_t inUi64Size);
+	ByteView readDataView(uint64_t inUi64Offset, uint64_t inUi64Size, std::unique_ptr<uint8_t[]>& pUi8Holder);
 	bool checkWFSHeader(const WFSHeader& inPStWFSHeader);
 	bool checkWFSSuperBlock(const WFSSuperBlock& inPStWFSSuperblock);
 	bool isWFS();
 	void initSuperBlock();
+	void applySuperBlock(const WFSSuperBlock& inStWFSSuperBlock);
+	void resetAnalysis();
 	void analysisIndexArea();
+	void scanIndexAreaWindow(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc);
+	void classifyIndexAreaRange(const uint8_t* inPUi8Data, uint32_t inUi32FirstDesc, uint32_t inUi32CountDesc, IndexAreaScanPart& outPart);
+	void mergeIndexAreaScanPart(IndexAreaScanPart& inPart);
+	WFSMainDescAdvInfo makeMainDescInfo(const void* inPointDesc);
+	WFSSecDescAdvInfo makeSecDescInfo(const void* inPointDesc, uint32_t inUi32IndexDesc);
+	WFSSecDescAdvInfo* lookupSecDesc(uint32_t inUi32Slot, AnomalySink& outAnomalies);
+	bool rebuildValidChain(uint32_t inUi32IndexCurrentMainDesc, FragmentChain& inFragmentChain, AnomalySink& outAnomalies, std::vector<uint32_t>* outPVecReadSlots = nullptr);
+	void markChainAdded(FragmentChain& inFragmentChain);
 	void rebuildUnwrittenVideoChain();
-	void rebuildOverwrittenVideoChain();
+	void rebuildValidChains(const std::vector<std::map<uint32_t, FragmentChain>::iterator>& inVecChains, AnomalySink& outAnomalies);
+	uint32_t refreshValidChains(const std::vector<uint32_t>& inVecChangedSlots, AnomalySink& outAnomalies);
+	void rebuildOverwrittenVideoChain(AnomalySink& outAnomalies);
+	static void sortOrphanSecDesc(std::vector<OrphanSecDesc>& inVecOrphans);
+	void rebuildLinkedRuns();
+	uint64_t computeIndexKey();
+	bool loadIndexCache();
+	bool loadIndexCacheChains(const IndexCacheReader& inReader);
+	void saveIndexCache();
+	std::vector<FragmentExtent> collectChainExtents(const FragmentChain& inFragmentChain);
+	void saveExtents(const std::vector<FragmentExtent>& inVecExtents, const std::string& inString);
+	bool saveExtentsKernel(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink, bool& outBBuffered);
+	void saveExtentsFromView(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink);
+	void saveExtentsAsync(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink);
+	void saveExtentsBatched(const std::vector<FragmentExtent>& inVecExtents, IOutputSink& inSink);
 
 	// === Вспомогательные утилиты ===
-	bool isLikelyMainDesc(uint32_t inUi32IndexDesc, uint32_t inUi32SizeDescVideoFragment, const void* inPoitCurrentPosition);
-	bool isLikelySecDesc(uint32_t inUi32SizeDescVideoFragment, const void* inPoitCurrentPosition);
-	WFSDateTime convertTime(uint32_t inU32TimeValue);
-	bool isValidDateTime(const WFSDateTime& inStDateWFS);
+	bool isLikelyMainDesc(const DescTraits& inStTraits, AnomalyKind& outEKind);
+	bool isLikelySecDesc(const DescTraits& inStTraits, AnomalyKind& outEKind);
 	
 	// === Вывод информации ===
-	void printWFSInf();
-	void printWFSDateTime(const WFSDateTime& inStDateWFS);
+	void printWFSDateTime(const WFSDateTime& inStDateWFS, std::ostream& outStream = std::cout);
 	void printValidChains(FragmentChain& inFragmentChain);
 	void printIncompleteChains(FragmentChain& inFragmentChain);
 	void printAllChains();
-	void dumpHex(const void* vPointOffsetPrintData, uint32_t ui32SizePrintData, uint64_t ui64OffsetInFWS);
 };
\ No newline at end of file
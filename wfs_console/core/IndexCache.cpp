@@ -0,0 +1,186 @@
+#include "IndexCache.h"
+
+#include <cstdio>
+#include <fstream>
+
+#if defined(__linux__) || (defined(__MACH__) && defined(__APPLE__))
+#include "../io/MmapFile.h"
+#endif
+
+namespace {
+	const char kArrSignature[8] = { 'W', 'F', 'S', 'I', 'D', 'X', 0, 0 };
+	const uint32_t kUi32ByteOrderMark = 0x01020304;
+
+	// Заголовок файла индекса
+	struct IndexCacheHeader {
+		char arrSignature[8];
+		uint32_t ui32Version;
+		uint32_t ui32ByteOrderMark;
+		uint64_t ui64Key;
+		uint64_t ui64FileSize;
+		uint32_t ui32SectionCount;
+		uint32_t ui32Reserved;
+	};
+
+	// Запись таблицы разделов
+	struct IndexCacheSection {
+		uint32_t ui32Id;
+		uint32_t ui32Reserved;
+		uint64_t ui64Offset;
+		uint64_t ui64Size;
+	};
+
+	uint64_t alignUp(uint64_t inUi64Value) {
+		return (inUi64Value + IndexCache::kUi32Alignment - 1) / IndexCache::kUi32Alignment * IndexCache::kUi32Alignment;
+	}
+}
+
+uint64_t IndexCache::hash(const void* inPData, uint64_t inUi64Size, uint64_t inUi64Seed) {
+	const uint8_t* pUi8Data = static_cast<const uint8_t*>(inPData);
+	uint64_t ui64Hash = inUi64Seed;
+	for (uint64_t ui64Byte = 0; ui64Byte < inUi64Size; ui64Byte++) {
+		ui64Hash ^= pUi8Data[ui64Byte];
+		ui64Hash *= 0x100000001B3ull;
+	}
+	return ui64Hash;
+};
+
+void IndexCacheWriter::addSection(uint32_t inUi32Id, const void* inPData, uint64_t inUi64Size) {
+	vecSections.push_back(PendingSection{ inUi32Id, inPData, inUi64Size });
+};
+
+/**
+* \brief
+* Записывает файл индекса. Данные пишутся во временный файл рядом с inStringPath, который
+* затем заменяет прежний файл, поэтому прерванная запись не оставляет повреждённый индекс.
+*
+* \return
+* true, если файл записан.
+**/
+bool IndexCacheWriter::write(const std::string& inStringPath, uint64_t inUi64Key) const {
+	IndexCacheHeader stHeader{};
+	std::memcpy(stHeader.arrSignature, kArrSignature, sizeof(kArrSignature));
+	stHeader.ui32Version = IndexCache::kUi32Version;
+	stHeader.ui32ByteOrderMark = kUi32ByteOrderMark;
+	stHeader.ui64Key = inUi64Key;
+	stHeader.ui32SectionCount = static_cast<uint32_t>(vecSections.size());
+
+	std::vector<IndexCacheSection> vecTable(vecSections.size());
+	uint64_t ui64Offset = alignUp(sizeof(IndexCacheHeader) + sizeof(IndexCacheSection) * vecTable.size());
+	for (size_t szSection = 0; szSection < vecSections.size(); szSection++) {
+		vecTable[szSection].ui32Id = vecSections[szSection].ui32Id;
+		vecTable[szSection].ui64Offset = ui64Offset;
+		vecTable[szSection].ui64Size = vecSections[szSection].ui64Size;
+		ui64Offset = alignUp(ui64Offset + vecSections[szSection].ui64Size);
+	}
+	stHeader.ui64FileSize = ui64Offset;
+
+	std::string stringTempPath = inStringPath + ".tmp";
+	{
+		std::ofstream streamOut(stringTempPath, std::ios::binary | std::ios::trunc);
+		if (!streamOut) {
+			return false;
+		}
+		const char arrPadding[IndexCache::kUi32Alignment] = {};
+		uint64_t ui64Written = 0;
+		auto fnWrite = [&](const void* inPData, uint64_t inUi64Size) {
+			streamOut.write(static_cast<const char*>(inPData), static_cast<std::streamsize>(inUi64Size));
+			ui64Written += inUi64Size;
+		};
+		auto fnPad = [&]() {
+			fnWrite(arrPadding, alignUp(ui64Written) - ui64Written);
+		};
+
+		fnWrite(&stHeader, sizeof(stHeader));
+		fnWrite(vecTable.data(), sizeof(IndexCacheSection) * vecTable.size());
+		fnPad();
+		for (const PendingSection& stSection : vecSections) {
+			fnWrite(stSection.pData, stSection.ui64Size);
+			fnPad();
+		}
+		if (!streamOut) {
+			streamOut.close();
+			std::remove(stringTempPath.c_str());
+			return false;
+		}
+	}
+
+	// В Windows rename не заменяет существующий файл
+	std::remove(inStringPath.c_str());
+	if (std::rename(stringTempPath.c_str(), inStringPath.c_str()) != 0) {
+		std::remove(stringTempPath.c_str());
+		return false;
+	}
+	return true;
+};
+
+/**
+* \brief
+* Открывает файл индекса. В Linux и macOS файл отображается в память, иначе читается целиком.
+*
+* \return
+* true, если сигнатура, версия, порядок байт, ключ и таблица разделов корректны.
+**/
+bool IndexCacheReader::open(const std::string& inStringPath, uint64_t inUi64Key) {
+	mappedFile.reset();
+	pUi8Buffer.reset();
+	stData = ByteView{};
+	vecSections.clear();
+
+#if defined(__linux__) || (defined(__MACH__) && defined(__APPLE__))
+	std::unique_ptr<IFile> file = std::make_unique<MmapFile>();
+	if (!file->open(inStringPath)) {
+		return false;
+	}
+	stData = file->view(0, file->getSize());
+	mappedFile = std::move(file);
+#else
+	std::ifstream streamIn(inStringPath, std::ios::binary | std::ios::ate);
+	if (!streamIn) {
+		return false;
+	}
+	uint64_t ui64FileSize = static_cast<uint64_t>(streamIn.tellg());
+	pUi8Buffer.reset(new uint8_t[ui64FileSize]);
+	streamIn.seekg(0);
+	if (!streamIn.read(reinterpret_cast<char*>(pUi8Buffer.get()), static_cast<std::streamsize>(ui64FileSize))) {
+		return false;
+	}
+	stData = ByteView{ pUi8Buffer.get(), ui64FileSize };
+#endif
+
+	if (stData.empty() || stData.ui64Size < sizeof(IndexCacheHeader)) {
+		return false;
+	}
+	IndexCacheHeader stHeader;
+	std::memcpy(&stHeader, stData.pData, sizeof(stHeader));
+	if (std::memcmp(stHeader.arrSignature, kArrSignature, sizeof(kArrSignature)) != 0 ||
+		stHeader.ui32Version != IndexCache::kUi32Version ||
+		stHeader.ui32ByteOrderMark != kUi32ByteOrderMark ||
+		stHeader.ui64Key != inUi64Key ||
+		stHeader.ui64FileSize != stData.ui64Size) {
+		return false;
+	}
+
+	uint64_t ui64TableEnd = sizeof(IndexCacheHeader) + sizeof(IndexCacheSection) * static_cast<uint64_t>(stHeader.ui32SectionCount);
+	if (ui64TableEnd > stData.ui64Size) {
+		return false;
+	}
+	for (uint32_t ui32Section = 0; ui32Section < stHeader.ui32SectionCount; ui32Section++) {
+		IndexCacheSection stSection;
+		std::memcpy(&stSection, stData.pData + sizeof(IndexCacheHeader) + sizeof(IndexCacheSection) * ui32Section, sizeof(stSection));
+		if (stSection.ui64Offset > stData.ui64Size || stSection.ui64Size > stData.ui64Size - stSection.ui64Offset) {
+			return false;
+		}
+		vecSections.push_back(SectionEntry{ stSection.ui32Id, stSection.ui64Offset, stSection.ui64Size });
+	}
+	return true;
+};
+
+ByteView IndexCacheReader::section(uint32_t inUi32Id) const {
+	for (const SectionEntry& stSection : vecSections) {
+		if (stSection.ui32Id == inUi32Id) {
+			return ByteView{ stData.pData + stSection.ui64Offset, stSection.ui64Size };
+		}
+	}
+	return ByteView{};
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../io/IFile.h"
+
+/*
+* Файл индекса образа (sidecar). Файл состоит из заголовка (сигнатура, версия формата, ключ
+* образа, размер файла), таблицы разделов и самих разделов - плоских массивов записей,
+* выровненных по 64 байтам. Разделы не требуют разбора: при чтении файл отображается в
+* память (Linux, macOS) и массив раздела используется или копируется целиком.
+*
+* Ключ вычисляется владельцем файла (FileSystem_WFS) по заголовку WFS, SuperBlock, размеру
+* и времени изменения образа; при несовпадении ключа или версии файл не используется.
+*/
+class IndexCache {
+public:
+	static constexpr uint32_t kUi32Version = 3;
+	static constexpr uint32_t kUi32Alignment = 64;
+
+	// Хэш FNV-1a (64 бита) участка памяти; inUi64Seed - значение хэша предыдущих участков
+	static uint64_t hash(const void* inPData, uint64_t inUi64Size, uint64_t inUi64Seed = 0xCBF29CE484222325ull);
+};
+
+// Формирование файла индекса: разделы добавляются ссылками на данные и записываются методом write
+class IndexCacheWriter {
+public:
+	// Добавляет раздел inUi32Id. Данные должны существовать до вызова write
+	void addSection(uint32_t inUi32Id, const void* inPData, uint64_t inUi64Size);
+
+	template <typename T> void addArray(uint32_t inUi32Id, const std::vector<T>& inVec) {
+		addSection(inUi32Id, inVec.data(), static_cast<uint64_t>(inVec.size()) * sizeof(T));
+	}
+
+	// Записывает файл с ключом inUi64Key. Файл записывается во временный и затем переименовывается
+	bool write(const std::string& inStringPath, uint64_t inUi64Key) const;
+
+private:
+	struct PendingSection {
+		uint32_t ui32Id;
+		const void* pData;
+		uint64_t ui64Size;
+	};
+	std::vector<PendingSection> vecSections;
+};
+
+// Чтение файла индекса: проверка заголовка и ключа, доступ к разделам без копирования
+class IndexCacheReader {
+public:
+	// Открывает файл и проверяет сигнатуру, версию, ключ inUi64Key и границы разделов
+	bool open(const std::string& inStringPath, uint64_t inUi64Key);
+
+	// Данные раздела inUi32Id (пустой ByteView, если раздела нет)
+	ByteView section(uint32_t inUi32Id) const;
+
+	// Копирует раздел inUi32Id в outVec. false, если раздела нет или его размер не кратен sizeof(T)
+	template <typename T> bool readArray(uint32_t inUi32Id, std::vector<T>& outVec) const {
+		ByteView stView = section(inUi32Id);
+		if (stView.pData == nullptr || stView.ui64Size % sizeof(T) != 0) {
+			return false;
+		}
+		outVec.resize(static_cast<size_t>(stView.ui64Size / sizeof(T)));
+		if (stView.ui64Size != 0) {
+			std::memcpy(outVec.data(), stView.pData, static_cast<size_t>(stView.ui64Size));
+		}
+		return true;
+	}
+
+private:
+	struct SectionEntry {
+		uint32_t ui32Id;
+		uint64_t ui64Offset;
+		uint64_t ui64Size;
+	};
+	std::unique_ptr<IFile> mappedFile;				// Отображённый в память файл индекса
+	std::unique_ptr<uint8_t[]> pUi8Buffer;			// Содержимое файла, если отображение недоступно
+	ByteView stData;
+	std::vector<SectionEntry> vecSections;
+};
@@ -0,0 +1,183 @@
+#include "WFSTime.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WFS_TIME_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define WFS_TIME_NEON
+#endif
+
+/**
+* \brief
+* Функция для представления даты и времени из формата хранения WFS
+* в структуру данных
+*
+* \param
+* uint32_t inUi32Time - значение времени в формате WFS
+*
+* \return
+* WFSDateTime - структура, хранящая информацию о дате и времени
+**/
+WFSDateTime WFSTime::toDateTime(uint32_t inUi32Time) {
+	/*
+		Временные метки файловой системы WFS хранятся в обратном порядке (little-endian).
+		Так значение 0xe8c7885c в памяти стоит рассматривать как 0x5C88C7E8
+		Исходя из описания формата хранения в следующей последовательности хранятся
+		год		- 6 бит
+		месяц	- 4 бит
+		день	- 5 бит
+		часы	- 5 бит
+		минуты	- 6 бит
+		секунды	- 6 бит
+
+		Пример представления числа 0x5C88C7E8:
+		ГГГГГГММММДДДДДЧЧЧЧЧммммммсссссс
+		01011100100010001100011111101000
+
+		Получается:
+		010111	23	Год
+		0010	2	Месяц
+		00100	4	День
+		01100	12	Час
+		011111	31	Минута
+		101000	40	Секунда
+		04.02.2023 12:31:40
+
+		Работа алгоритма заключается в том что изначальное
+		число сдвигается на нужное количество бит и потом
+		вычисляется логическая операция "&" по битовой маске
+		интересующего значения
+	*/
+	WFSDateTime stDataWFS;
+	stDataWFS.ui16Year = static_cast<uint16_t>(kUi16BaseYear + ((inUi32Time >> kUi32ShiftYear) & kUi32MaskYear));
+	stDataWFS.ui8Month = static_cast<uint8_t>((inUi32Time >> kUi32ShiftMonth) & kUi32MaskMonth);
+	stDataWFS.ui8Day = static_cast<uint8_t>((inUi32Time >> kUi32ShiftDay) & kUi32MaskDay);
+	stDataWFS.ui8Hour = static_cast<uint8_t>((inUi32Time >> kUi32ShiftHour) & kUi32MaskHour);
+	stDataWFS.ui8Minute = static_cast<uint8_t>((inUi32Time >> kUi32ShiftMinute) & kUi32MaskMinute);
+	stDataWFS.ui8Second = static_cast<uint8_t>((inUi32Time >> kUi32ShiftSecond) & kUi32MaskSecond);
+	return stDataWFS;
+};
+
+/**
+* \brief
+* Проверяет корректность значений даты и времени упакованной метки:
+*
+* - Месяц: 1–12
+*
+* - День: 1–31
+*
+* - Часы: 0–23
+*
+* - Минуты и секунды: 0–59
+*
+* Год (2000 + 6 бит) всегда находится в допустимом диапазоне 2000–2099.
+**/
+bool WFSTime::isValid(uint32_t inUi32Time) {
+	uint32_t ui32Month = (inUi32Time >> kUi32ShiftMonth) & kUi32MaskMonth;
+	uint32_t ui32Day = (inUi32Time >> kUi32ShiftDay) & kUi32MaskDay;
+	uint32_t ui32Hour = (inUi32Time >> kUi32ShiftHour) & kUi32MaskHour;
+	uint32_t ui32Minute = (inUi32Time >> kUi32ShiftMinute) & kUi32MaskMinute;
+	uint32_t ui32Second = (inUi32Time >> kUi32ShiftSecond) & kUi32MaskSecond;
+	return ui32Month >= 1 && ui32Month <= 12 && ui32Day >= 1 && ui32Hour <= 23 && ui32Minute <= 59 && ui32Second <= 59;
+};
+
+/**
+* \brief
+* Поля четырёх меток извлекаются одновременно (SSE2/NEON), запись в WFSDateTime
+* (упакованная структура 7 байт) выполняется поэлементно
+**/
+void WFSTime::toDateTimeBatch(const uint32_t* inPUi32Time, uint32_t inUi32Count, WFSDateTime* outPStDateTime) {
+	uint32_t ui32Index = 0;
+#if defined(WFS_TIME_SSE2) || defined(WFS_TIME_NEON)
+	alignas(16) uint32_t arrYear[4], arrMonth[4], arrDay[4], arrHour[4], arrMinute[4], arrSecond[4];
+	for (; ui32Index + 4 <= inUi32Count; ui32Index += 4) {
+#if defined(WFS_TIME_SSE2)
+		__m128i xmmTime = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inPUi32Time + ui32Index));
+		_mm_store_si128(reinterpret_cast<__m128i*>(arrYear), _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftYear), _mm_set1_epi32(kUi32MaskYear)), _mm_set1_epi32(kUi16BaseYear)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(arrMonth), _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftMonth), _mm_set1_epi32(kUi32MaskMonth)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(arrDay), _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftDay), _mm_set1_epi32(kUi32MaskDay)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(arrHour), _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftHour), _mm_set1_epi32(kUi32MaskHour)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(arrMinute), _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftMinute), _mm_set1_epi32(kUi32MaskMinute)));
+		_mm_store_si128(reinterpret_cast<__m128i*>(arrSecond), _mm_and_si128(xmmTime, _mm_set1_epi32(kUi32MaskSecond)));
+#else
+		uint32x4_t vTime = vld1q_u32(inPUi32Time + ui32Index);
+		vst1q_u32(arrYear, vaddq_u32(vandq_u32(vshrq_n_u32(vTime, kUi32ShiftYear), vdupq_n_u32(kUi32MaskYear)), vdupq_n_u32(kUi16BaseYear)));
+		vst1q_u32(arrMonth, vandq_u32(vshrq_n_u32(vTime, kUi32ShiftMonth), vdupq_n_u32(kUi32MaskMonth)));
+		vst1q_u32(arrDay, vandq_u32(vshrq_n_u32(vTime, kUi32ShiftDay), vdupq_n_u32(kUi32MaskDay)));
+		vst1q_u32(arrHour, vandq_u32(vshrq_n_u32(vTime, kUi32ShiftHour), vdupq_n_u32(kUi32MaskHour)));
+		vst1q_u32(arrMinute, vandq_u32(vshrq_n_u32(vTime, kUi32ShiftMinute), vdupq_n_u32(kUi32MaskMinute)));
+		vst1q_u32(arrSecond, vandq_u32(vTime, vdupq_n_u32(kUi32MaskSecond)));
+#endif
+		for (uint32_t ui32Lane = 0; ui32Lane < 4; ui32Lane++) {
+			WFSDateTime& stDateTime = outPStDateTime[ui32Index + ui32Lane];
+			stDateTime.ui16Year = static_cast<uint16_t>(arrYear[ui32Lane]);
+			stDateTime.ui8Month = static_cast<uint8_t>(arrMonth[ui32Lane]);
+			stDateTime.ui8Day = static_cast<uint8_t>(arrDay[ui32Lane]);
+			stDateTime.ui8Hour = static_cast<uint8_t>(arrHour[ui32Lane]);
+			stDateTime.ui8Minute = static_cast<uint8_t>(arrMinute[ui32Lane]);
+			stDateTime.ui8Second = static_cast<uint8_t>(arrSecond[ui32Lane]);
+		}
+	}
+#endif
+	for (; ui32Index < inUi32Count; ui32Index++) {
+		outPStDateTime[ui32Index] = toDateTime(inPUi32Time[ui32Index]);
+	}
+};
+
+/**
+* \brief
+* Проверяет поля четырёх меток за одну итерацию: каждое поле выделяется сдвигом
+* и маской и сравнивается с границами диапазона, результаты объединяются по "И"
+**/
+void WFSTime::validateBatch(const uint32_t* inPUi32Time, uint32_t inUi32Count, uint8_t* outPUi8Valid) {
+	uint32_t ui32Index = 0;
+#if defined(WFS_TIME_SSE2)
+	// Значения полей малы, поэтому знаковые сравнения SSE2 дают верный результат
+	const __m128i xmmZero = _mm_setzero_si128();
+	for (; ui32Index + 4 <= inUi32Count; ui32Index += 4) {
+		__m128i xmmTime = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inPUi32Time + ui32Index));
+		__m128i xmmMonth = _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftMonth), _mm_set1_epi32(kUi32MaskMonth));
+		__m128i xmmDay = _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftDay), _mm_set1_epi32(kUi32MaskDay));
+		__m128i xmmHour = _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftHour), _mm_set1_epi32(kUi32MaskHour));
+		__m128i xmmMinute = _mm_and_si128(_mm_srli_epi32(xmmTime, kUi32ShiftMinute), _mm_set1_epi32(kUi32MaskMinute));
+		__m128i xmmSecond = _mm_and_si128(xmmTime, _mm_set1_epi32(kUi32MaskSecond));
+
+		__m128i xmmValid = _mm_and_si128(_mm_cmpgt_epi32(xmmMonth, xmmZero), _mm_cmplt_epi32(xmmMonth, _mm_set1_epi32(13)));
+		xmmValid = _mm_and_si128(xmmValid, _mm_cmpgt_epi32(xmmDay, xmmZero));
+		xmmValid = _mm_and_si128(xmmValid, _mm_cmplt_epi32(xmmHour, _mm_set1_epi32(24)));
+		xmmValid = _mm_and_si128(xmmValid, _mm_cmplt_epi32(xmmMinute, _mm_set1_epi32(60)));
+		xmmValid = _mm_and_si128(xmmValid, _mm_cmplt_epi32(xmmSecond, _mm_set1_epi32(60)));
+
+		int iMask = _mm_movemask_ps(_mm_castsi128_ps(xmmValid));
+		for (uint32_t ui32Lane = 0; ui32Lane < 4; ui32Lane++) {
+			outPUi8Valid[ui32Index + ui32Lane] = static_cast<uint8_t>((iMask >> ui32Lane) & 1);
+		}
+	}
+#elif defined(WFS_TIME_NEON)
+	for (; ui32Index + 4 <= inUi32Count; ui32Index += 4) {
+		uint32x4_t vTime = vld1q_u32(inPUi32Time + ui32Index);
+		uint32x4_t vMonth = vandq_u32(vshrq_n_u32(vTime, kUi32ShiftMonth), vdupq_n_u32(kUi32MaskMonth));
+		uint32x4_t vDay = vandq_u32(vshrq_n_u32(vTime, kUi32ShiftDay), vdupq_n_u32(kUi32MaskDay));
+		uint32x4_t vHour = vandq_u32(vshrq_n_u32(vTime, kUi32ShiftHour), vdupq_n_u32(kUi32MaskHour));
+		uint32x4_t vMinute = vandq_u32(vshrq_n_u32(vTime, kUi32ShiftMinute), vdupq_n_u32(kUi32MaskMinute));
+		uint32x4_t vSecond = vandq_u32(vTime, vdupq_n_u32(kUi32MaskSecond));
+
+		// Месяц 1–12: (месяц - 1) < 12 без знака
+		uint32x4_t vValid = vcltq_u32(vsubq_u32(vMonth, vdupq_n_u32(1)), vdupq_n_u32(12));
+		vValid = vandq_u32(vValid, vcgtq_u32(vDay, vdupq_n_u32(0)));
+		vValid = vandq_u32(vValid, vcltq_u32(vHour, vdupq_n_u32(24)));
+		vValid = vandq_u32(vValid, vcltq_u32(vMinute, vdupq_n_u32(60)));
+		vValid = vandq_u32(vValid, vcltq_u32(vSecond, vdupq_n_u32(60)));
+
+		uint32_t arrValid[4];
+		vst1q_u32(arrValid, vValid);
+		for (uint32_t ui32Lane = 0; ui32Lane < 4; ui32Lane++) {
+			outPUi8Valid[ui32Index + ui32Lane] = static_cast<uint8_t>(arrValid[ui32Lane] & 1);
+		}
+	}
+#endif
+	for (; ui32Index < inUi32Count; ui32Index++) {
+		outPUi8Valid[ui32Index] = isValid(inPUi32Time[ui32Index]) ? 1 : 0;
+	}
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+#include "struct_wfs.h"
+
+/*
+* Работа с упакованными временными метками WFS (ГГГГГГ ММММ ДДДДД ччччч мммммм сссссс).
+* Поля упакованной метки расположены от старшего к младшему, поэтому метки сравниваются
+* как обычные числа uint32_t: записи дескрипторов хранят метки в упакованном виде,
+* а в WFSDateTime они разворачиваются только для вывода.
+*/
+class WFSTime {
+public:
+	static constexpr uint32_t kUi32ShiftYear = 26;
+	static constexpr uint32_t kUi32ShiftMonth = 22;
+	static constexpr uint32_t kUi32ShiftDay = 17;
+	static constexpr uint32_t kUi32ShiftHour = 12;
+	static constexpr uint32_t kUi32ShiftMinute = 6;
+	static constexpr uint32_t kUi32ShiftSecond = 0;
+
+	static constexpr uint32_t kUi32MaskYear = 63;		// mask - 111111 6 единиц
+	static constexpr uint32_t kUi32MaskMonth = 15;		// mask - 1111 4 единиц
+	static constexpr uint32_t kUi32MaskDay = 31;		// mask - 11111 5 единиц
+	static constexpr uint32_t kUi32MaskHour = 31;		// mask - 11111 5 единиц
+	static constexpr uint32_t kUi32MaskMinute = 63;		// mask - 111111 6 единиц
+	static constexpr uint32_t kUi32MaskSecond = 63;		// mask - 111111 6 единиц
+
+	static constexpr uint16_t kUi16BaseYear = 2000;
+
+	// Разворачивает упакованную метку в WFSDateTime
+	static WFSDateTime toDateTime(uint32_t inUi32Time);
+
+	// Проверяет допустимость полей упакованной метки
+	static bool isValid(uint32_t inUi32Time);
+
+	// Пакетное преобразование inUi32Count меток
+	static void toDateTimeBatch(const uint32_t* inPUi32Time, uint32_t inUi32Count, WFSDateTime* outPStDateTime);
+
+	// Пакетная проверка inUi32Count меток: outPUi8Valid[i] = 1, если метка допустима, иначе 0
+	static void validateBatch(const uint32_t* inPUi32Time, uint32_t inUi32Count, uint8_t* outPUi8Valid);
+};
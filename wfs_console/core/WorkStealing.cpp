@@ -0,0 +1,138 @@
+#include "WorkStealing.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	// Оставшийся диапазон задач потока. Владелец берёт задачи из начала, другие потоки - из конца
+	struct TaskRange {
+		std::mutex mutex;
+		uint32_t ui32Begin = 0;
+		uint32_t ui32End = 0;
+	};
+}
+
+/**
+* \brief
+* Выполняет inUi32Count задач в inUi32Threads потоках с перераспределением работы.
+*
+* \param
+* uint32_t inUi32Count - количество задач.
+*
+* uint32_t inUi32Threads - количество потоков (включая вызывающий).
+*
+* uint32_t inUi32Grain - количество задач, забираемых потоком из своего диапазона за раз.
+*
+* const std::function<void(uint32_t, uint32_t)>& inFnTask - задача: номер потока и номер задачи.
+**/
+void WorkStealing::run(uint32_t inUi32Count, uint32_t inUi32Threads, uint32_t inUi32Grain, const std::function<void(uint32_t, uint32_t)>& inFnTask) {
+	uint32_t ui32Workers = std::max<uint32_t>(1, std::min(inUi32Threads, inUi32Count));
+	uint32_t ui32Grain = std::max<uint32_t>(1, inUi32Grain);
+	if (ui32Workers == 1) {
+		for (uint32_t ui32Task = 0; ui32Task < inUi32Count; ui32Task++) {
+			inFnTask(0, ui32Task);
+		}
+		return;
+	}
+
+	std::vector<TaskRange> vecRanges(ui32Workers);
+	uint32_t ui32TasksPerWorker = (inUi32Count + ui32Workers - 1) / ui32Workers;
+	for (uint32_t ui32Worker = 0; ui32Worker < ui32Workers; ui32Worker++) {
+		vecRanges[ui32Worker].ui32Begin = std::min(inUi32Count, ui32Worker * ui32TasksPerWorker);
+		vecRanges[ui32Worker].ui32End = std::min(inUi32Count, vecRanges[ui32Worker].ui32Begin + ui32TasksPerWorker);
+	}
+
+	// Забирает порцию задач из начала собственного диапазона
+	auto fnTakeOwn = [&](uint32_t ui32Worker, uint32_t& outUi32Begin, uint32_t& outUi32End) {
+		TaskRange& stRange = vecRanges[ui32Worker];
+		std::lock_guard<std::mutex> lock(stRange.mutex);
+		outUi32Begin = stRange.ui32Begin;
+		outUi32End = std::min(stRange.ui32End, stRange.ui32Begin + ui32Grain);
+		stRange.ui32Begin = outUi32End;
+		return outUi32Begin < outUi32End;
+	};
+
+	// Переносит вторую половину диапазона самого загруженного потока в собственный диапазон
+	auto fnSteal = [&](uint32_t ui32Worker) {
+		for (;;) {
+			uint32_t ui32Victim = ui32Workers;
+			uint32_t ui32VictimSize = 0;
+			for (uint32_t ui32Other = 0; ui32Other < ui32Workers; ui32Other++) {
+				if (ui32Other == ui32Worker) {
+					continue;
+				}
+				std::lock_guard<std::mutex> lock(vecRanges[ui32Other].mutex);
+				uint32_t ui32Size = vecRanges[ui32Other].ui32End - vecRanges[ui32Other].ui32Begin;
+				if (ui32Size > ui32VictimSize) {
+					ui32Victim = ui32Other;
+					ui32VictimSize = ui32Size;
+				}
+			}
+			if (ui32Victim == ui32Workers) {
+				return false;
+			}
+
+			uint32_t ui32StolenBegin = 0;
+			uint32_t ui32StolenEnd = 0;
+			{
+				TaskRange& stVictim = vecRanges[ui32Victim];
+				std::lock_guard<std::mutex> lock(stVictim.mutex);
+				uint32_t ui32Size = stVictim.ui32End - stVictim.ui32Begin;
+				if (ui32Size == 0) {
+					continue;	// Диапазон опустел между поиском и захватом, поиск повторяется
+				}
+				ui32StolenEnd = stVictim.ui32End;
+				ui32StolenBegin = stVictim.ui32End - (ui32Size + 1) / 2;
+				stVictim.ui32End = ui32StolenBegin;
+			}
+
+			TaskRange& stOwn = vecRanges[ui32Worker];
+			std::lock_guard<std::mutex> lock(stOwn.mutex);
+			stOwn.ui32Begin = ui32StolenBegin;
+			stOwn.ui32End = ui32StolenEnd;
+			return true;
+		}
+	};
+
+	auto fnWorker = [&](uint32_t ui32Worker) {
+		uint32_t ui32Begin = 0;
+		uint32_t ui32End = 0;
+		do {
+			while (fnTakeOwn(ui32Worker, ui32Begin, ui32End)) {
+				for (uint32_t ui32Task = ui32Begin; ui32Task < ui32End; ui32Task++) {
+					inFnTask(ui32Worker, ui32Task);
+				}
+			}
+		} while (fnSteal(ui32Worker));
+	};
+
+	std::vector<std::exception_ptr> vecExceptions(ui32Workers);
+	std::vector<std::thread> vecThreads;
+	for (uint32_t ui32Worker = 1; ui32Worker < ui32Workers; ui32Worker++) {
+		vecThreads.emplace_back([&fnWorker, &vecExceptions, ui32Worker]() {
+			try {
+				fnWorker(ui32Worker);
+			}
+			catch (...) {
+				vecExceptions[ui32Worker] = std::current_exception();
+			}
+		});
+	}
+	try {
+		fnWorker(0);
+	}
+	catch (...) {
+		vecExceptions[0] = std::current_exception();
+	}
+	for (std::thread& thread : vecThreads) {
+		thread.join();
+	}
+	for (const std::exception_ptr& pException : vecExceptions) {
+		if (pException) {
+			std::rethrow_exception(pException);
+		}
+	}
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+/*
+* Параллельное выполнение независимых задач с перераспределением работы (work stealing).
+* Диапазон задач [0, inUi32Count) делится поровну между потоками. Поток забирает задачи из
+* начала своего диапазона порциями по inUi32Grain, а опустевший поток забирает вторую половину
+* оставшегося диапазона у самого загруженного потока. Поэтому задачи разной длительности
+* (например, цепочки видеофрагментов разной длины) не задерживают завершение на одном потоке.
+*/
+class WorkStealing {
+public:
+	// Вызывает inFnTask(ui32Worker, ui32Task) для каждой задачи в inUi32Threads потоках.
+	// Исключение задачи пробрасывается после завершения всех потоков
+	static void run(uint32_t inUi32Count, uint32_t inUi32Threads, uint32_t inUi32Grain, const std::function<void(uint32_t, uint32_t)>& inFnTask);
+};
@@ -1,7 +1,8 @@
 #pragma once
 #include <string>
 #include <iostream>
-#include <unordered_map>
+#include <algorithm>
+#include <vector>
 #pragma pack(push, 1)
 
 typedef struct WFSDateTime {
@@ -88,23 +89,40 @@ typedef struct WFSIndexAreaMainDesc {
 };
 static_assert(sizeof(WFSIndexAreaMainDesc) == 32, "WFSIndexAreaMainDesc size mismatch");
 
+/*
+* Смещение дескриптора IndexArea с номером inUi32IndexDesc относительно начала образа
+*/
+inline uint64_t getDescOffset(uint64_t inUi64IndexAreaOffset, uint32_t inUi32IndexDesc) {
+	return inUi64IndexAreaOffset + static_cast<uint64_t>(inUi32IndexDesc) * sizeof(WFSIndexAreaMainDesc);
+}
+
 /*
 * Структура, используемая для хранения данных об основных дескрипторах
-* видеофрагментов в векторе
+* видеофрагментов в векторе. Смещения дескрипторов не хранятся, а вычисляются
+* по номерам методами getOffset*() от смещения IndexArea (WFSAllValue::ui64IndexAreaOffset)
 */
 typedef struct WFSMainDescAdvInfo {
-	uint16_t		ui16CountSecDesc = 0;			//	1	Количество вторичных дескрипторов
-	uint32_t		ui32IndexNextSecDesc;			//	2	Номер следующего вторичного дескриптора
-	uint64_t		ui64OffsetNextSecDesc;			//	3	Вычисляемое поле. Смещение следующего дескриптора относительно начала файла
-	uint32_t		ui32IndexCurrentMainDesc;		//	4	Номер текущего дескриптора. Может браться из значения wfsNumberMainDescriptor или по значению итератора цикла
-	uint64_t		ui64OffsetCurrentMainDesc;		//	5	Вычисляемое поле. Смещение текущего дескриптора относительно начала файла
-	WFSDateTime		stTimeStampStartVideoStream;	//	6	Вычисляемое поле. Структура, содержит значение времени начала видео потока
-	WFSDateTime		stTimeStampEndVideoStream;		//	8	Вычисляемое поле. Структура, содержит значение времени конца видео потока
-	uint16_t		ui16LastVideoFragmentSizeDBS;	//	9	Размер последнего видеофрагмента, измеряемый в количестве дисковых блоков
-	uint8_t			ui8RecordOrderVideo;			//	10	Порядок видеозаписи?
-	uint8_t			ui8CameraNumber;				//	11	Номер камеры
-	bool			bIsAdd = false;					//	12	Данный дескриптор обработан
+	uint32_t		ui32IndexNextSecDesc;			//	1	Номер следующего вторичного дескриптора
+	uint32_t		ui32IndexCurrentMainDesc;		//	2	Номер текущего дескриптора. Может браться из значения wfsNumberMainDescriptor или по значению итератора цикла
+	uint32_t		ui32TimeStampStartVideoStream;	//	3	Упакованная метка времени начала видео потока (формат WFS, сравнивается как число, для вывода - WFSTime::toDateTime)
+	uint32_t		ui32TimeStampEndVideoStream;	//	4	Упакованная метка времени конца видео потока
+	uint16_t		ui16CountSecDesc = 0;			//	5	Количество вторичных дескрипторов
+	uint16_t		ui16LastVideoFragmentSizeDBS;	//	6	Размер последнего видеофрагмента, измеряемый в количестве дисковых блоков
+	uint8_t			ui8RecordOrderVideo;			//	7	Порядок видеозаписи?
+	uint8_t			ui8CameraNumber;				//	8	Номер камеры
+	bool			bIsAdd = false;					//	9	Данный дескриптор обработан
+
+	// Смещение следующего дескриптора относительно начала файла (0, если следующего дескриптора нет)
+	uint64_t getOffsetNextSecDesc(uint64_t inUi64IndexAreaOffset) const {
+		return ui32IndexNextSecDesc == 0xFFFFFFFF ? 0 : getDescOffset(inUi64IndexAreaOffset, ui32IndexNextSecDesc);
+	}
+
+	// Смещение текущего дескриптора относительно начала файла
+	uint64_t getOffsetCurrentMainDesc(uint64_t inUi64IndexAreaOffset) const {
+		return getDescOffset(inUi64IndexAreaOffset, ui32IndexCurrentMainDesc);
+	}
 };
+static_assert(sizeof(WFSMainDescAdvInfo) == 23, "WFSMainDescAdvInfo size mismatch");
 
 /*
 * Структура, используемая для интерпретации данных располагающихся в
@@ -129,37 +147,39 @@ static_assert(sizeof(WFSIndexAreaSecDesc) == 32, "WFSIndexAreaSecDesc size misma
 
 /*
 * Структура, используемая для хранения данных о вторичных дескрипторах
-* видеофрагментов в векторе
+* видеофрагментов в векторе. Смещения дескрипторов вычисляются методами getOffset*()
 */
 typedef struct WFSSecDescAdvInfo {
-	uint16_t		ui16RelativeIndexCurSecDesc;	//	1	Номер текущего вторичного дескриптора из IndexArea относительно MainDesc
+	uint32_t		ui32IndexCurrentSecDesc;		//	1	Номер текущего вторичного дескриптора (номер слота IndexArea)
 	uint32_t		ui32IndexNextSecDesc;			//	2	Номер следующего вторичного дескриптора
-	uint64_t		ui64OffsetNextSecDesc;			//	3	Вычисляемое поле. Смещение следующего дескриптора
-	uint32_t		ui32IndexCurrentSecDesc;		//	4	Номер текущего вторичного дескриптора из на основание значения итератора цикла
-	uint64_t		ui64OffsetCurrentSecDesc;		//	5	Вычисляемое поле. Смещение текущего дескриптора
-	uint32_t		ui32IndexPrevSecDesc;			//	6	Номер предыдущего вторичного дескриптора
-	uint64_t		ui64OffsetPrevSecDesc;			//	7	Вычисляемое поле. Смещение предыдущего вторичного дескриптора
-	WFSDateTime		stTimeStampStartVideoSegment;	//	8	Вычисляемое поле. Структура, содержит значение времени начала видео потока
-	WFSDateTime		stTimeStampEndVideoSegment;		//	9	Вычисляемое поле. Структура, содержит значение времени конца видео потока
-	uint16_t		ui16LastVideoFragmentSizeDBS;	//	10	Размер последнего видеофрагмента измеряемый в количестве дисковых блоков
-	uint32_t		ui32IndexMainDesc;				//	11	Позиция в IndexArea основного дескриптора видео
-	uint64_t		ui64OffsetMainDesc;				//	12	Вычисляемое поле. Смещение текущего дескриптора
-	uint8_t			ui8RecordOrderVideo;			//	13	Порядок видеозаписи?
-	uint8_t			ui8CameraNumber;				//	14	Номер камеры
-	bool			bIsAdd = false;					//	15	Данный дескриптор обработан
-	bool			bIsRecovered = false;			//	16	Данный дескриптор не содержался в основной цепочке
-};
+	uint32_t		ui32IndexPrevSecDesc;			//	3	Номер предыдущего вторичного дескриптора
+	uint32_t		ui32IndexMainDesc;				//	4	Позиция в IndexArea основного дескриптора видео
+	uint32_t		ui32TimeStampStartVideoSegment;	//	5	Упакованная метка времени начала видеофрагмента (формат WFS, сравнивается как число, для вывода - WFSTime::toDateTime)
+	uint32_t		ui32TimeStampEndVideoSegment;	//	6	Упакованная метка времени конца видеофрагмента
+	uint16_t		ui16RelativeIndexCurSecDesc;	//	7	Номер текущего вторичного дескриптора из IndexArea относительно MainDesc
+	uint16_t		ui16LastVideoFragmentSizeDBS;	//	8	Размер последнего видеофрагмента измеряемый в количестве дисковых блоков
+	uint8_t			ui8RecordOrderVideo;			//	9	Порядок видеозаписи?
+	uint8_t			ui8CameraNumber;				//	10	Номер камеры
+	bool			bIsAdd = false;					//	11	Данный дескриптор обработан
+	bool			bIsRecovered = false;			//	12	Данный дескриптор не содержался в основной цепочке
 
-/*
-* Структура, представляющая одну цепочку видеофрагмента.
-* WFSMainDescAdvInfo* pMainDes - указатель на структуру главного дескриптора текущего видеофрагмента
-* std::unordered_map<uint8_t, WFSSecDescAdvInfo*> pSecDes - хеш-таблица указателей на вторичные дескрипторы, 
-* где ключом является, порядковый номер вторичного дескриптора.
-*/
-struct FragmentChain {
-	WFSMainDescAdvInfo* pMainDes = nullptr;
-	std::unordered_map<uint16_t, WFSSecDescAdvInfo*> pSecDes;
+	uint64_t getOffsetCurrentSecDesc(uint64_t inUi64IndexAreaOffset) const {
+		return getDescOffset(inUi64IndexAreaOffset, ui32IndexCurrentSecDesc);
+	}
+
+	uint64_t getOffsetNextSecDesc(uint64_t inUi64IndexAreaOffset) const {
+		return getDescOffset(inUi64IndexAreaOffset, ui32IndexNextSecDesc);
+	}
+
+	uint64_t getOffsetPrevSecDesc(uint64_t inUi64IndexAreaOffset) const {
+		return getDescOffset(inUi64IndexAreaOffset, ui32IndexPrevSecDesc);
+	}
+
+	uint64_t getOffsetMainDesc(uint64_t inUi64IndexAreaOffset) const {
+		return getDescOffset(inUi64IndexAreaOffset, ui32IndexMainDesc);
+	}
 };
+static_assert(sizeof(WFSSecDescAdvInfo) == 32, "WFSSecDescAdvInfo size mismatch");
 
 /*
 * Основная структура, содержащая информацию о WFS
@@ -205,4 +225,45 @@ typedef struct WFSAllValue {
 	uint32_t	ui32CountAnotherDesc = 0;						// Количество других дескрипторов
 	uint32_t	ui32CountAllDesc = 0;							// Количество всех дескрипторов
 };
-#pragma pack(pop)
\ No newline at end of file
+#pragma pack(pop)
+
+/*
+* Структура, представляющая одну цепочку видеофрагмента.
+* WFSMainDescAdvInfo* pMainDes - указатель на структуру главного дескриптора текущего видеофрагмента
+* std::vector<uint32_t> vecSecSlot - номера слотов IndexArea вторичных дескрипторов, где индексом
+* является порядковый номер вторичного дескриптора. Отсутствующие позиции заполнены kUi32NoSlot,
+* запись дескриптора по номеру слота возвращает FileSystem_WFS::getSecDesc().
+* Структура не читается из образа, поэтому объявлена вне #pragma pack.
+*/
+struct FragmentChain {
+	static constexpr uint32_t kUi32NoSlot = 0xFFFFFFFF;
+
+	WFSMainDescAdvInfo* pMainDes = nullptr;
+	std::vector<uint32_t> vecSecSlot;
+
+	// Номер слота SecDesc на позиции inUi16Pos или kUi32NoSlot
+	uint32_t getSecSlot(uint16_t inUi16Pos) const {
+		return inUi16Pos < vecSecSlot.size() ? vecSecSlot[inUi16Pos] : kUi32NoSlot;
+	}
+
+	// Записывает слот SecDesc на позицию inUi16Pos, при необходимости расширяя цепочку пустыми позициями
+	void setSecSlot(uint16_t inUi16Pos, uint32_t inUi32Slot) {
+		if (inUi16Pos >= vecSecSlot.size()) {
+			vecSecSlot.resize(static_cast<size_t>(inUi16Pos) + 1, kUi32NoSlot);
+		}
+		vecSecSlot[inUi16Pos] = inUi32Slot;
+	}
+
+	// Количество заполненных позиций
+	uint32_t countSec() const {
+		return static_cast<uint32_t>(vecSecSlot.size() - std::count(vecSecSlot.begin(), vecSecSlot.end(), kUi32NoSlot));
+	}
+};
+
+/*
+* Расположение одного видеофрагмента цепочки в образе
+*/
+struct FragmentExtent {
+	uint64_t	ui64Offset = 0;		// Смещение видеофрагмента от начала образа
+	uint32_t	ui32Size = 0;		// Объём данных видеофрагмента в байтах
+};
@@ -0,0 +1,124 @@
+#include "AsyncReader.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+/*
+* Пул потоков, выполняющих позиционное чтение IFile::readAt.
+* Каждому из ui32QueueDepth слотов соответствует свой буфер; участок с индексом i
+* читается в слот i % ui32QueueDepth, поэтому поток чтения не может обогнать
+* обработчик больше чем на глубину очереди.
+*/
+class ThreadPoolReader : public AsyncReader {
+public:
+	ThreadPoolReader(IFile& inFile, uint32_t ui32QueueDepth) : file_(inFile), ui32QueueDepth_(std::max<uint32_t>(ui32QueueDepth, 1)) {}
+
+	bool readOrdered(const std::vector<ReadExtent>& vecExtents, const ReadConsumer& fnConsumer) override {
+		if (vecExtents.empty()) {
+			return true;
+		}
+
+		uint64_t ui64MaxSize = 0;
+		for (const ReadExtent& stExtent : vecExtents) {
+			ui64MaxSize = std::max(ui64MaxSize, stExtent.ui64Size);
+		}
+
+		uint32_t ui32Slots = static_cast<uint32_t>(std::min<size_t>(ui32QueueDepth_, vecExtents.size()));
+		std::vector<std::unique_ptr<uint8_t[]>> vecBuffers(ui32Slots);
+		std::vector<bool> vecReady(ui32Slots, false);
+		std::vector<uint64_t> vecBytesRead(ui32Slots, 0);
+		for (auto& pUi8Buffer : vecBuffers) {
+			pUi8Buffer.reset(new uint8_t[ui64MaxSize == 0 ? 1 : ui64MaxSize]);
+		}
+
+		std::mutex mutexState;
+		std::condition_variable cvState;
+		size_t szNextIssue = 0;		// Индекс следующего участка для чтения
+		size_t szConsumed = 0;		// Количество участков, переданных обработчику
+		bool bStop = false;
+		bool bFailed = false;
+
+		auto fnWorker = [&]() {
+			while (true) {
+				size_t szIndex;
+				{
+					std::unique_lock<std::mutex> lock(mutexState);
+					cvState.wait(lock, [&]() { return bStop || szNextIssue >= vecExtents.size() || szNextIssue < szConsumed + ui32Slots; });
+					if (bStop || szNextIssue >= vecExtents.size()) {
+						return;
+					}
+					szIndex = szNextIssue++;
+				}
+
+				uint32_t ui32Slot = static_cast<uint32_t>(szIndex % ui32Slots);
+				uint64_t ui64BytesRead = 0;
+				bool bResult = file_.readAt(vecExtents[szIndex].ui64Offset, vecBuffers[ui32Slot].get(), vecExtents[szIndex].ui64Size, ui64BytesRead);
+
+				std::lock_guard<std::mutex> lock(mutexState);
+				if (!bResult || ui64BytesRead != vecExtents[szIndex].ui64Size) {
+					bFailed = true;
+				}
+				vecBytesRead[ui32Slot] = ui64BytesRead;
+				vecReady[ui32Slot] = true;
+				cvState.notify_all();
+			}
+		};
+
+		std::vector<std::thread> vecThreads;
+		for (uint32_t ui32Iter = 0; ui32Iter < ui32Slots; ui32Iter++) {
+			vecThreads.emplace_back(fnWorker);
+		}
+
+		std::exception_ptr pException;
+		for (size_t szIndex = 0; szIndex < vecExtents.size(); szIndex++) {
+			uint32_t ui32Slot = static_cast<uint32_t>(szIndex % ui32Slots);
+			{
+				std::unique_lock<std::mutex> lock(mutexState);
+				cvState.wait(lock, [&]() { return bFailed || vecReady[ui32Slot]; });
+				if (bFailed) {
+					break;
+				}
+			}
+
+			try {
+				fnConsumer(szIndex, vecBuffers[ui32Slot].get(), vecBytesRead[ui32Slot]);
+			}
+			catch (...) {
+				pException = std::current_exception();
+				break;
+			}
+
+			std::lock_guard<std::mutex> lock(mutexState);
+			vecReady[ui32Slot] = false;
+			szConsumed = szIndex + 1;
+			cvState.notify_all();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutexState);
+			bStop = true;
+			cvState.notify_all();
+		}
+		for (std::thread& thread : vecThreads) {
+			thread.join();
+		}
+
+		if (pException) {
+			std::rethrow_exception(pException);
+		}
+		return !bFailed;
+	}
+
+	const char* name() const override { return "thread-pool"; }
+
+private:
+	IFile& file_;
+	uint32_t ui32QueueDepth_;
+};
+
+std::unique_ptr<AsyncReader> AsyncReader::create(IFile& inFile, uint32_t ui32QueueDepth) {
+	return std::make_unique<ThreadPoolReader>(inFile, ui32QueueDepth);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "IFile.h"
+
+/*
+* Участок образа для асинхронного чтения
+*/
+struct ReadExtent {
+	uint64_t	ui64Offset = 0;		// Смещение участка в образе
+	uint64_t	ui64Size = 0;		// Размер участка в байтах
+};
+
+/*
+* Обработчик прочитанного участка: индекс участка в исходном списке и его данные.
+* Буфер действителен только на время вызова.
+*/
+using ReadConsumer = std::function<void(size_t szIndex, const uint8_t* pUi8Data, uint64_t ui64Size)>;
+
+/*
+* Движок асинхронного чтения набора участков образа.
+* Одновременно выполняется до ui32QueueDepth чтений, а прочитанные участки
+* передаются обработчику строго в порядке списка, поэтому запись выгружаемой
+* цепочки остаётся последовательной, а очередь запросов к диску - глубокой.
+*
+* Реализация ThreadPoolReader - пул потоков, выполняющих IFile::readAt; доступен на всех платформах.
+*/
+class AsyncReader {
+public:
+	virtual ~AsyncReader() = default;
+
+	/*
+	* Читает все участки vecExtents и вызывает fnConsumer для каждого по порядку.
+	* Исключение из fnConsumer прерывает чтение и передаётся вызывающему.
+	* Возвращает false при ошибке или неполном чтении участка.
+	*/
+	virtual bool readOrdered(const std::vector<ReadExtent>& vecExtents, const ReadConsumer& fnConsumer) = 0;
+
+	// Имя движка для вывода диагностической информации
+	virtual const char* name() const = 0;
+
+	/*
+	* Создаёт движок для inFile. inFile должен существовать всё время работы движка.
+	*/
+	static std::unique_ptr<AsyncReader> create(IFile& inFile, uint32_t ui32QueueDepth);
+};
@@ -0,0 +1,293 @@
+#include "CachedFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+CachedFile::CachedFile(std::unique_ptr<IFile> inFile, uint32_t ui32BlockSize, uint64_t ui64Capacity)
+	: inputFile_(std::move(inFile)), ui32BlockSize(std::max<uint32_t>(ui32BlockSize, 512)), ui64Position(0),
+	ui64LastBlock(UINT64_MAX), ui32ReadAheadBlocks(0), ui64Hits(0), ui64Misses(0), ui64ReadAhead(0), ui64Evictions(0), ui64BypassReads(0) {
+	uint64_t ui64TotalBlocks = std::max<uint64_t>(ui64Capacity / this->ui32BlockSize, kUi32ShardCount);
+	ui32BlocksPerShard = static_cast<uint32_t>(ui64TotalBlocks / kUi32ShardCount);
+	// Чтение, занимающее заметную долю кэша, вытеснило бы из него всё полезное
+	ui64BypassSize = std::max<uint64_t>(ui64TotalBlocks * this->ui32BlockSize / 8, this->ui32BlockSize);
+
+	for (uint32_t ui32Iter = 0; ui32Iter < kUi32ShardCount; ui32Iter++) {
+		vecShards.emplace_back(new Shard());
+	}
+};
+
+CachedFile::~CachedFile() {
+	close();
+};
+
+bool CachedFile::open(const std::string& inFilePath) {
+	clear();
+	ui64Position = 0;
+	ui64LastBlock = UINT64_MAX;
+	ui32ReadAheadBlocks = 0;
+	return inputFile_->open(inFilePath);
+};
+
+/**
+* \brief
+* Позиция для read() хранится в декораторе, чтобы последовательное чтение тоже шло через кэш.
+**/
+bool CachedFile::setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) {
+	switch (ui8MoveMethod) {
+		case FILE_ORIGIN_BEGIN: ui64Position = ui64Offset; break;
+		case FILE_ORIGIN_CUR: ui64Position += ui64Offset; break;
+		case FILE_ORIGIN_END: ui64Position = inputFile_->getSize() + ui64Offset; break;
+		default: return false;
+	}
+	return true;
+};
+
+bool CachedFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	uint64_t ui64BytesRead = 0;
+	bool bResult = readAt(ui64Position, ui8Buffer, ui32Size, ui64BytesRead);
+	ui32BytesRead = static_cast<uint32_t>(ui64BytesRead);
+	ui64Position += ui64BytesRead;
+	return bResult;
+};
+
+bool CachedFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	return inputFile_->writeToFile(inFilePath, pUi8Data, inDataSize);
+};
+
+bool CachedFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	return inputFile_->writeToFileAppend(inFilePath, pUi8Data, inDataSize);
+};
+
+void CachedFile::close() {
+	if (inputFile_) {
+		inputFile_->close();
+	}
+	clear();
+};
+
+/**
+* \brief
+* Чтение через кэш. Блоки, уже находящиеся в кэше, копируются из памяти. Начиная с первого
+* отсутствующего блока, весь остаток запроса вместе с окном упреждающего чтения читается
+* с носителя одним вызовом и помещается в кэш.
+**/
+bool CachedFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (ui64Size == 0) {
+		return true;
+	}
+	if (ui64Size >= ui64BypassSize) {
+		ui64BypassReads++;
+		return inputFile_->readAt(ui64Offset, pUi8Buffer, ui64Size, ui64BytesRead);
+	}
+
+	uint64_t ui64FirstBlock = ui64Offset / ui32BlockSize;
+	uint64_t ui64LastBlockInRequest = (ui64Offset + ui64Size - 1) / ui32BlockSize;
+	uint32_t ui32ReadAhead = updateReadAhead(ui64FirstBlock, ui64LastBlockInRequest);
+
+	uint64_t ui64Block = ui64FirstBlock;
+	while (ui64Block <= ui64LastBlockInRequest) {
+		uint32_t ui32ValidSize = 0;
+		if (copyFromCache(ui64Block, ui64Offset, pUi8Buffer, ui64Size, ui32ValidSize)) {
+			ui64Hits++;
+			uint64_t ui64BlockEnd = ui64Block * ui32BlockSize + ui32ValidSize;
+			ui64BytesRead = std::min(ui64BlockEnd, ui64Offset + ui64Size) - ui64Offset;
+			if (ui32ValidSize < ui32BlockSize) {
+				return true;	// Конец файла
+			}
+			ui64Block++;
+			continue;
+		}
+
+		// Промах: остаток запроса и окно упреждающего чтения читаются одним вызовом
+		uint64_t ui64RunBlocks = ui64LastBlockInRequest - ui64Block + 1 + ui32ReadAhead;
+		uint64_t ui64RunOffset = ui64Block * ui32BlockSize;
+		std::unique_ptr<uint8_t[]> pUi8Run(new uint8_t[ui64RunBlocks * ui32BlockSize]);
+		uint64_t ui64RunRead = 0;
+		if (!inputFile_->readAt(ui64RunOffset, pUi8Run.get(), ui64RunBlocks * ui32BlockSize, ui64RunRead)) {
+			return false;
+		}
+
+		/*
+		* Неполный блок при попадании считается концом файла, поэтому он помещается в кэш, только
+		* если действительно заканчивается в конце файла: короткое чтение внутри файла (например,
+		* прерванное) повторяется при следующем обращении
+		*/
+		bool bIsShortAtEnd = ui64RunRead % ui32BlockSize != 0 && ui64RunOffset + ui64RunRead == inputFile_->getSize();
+		for (uint64_t ui64Iter = 0; ui64Iter < ui64RunBlocks && ui64Iter * ui32BlockSize < ui64RunRead; ui64Iter++) {
+			uint32_t ui32BlockValid = static_cast<uint32_t>(std::min<uint64_t>(ui64RunRead - ui64Iter * ui32BlockSize, ui32BlockSize));
+			if (ui32BlockValid < ui32BlockSize && !bIsShortAtEnd) {
+				break;
+			}
+			insertBlock(ui64Block + ui64Iter, pUi8Run.get() + ui64Iter * ui32BlockSize, ui32BlockValid);
+		}
+		ui64Misses += std::min<uint64_t>(ui64LastBlockInRequest - ui64Block + 1, (ui64RunRead + ui32BlockSize - 1) / ui32BlockSize);
+		if (ui64RunRead > (ui64LastBlockInRequest - ui64Block + 1) * ui32BlockSize) {
+			ui64ReadAhead += (ui64RunRead - (ui64LastBlockInRequest - ui64Block + 1) * ui32BlockSize + ui32BlockSize - 1) / ui32BlockSize;
+		}
+
+		// Данные копируются из прочитанного участка, а не из кэша: блоки могли быть уже вытеснены
+		uint64_t ui64CopyFrom = std::max(ui64Offset, ui64RunOffset);
+		uint64_t ui64CopyTo = std::min(ui64Offset + ui64Size, ui64RunOffset + ui64RunRead);
+		if (ui64CopyTo > ui64CopyFrom) {
+			std::memcpy(pUi8Buffer + (ui64CopyFrom - ui64Offset), pUi8Run.get() + (ui64CopyFrom - ui64RunOffset), static_cast<size_t>(ui64CopyTo - ui64CopyFrom));
+			ui64BytesRead = ui64CopyTo - ui64Offset;
+		}
+		return true;
+	}
+	return true;
+};
+
+bool CachedFile::readv(std::vector<ReadRequest>& vecRequests) {
+	bool bResult = true;
+	for (ReadRequest& stRequest : vecRequests) {
+		if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+			bResult = false;
+		}
+	}
+	return bResult;
+};
+
+ByteView CachedFile::view(uint64_t ui64Offset, uint64_t ui64Length) {
+	return inputFile_->view(ui64Offset, ui64Length);
+};
+
+/**
+* \brief
+* Подсказка DontNeed, кроме передачи нижележащему файлу, удаляет из кэша блоки участка:
+* данные образа, в который продолжается запись, после этого будут прочитаны с носителя заново.
+**/
+void CachedFile::advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) {
+	if (eHint == FileAccessHint::DontNeed && ui64Length != 0) {
+		uint64_t ui64LastBlockInRange = (ui64Offset + ui64Length - 1) / ui32BlockSize;
+		for (uint64_t ui64Block = ui64Offset / ui32BlockSize; ui64Block <= ui64LastBlockInRange; ui64Block++) {
+			Shard& shard = shardOf(ui64Block);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			auto iterBlock = shard.mapBlocks.find(ui64Block);
+			if (iterBlock != shard.mapBlocks.end()) {
+				shard.listLru.erase(iterBlock->second.iterLru);
+				shard.mapBlocks.erase(iterBlock);
+			}
+		}
+	}
+	inputFile_->advise(ui64Offset, ui64Length, eHint);
+};
+
+int CachedFile::getNativeDescriptor() const {
+	return inputFile_->getNativeDescriptor();
+};
+
+void CachedFile::recordKernelRead(uint64_t ui64Offset, uint64_t ui64Size, uint64_t ui64Ns) {
+	inputFile_->recordKernelRead(ui64Offset, ui64Size, ui64Ns);
+};
+
+uint64_t CachedFile::getSize() {
+	return inputFile_->getSize();
+};
+
+uint64_t CachedFile::getModificationTime() {
+	return inputFile_->getModificationTime();
+};
+
+void CachedFile::setBlockSizeHint(uint32_t ui32BlockSize) {
+	inputFile_->setBlockSizeHint(ui32BlockSize);
+};
+
+CacheStats CachedFile::getStats() const {
+	CacheStats stStats;
+	stStats.ui64Hits = ui64Hits;
+	stStats.ui64Misses = ui64Misses;
+	stStats.ui64ReadAheadBlocks = ui64ReadAhead;
+	stStats.ui64Evictions = ui64Evictions;
+	stStats.ui64BypassReads = ui64BypassReads;
+	return stStats;
+};
+
+void CachedFile::clear() {
+	for (std::unique_ptr<Shard>& pShard : vecShards) {
+		std::lock_guard<std::mutex> lock(pShard->mutex);
+		pShard->mapBlocks.clear();
+		pShard->listLru.clear();
+	}
+};
+
+/**
+* \brief
+* Определяет окно упреждающего чтения для очередного запроса.
+* Запрос, продолжающий предыдущий (тот же или следующий блок), удваивает окно,
+* любой другой запрос сбрасывает его.
+* \param[in] ui64FirstBlock			первый блок запроса
+* \param[in] ui64LastBlockInRequest	последний блок запроса
+* \return количество блоков, которые следует прочитать упреждающе при промахе
+**/
+uint32_t CachedFile::updateReadAhead(uint64_t ui64FirstBlock, uint64_t ui64LastBlockInRequest) {
+	uint64_t ui64Previous = ui64LastBlock.exchange(ui64LastBlockInRequest);
+	if (ui64Previous != UINT64_MAX && (ui64FirstBlock == ui64Previous || ui64FirstBlock == ui64Previous + 1)) {
+		uint32_t ui32Current = ui32ReadAheadBlocks;
+		uint32_t ui32Next = (ui32Current == 0) ? 1 : std::min<uint32_t>(ui32Current * 2, std::min<uint32_t>(kUi32MaxReadAheadBlocks, ui32BlocksPerShard));
+		ui32ReadAheadBlocks = ui32Next;
+		return ui32Next;
+	}
+	ui32ReadAheadBlocks = 0;
+	return 0;
+};
+
+/**
+* \brief
+* Копирует из блока ui64Block часть, пересекающуюся с запросом, и помечает блок как недавно использованный
+* \param[in] ui64Block		номер блока
+* \param[in] ui64Offset		смещение запроса в файле
+* \param[out] pUi8Buffer	буфер запроса
+* \param[in] ui64Size		размер запроса
+* \param[out] ui32ValidSize	объём данных в блоке
+* \return true, если блок находится в кэше
+**/
+bool CachedFile::copyFromCache(uint64_t ui64Block, uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint32_t& ui32ValidSize) {
+	Shard& stShard = shardOf(ui64Block);
+	std::lock_guard<std::mutex> lock(stShard.mutex);
+
+	auto iterBlock = stShard.mapBlocks.find(ui64Block);
+	if (iterBlock == stShard.mapBlocks.end()) {
+		return false;
+	}
+	CacheBlock& stBlock = iterBlock->second;
+	stShard.listLru.splice(stShard.listLru.begin(), stShard.listLru, stBlock.iterLru);
+
+	ui32ValidSize = stBlock.ui32ValidSize;
+	uint64_t ui64BlockOffset = ui64Block * ui32BlockSize;
+	uint64_t ui64CopyFrom = std::max(ui64Offset, ui64BlockOffset);
+	uint64_t ui64CopyTo = std::min(ui64Offset + ui64Size, ui64BlockOffset + stBlock.ui32ValidSize);
+	if (ui64CopyTo > ui64CopyFrom) {
+		std::memcpy(pUi8Buffer + (ui64CopyFrom - ui64Offset), stBlock.pUi8Data.get() + (ui64CopyFrom - ui64BlockOffset), static_cast<size_t>(ui64CopyTo - ui64CopyFrom));
+	}
+	return true;
+};
+
+/**
+* \brief
+* Помещает блок в кэш, при переполнении сегмента вытесняя давно не использованные блоки.
+* Блок, уже находящийся в кэше (прочитанный параллельно другим потоком), не заменяется.
+**/
+void CachedFile::insertBlock(uint64_t ui64Block, const uint8_t* pUi8Data, uint32_t ui32ValidSize) {
+	Shard& stShard = shardOf(ui64Block);
+	std::lock_guard<std::mutex> lock(stShard.mutex);
+
+	auto iterBlock = stShard.mapBlocks.find(ui64Block);
+	if (iterBlock != stShard.mapBlocks.end()) {
+		stShard.listLru.splice(stShard.listLru.begin(), stShard.listLru, iterBlock->second.iterLru);
+		return;
+	}
+
+	while (stShard.mapBlocks.size() >= ui32BlocksPerShard && !stShard.listLru.empty()) {
+		stShard.mapBlocks.erase(stShard.listLru.back());
+		stShard.listLru.pop_back();
+		ui64Evictions++;
+	}
+
+	stShard.listLru.push_front(ui64Block);
+	CacheBlock& stBlock = stShard.mapBlocks[ui64Block];
+	stBlock.iterLru = stShard.listLru.begin();
+	stBlock.pUi8Data.reset(new uint8_t[ui32ValidSize]);
+	stBlock.ui32ValidSize = ui32ValidSize;
+	std::memcpy(stBlock.pUi8Data.get(), pUi8Data, ui32ValidSize);
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IFile.h"
+
+/*
+* Счётчики работы кэша CachedFile
+*/
+struct CacheStats {
+	uint64_t	ui64Hits = 0;				// Блоков прочитано из кэша
+	uint64_t	ui64Misses = 0;				// Блоков прочитано с носителя по запросу
+	uint64_t	ui64ReadAheadBlocks = 0;	// Блоков прочитано упреждающе
+	uint64_t	ui64Evictions = 0;			// Блоков вытеснено из кэша
+	uint64_t	ui64BypassReads = 0;		// Крупных чтений, выполненных в обход кэша
+};
+
+/*
+* Декоратор IFile с кэшем блоков фиксированного размера.
+* Небольшие разрозненные чтения (readStruct, дескрипторы для шестнадцатеричного дампа,
+* повторное раскрытие цепочек в GUI) обслуживаются из памяти, а с носителя данные
+* читаются блоками ui32BlockSize. Это особенно важно для USB-дисков, где случайное
+* чтение 512 байт обходится очень дорого.
+*
+* Кэш ограничен объёмом ui64Capacity и разбит на kUi32ShardCount сегментов с отдельными
+* блокировками и собственным списком LRU, поэтому readAt остаётся потокобезопасным.
+* При последовательном доступе окно упреждающего чтения удваивается при каждом промахе
+* (до kUi32MaxReadAheadBlocks блоков), при произвольном доступе сбрасывается.
+* Чтения объёмом не меньше ui64BypassSize (разбор IndexArea, выгрузка видеофрагментов)
+* выполняются в обход кэша, чтобы не вытеснять из него полезные данные.
+*/
+class CachedFile : public IFile {
+public:
+	static constexpr uint32_t kUi32DefaultBlockSize = 0x10000;		// 64 КБ
+	static constexpr uint64_t kUi64DefaultCapacity = 0x4000000;		// 64 МБ
+
+	explicit CachedFile(std::unique_ptr<IFile> inFile, uint32_t ui32BlockSize = kUi32DefaultBlockSize, uint64_t ui64Capacity = kUi64DefaultCapacity);
+	~CachedFile();
+
+	bool open(const std::string& inFilePath) override;
+	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
+	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+
+	ByteView view(uint64_t ui64Offset, uint64_t ui64Length) override;
+	void advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) override;
+	int getNativeDescriptor() const override;
+	void recordKernelRead(uint64_t ui64Offset, uint64_t ui64Size, uint64_t ui64Ns) override;
+	void setBlockSizeHint(uint32_t ui32BlockSize) override;
+	uint64_t getSize() override;
+	uint64_t getModificationTime() override;
+
+	// Текущие значения счётчиков
+	CacheStats getStats() const;
+
+	// Удаляет все блоки из кэша
+	void clear();
+
+private:
+	static constexpr uint32_t kUi32ShardCount = 16;
+	static constexpr uint32_t kUi32MaxReadAheadBlocks = 32;
+
+	struct CacheBlock {
+		std::list<uint64_t>::iterator iterLru;		// Позиция в списке LRU сегмента
+		std::unique_ptr<uint8_t[]> pUi8Data;
+		uint32_t ui32ValidSize = 0;					// Меньше размера блока только для последнего блока файла
+	};
+
+	struct Shard {
+		std::mutex mutex;
+		std::list<uint64_t> listLru;				// Номера блоков, от недавно использованных к давно использованным
+		std::unordered_map<uint64_t, CacheBlock> mapBlocks;
+	};
+
+	std::unique_ptr<IFile> inputFile_;
+	uint32_t ui32BlockSize;
+	uint32_t ui32BlocksPerShard;
+	uint64_t ui64BypassSize;
+	uint64_t ui64Position;
+	std::vector<std::unique_ptr<Shard>> vecShards;
+
+	std::atomic<uint64_t> ui64LastBlock;			// Последний блок предыдущего чтения (для определения последовательного доступа)
+	std::atomic<uint32_t> ui32ReadAheadBlocks;		// Текущее окно упреждающего чтения
+
+	std::atomic<uint64_t> ui64Hits;
+	std::atomic<uint64_t> ui64Misses;
+	std::atomic<uint64_t> ui64ReadAhead;
+	std::atomic<uint64_t> ui64Evictions;
+	std::atomic<uint64_t> ui64BypassReads;
+
+	Shard& shardOf(uint64_t ui64Block) { return *vecShards[ui64Block % kUi32ShardCount]; }
+	uint32_t updateReadAhead(uint64_t ui64FirstBlock, uint64_t ui64LastBlockInRequest);
+	bool copyFromCache(uint64_t ui64Block, uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint32_t& ui32ValidSize);
+	void insertBlock(uint64_t ui64Block, const uint8_t* pUi8Data, uint32_t ui32ValidSize);
+};
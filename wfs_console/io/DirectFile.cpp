@@ -0,0 +1,258 @@
+#if defined(__linux__)
+#include "DirectFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <linux/fs.h>
+
+DirectFile::DirectFile() : ui32Alignment(512), ui32BufferSize(kUi32DefaultBufferSize) {};
+
+DirectFile::~DirectFile() {
+	close();
+};
+
+bool DirectFile::open(const std::string& inFilePath) {
+	if (inFilePath.empty()) return false;
+
+	close();
+
+	fileDescriptor = ::open(inFilePath.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC | O_LARGEFILE);
+	if (fileDescriptor < 0) {
+		return false;	// В том числе EINVAL, если файловая система не поддерживает O_DIRECT
+	}
+
+	/*
+	* Для блочного устройства выравнивание равно размеру логического сектора.
+	* Для файла-образа требование зависит от файловой системы, поэтому используется
+	* размер страницы, который удовлетворяет всем распространённым файловым системам
+	*/
+	ui32Alignment = static_cast<uint32_t>(sysconf(_SC_PAGESIZE));
+	struct stat stFileStat;
+	if (fstat(fileDescriptor, &stFileStat) == 0 && S_ISBLK(stFileStat.st_mode)) {
+		int iLogicalSectorSize = 0;
+		if (ioctl(fileDescriptor, BLKSSZGET, &iLogicalSectorSize) == 0 && iLogicalSectorSize > 0) {
+			ui32Alignment = static_cast<uint32_t>(iLogicalSectorSize);
+		}
+	}
+	ui32BufferSize = ((kUi32DefaultBufferSize + ui32Alignment - 1) / ui32Alignment) * ui32Alignment;
+	ui64Position = 0;
+	return true;
+};
+
+bool DirectFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	uint64_t ui64BytesRead = 0;
+	bool bResult = readAt(ui64Position, ui8Buffer, ui32Size, ui64BytesRead);
+	ui32BytesRead = static_cast<uint32_t>(ui64BytesRead);
+	ui64Position += ui64BytesRead;
+	return bResult;
+};
+
+void DirectFile::close() {
+	PosixFile::close();
+	freePool();
+};
+
+/**
+* \brief
+* Позиционное чтение в обход страничного кэша.
+* Выровненный запрос читается напрямую в буфер вызывающего. Невыровненный запрос
+* расширяется до границ секторов и читается в буферы пула (до kUi32MaxBatchBuffers
+* буферов за один вызов preadv64), после чего нужная часть копируется в pUi8Buffer.
+**/
+bool DirectFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (fileDescriptor < 0) {
+		return false;
+	}
+	if (ui64Size == 0) {
+		return true;
+	}
+
+	if (ui64Offset % ui32Alignment == 0 && ui64Size % ui32Alignment == 0 && reinterpret_cast<uintptr_t>(pUi8Buffer) % ui32Alignment == 0) {
+		return readDirect(ui64Offset, pUi8Buffer, ui64Size, ui64BytesRead);
+	}
+
+	uint64_t ui64AlignedStart = ui64Offset - (ui64Offset % ui32Alignment);
+	uint64_t ui64RequestEnd = ui64Offset + ui64Size;
+	uint64_t ui64AlignedEnd = ((ui64RequestEnd + ui32Alignment - 1) / ui32Alignment) * ui32Alignment;
+
+	uint32_t ui32LocBufferSize;
+	{
+		std::lock_guard<std::mutex> lock(mutexPool);
+		ui32LocBufferSize = ui32BufferSize;
+	}
+
+	uint64_t ui64NeedBuffers = (ui64AlignedEnd - ui64AlignedStart + ui32LocBufferSize - 1) / ui32LocBufferSize;
+	uint32_t ui32CountBuffers = static_cast<uint32_t>(std::min<uint64_t>(ui64NeedBuffers, kUi32MaxBatchBuffers));
+
+	std::vector<uint8_t*> vecBuffers;
+	vecBuffers.reserve(ui32CountBuffers);
+	for (uint32_t ui32Iter = 0; ui32Iter < ui32CountBuffers; ui32Iter++) {
+		uint8_t* pUi8PoolBuffer = acquireBuffer(ui32LocBufferSize);
+		if (pUi8PoolBuffer == nullptr) {
+			for (uint8_t* pUi8Acquired : vecBuffers) {
+				releaseBuffer(pUi8Acquired, ui32LocBufferSize);
+			}
+			return false;
+		}
+		vecBuffers.push_back(pUi8PoolBuffer);
+	}
+
+	bool bResult = true;
+	std::vector<struct iovec> vecIov(ui32CountBuffers);
+	uint64_t ui64CurOffset = ui64AlignedStart;
+	while (ui64CurOffset < ui64AlignedEnd) {
+		uint64_t ui64BatchSize = std::min<uint64_t>(ui64AlignedEnd - ui64CurOffset, static_cast<uint64_t>(ui32CountBuffers) * ui32LocBufferSize);
+		uint32_t ui32BatchBuffers = static_cast<uint32_t>((ui64BatchSize + ui32LocBufferSize - 1) / ui32LocBufferSize);
+		for (uint32_t ui32Iter = 0; ui32Iter < ui32BatchBuffers; ui32Iter++) {
+			vecIov[ui32Iter].iov_base = vecBuffers[ui32Iter];
+			vecIov[ui32Iter].iov_len = static_cast<size_t>(std::min<uint64_t>(ui32LocBufferSize, ui64BatchSize - static_cast<uint64_t>(ui32Iter) * ui32LocBufferSize));
+		}
+
+		ssize_t iResultRead;
+		do {
+			iResultRead = preadv64(fileDescriptor, vecIov.data(), static_cast<int>(ui32BatchBuffers), static_cast<off64_t>(ui64CurOffset));
+		} while (iResultRead < 0 && errno == EINTR);
+		if (iResultRead < 0) {
+			bResult = false;
+			break;
+		}
+		if (iResultRead == 0) {
+			break;	// Конец файла
+		}
+
+		// Копирование пересечения прочитанного участка с запрошенным
+		uint64_t ui64ReadEnd = ui64CurOffset + static_cast<uint64_t>(iResultRead);
+		uint64_t ui64CopyFrom = std::max(ui64CurOffset, ui64Offset);
+		uint64_t ui64CopyTo = std::min(ui64ReadEnd, ui64RequestEnd);
+		uint64_t ui64Pos = ui64CopyFrom;
+		while (ui64Pos < ui64CopyTo) {
+			uint64_t ui64InBatch = ui64Pos - ui64CurOffset;
+			uint64_t ui64InBuffer = ui64InBatch % ui32LocBufferSize;
+			uint64_t ui64Count = std::min<uint64_t>(ui32LocBufferSize - ui64InBuffer, ui64CopyTo - ui64Pos);
+			std::memcpy(pUi8Buffer + (ui64Pos - ui64Offset), vecBuffers[ui64InBatch / ui32LocBufferSize] + ui64InBuffer, static_cast<size_t>(ui64Count));
+			ui64Pos += ui64Count;
+		}
+		if (ui64CopyTo > ui64Offset) {
+			ui64BytesRead = ui64CopyTo - ui64Offset;
+		}
+
+		if (static_cast<uint64_t>(iResultRead) < ui64BatchSize) {
+			break;	// Конец файла внутри пакета
+		}
+		ui64CurOffset = ui64ReadEnd;
+	}
+
+	for (uint8_t* pUi8Acquired : vecBuffers) {
+		releaseBuffer(pUi8Acquired, ui32LocBufferSize);
+	}
+	return bResult;
+};
+
+bool DirectFile::readv(std::vector<ReadRequest>& vecRequests) {
+	bool bResult = true;
+	for (ReadRequest& stRequest : vecRequests) {
+		if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+			bResult = false;
+		}
+	}
+	return bResult;
+};
+
+/**
+* \brief
+* Подсказки страничному кэшу не имеют смысла при чтении в обход кэша, поэтому игнорируются.
+**/
+void DirectFile::advise(uint64_t /*ui64Offset*/, uint64_t /*ui64Length*/, FileAccessHint /*eHint*/) {
+};
+
+/**
+* \brief
+* Устанавливает размер буферов пула равным размеру дискового блока WFS (с округлением
+* вверх до кратного размеру сектора). Вызывается один раз после чтения SuperBlock,
+* до начала параллельного чтения; буферы прежнего размера освобождаются.
+**/
+void DirectFile::setBlockSizeHint(uint32_t ui32BlockSize) {
+	if (ui32BlockSize == 0) {
+		return;
+	}
+	uint32_t ui32NewBufferSize = ((std::max(ui32BlockSize, ui32Alignment) + ui32Alignment - 1) / ui32Alignment) * ui32Alignment;
+
+	std::lock_guard<std::mutex> lock(mutexPool);
+	if (ui32NewBufferSize == ui32BufferSize) {
+		return;
+	}
+	for (uint8_t* pUi8Buffer : vecFreeBuffers) {
+		free(pUi8Buffer);
+	}
+	vecFreeBuffers.clear();
+	ui32BufferSize = ui32NewBufferSize;
+};
+
+uint8_t* DirectFile::acquireBuffer(uint32_t inUi32BufferSize) {
+	{
+		std::lock_guard<std::mutex> lock(mutexPool);
+		if (inUi32BufferSize == ui32BufferSize && !vecFreeBuffers.empty()) {
+			uint8_t* pUi8Buffer = vecFreeBuffers.back();
+			vecFreeBuffers.pop_back();
+			return pUi8Buffer;
+		}
+	}
+
+	void* pBuffer = nullptr;
+	if (posix_memalign(&pBuffer, ui32Alignment, inUi32BufferSize) != 0) {
+		return nullptr;
+	}
+	return static_cast<uint8_t*>(pBuffer);
+};
+
+void DirectFile::releaseBuffer(uint8_t* pUi8Buffer, uint32_t inUi32BufferSize) {
+	{
+		std::lock_guard<std::mutex> lock(mutexPool);
+		// Буфер прежнего размера (после setBlockSizeHint) в пул не возвращается
+		if (inUi32BufferSize == ui32BufferSize) {
+			vecFreeBuffers.push_back(pUi8Buffer);
+			return;
+		}
+	}
+	free(pUi8Buffer);
+};
+
+void DirectFile::freePool() {
+	std::lock_guard<std::mutex> lock(mutexPool);
+	for (uint8_t* pUi8Buffer : vecFreeBuffers) {
+		free(pUi8Buffer);
+	}
+	vecFreeBuffers.clear();
+};
+
+/**
+* \brief
+* Чтение выровненного участка напрямую в буфер вызывающего.
+**/
+bool DirectFile::readDirect(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	while (ui64BytesRead < ui64Size) {
+		size_t szChunk = static_cast<size_t>(std::min<uint64_t>(ui64Size - ui64BytesRead, kUi64MaxChunk));
+		ssize_t iResultRead = pread64(fileDescriptor, pUi8Buffer + ui64BytesRead, szChunk, static_cast<off64_t>(ui64Offset + ui64BytesRead));
+		if (iResultRead < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (iResultRead == 0) {
+			break;	// Конец файла
+		}
+		ui64BytesRead += static_cast<uint64_t>(iResultRead);
+		if (ui64BytesRead % ui32Alignment != 0) {
+			break;	// Неполный последний сектор возможен только в конце файла
+		}
+	}
+	return true;
+};
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+#if defined(__linux__)
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "PosixFile.h"
+
+/*
+* Реализация IFile для Linux с небуферизованным чтением (O_DIRECT).
+* Данные читаются с устройства в обход страничного кэша, поэтому обработка
+* больших дисков не вытесняет из памяти данные других процессов.
+*
+* O_DIRECT требует, чтобы смещение, размер и адрес буфера были кратны размеру
+* логического сектора. Невыровненные запросы расширяются до границ секторов
+* и читаются в буферы из пула выровненных буферов размером ui32DiskBlockSize
+* (задаётся через setBlockSizeHint), после чего нужная часть копируется
+* в буфер вызывающего. Полностью выровненные запросы читаются напрямую.
+* Запись выгружаемых файлов выполняется как в PosixFile.
+*/
+class DirectFile : public PosixFile {
+public:
+	DirectFile();
+	~DirectFile();
+
+	bool open(const std::string& inFilePath) override;
+	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
+	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+
+	void advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) override;
+	void setBlockSizeHint(uint32_t ui32BlockSize) override;
+
+private:
+	static constexpr uint32_t kUi32DefaultBufferSize = 0x10000;	// Размер буфера пула до получения размера дискового блока (64 КБ)
+	static constexpr uint32_t kUi32MaxBatchBuffers = 64;			// Максимальное количество буферов пула в одном вызове preadv64
+
+	uint32_t ui32Alignment;						// Размер логического сектора (требование выравнивания O_DIRECT)
+	uint32_t ui32BufferSize;					// Размер буфера пула, кратный ui32Alignment
+	std::mutex mutexPool;						// Защита пула при одновременном чтении из нескольких потоков
+	std::vector<uint8_t*> vecFreeBuffers;		// Свободные буферы пула
+
+	uint8_t* acquireBuffer(uint32_t inUi32BufferSize);
+	void releaseBuffer(uint8_t* pUi8Buffer, uint32_t inUi32BufferSize);
+	void freePool();
+	bool readDirect(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead);
+};
+#endif
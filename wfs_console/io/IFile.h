@@ -1,5 +1,8 @@
 #pragma once
 #include <cstdint>
+#include <string>
+#include <memory>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -13,14 +16,84 @@
 #define FILE_ORIGIN_END   SEEK_END
 #endif
 
+/*
+* Участок данных файла, доступный только для чтения без копирования
+* (например, страницы отображённого в память образа).
+* Пустой ByteView означает, что источник не поддерживает прямой доступ к данным.
+*/
+struct ByteView {
+	const uint8_t*	pData = nullptr;
+	uint64_t		ui64Size = 0;
+
+	bool empty() const { return pData == nullptr; }
+};
+
+/*
+* Подсказки о характере доступа к участку файла (аналог madvise)
+*/
+enum class FileAccessHint : uint8_t {
+	Normal,		// Обычный доступ
+	Sequential,	// Последовательное чтение, агрессивное упреждающее чтение
+	WillNeed,	// Участок понадобится в ближайшее время
+	DontNeed	// Участок больше не нужен, страницы можно освободить
+};
+
+/*
+* Элемент пакетного позиционного чтения (readv)
+*/
+struct ReadRequest {
+	uint64_t	ui64Offset = 0;			// Смещение в файле
+	uint8_t*	pUi8Buffer = nullptr;	// Буфер назначения
+	uint64_t	ui64Size = 0;			// Запрошенный объём в байтах
+	uint64_t	ui64BytesRead = 0;		// Фактически прочитанный объём (заполняется реализацией)
+};
+
 class IFile {
 public:
 	virtual ~IFile() = default;
 
 	virtual bool open(const std::string& inFilePath) = 0;
 	virtual bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod = FILE_ORIGIN_BEGIN) = 0;
+	/*
+	* Чтение с текущей позиции. false возвращается только при ошибке ввода-вывода; при достижении
+	* конца файла возвращается true и ui32BytesRead меньше ui32Size, поэтому вызывающий проверяет объём
+	*/
 	virtual bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) = 0;
-	virtual bool writeToFile(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pData, size_t dataSize) = 0;
-	virtual bool writeToFileAppend(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pData, size_t dataSize) = 0;
+	virtual bool writeToFile(const std::string& inFilePath, const uint8_t* pData, size_t dataSize) = 0;
+	virtual bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pData, size_t dataSize) = 0;
 	virtual void close() = 0;
+
+	/*
+	* Позиционное чтение. Не использует и не изменяет текущую позицию (setPosition), поэтому
+	* несколько потоков могут одновременно читать один открытый образ без внешней блокировки.
+	* Объём одного чтения не ограничен 4 ГБ. При достижении конца файла ui64BytesRead меньше ui64Size.
+	*/
+	virtual bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) = 0;
+
+	// Пакетное позиционное чтение. Возвращает false, если хотя бы один элемент прочитать не удалось
+	virtual bool readv(std::vector<ReadRequest>& vecRequests) = 0;
+
+	// Прямой доступ к данным без копирования. По умолчанию не поддерживается
+	virtual ByteView view(uint64_t /*ui64Offset*/, uint64_t /*ui64Length*/) { return ByteView{}; }
+
+	// Подсказка о предстоящем характере доступа к участку файла (нулевая длина - до конца файла). По умолчанию игнорируется
+	virtual void advise(uint64_t /*ui64Offset*/, uint64_t /*ui64Length*/, FileAccessHint /*eHint*/) {}
+
+	// Дескриптор POSIX открытого образа для асинхронного и ядерного ввода-вывода (-1, если недоступен)
+	virtual int getNativeDescriptor() const { return -1; }
+
+	/*
+	* Учёт данных образа, прочитанных ядром по дескриптору getNativeDescriptor() в обход методов
+	* чтения (copy_file_range, splice): вызывается тем, кто выполнил копирование. По умолчанию игнорируется
+	*/
+	virtual void recordKernelRead(uint64_t /*ui64Offset*/, uint64_t /*ui64Size*/, uint64_t /*ui64Ns*/) {}
+
+	// Размер открытого файла или устройства в байтах (0, если неизвестен). По умолчанию неизвестен
+	virtual uint64_t getSize() { return 0; }
+
+	// Время последнего изменения файла в наносекундах от начала эпохи (0, если неизвестно). По умолчанию неизвестно
+	virtual uint64_t getModificationTime() { return 0; }
+
+	// Размер дискового блока файловой системы (ui32DiskBlockSize), известный после чтения SuperBlock. По умолчанию игнорируется
+	virtual void setBlockSizeHint(uint32_t /*ui32BlockSize*/) {}
 };
\ No newline at end of file
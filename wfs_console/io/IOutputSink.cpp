@@ -0,0 +1,111 @@
+#include "IOutputSink.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include "WinOutputSink.h"
+#else
+#include "PosixOutputSink.h"
+#endif
+
+bool IOutputSink::open(const std::string& inFilePath, uint64_t ui64ExpectedSize) {
+	if (bOpen) {
+		close();
+	}
+	if (!openRaw(inFilePath, ui64ExpectedSize)) {
+		return false;
+	}
+	if (!pUi8Coalesce) {
+		pUi8Coalesce.reset(new uint8_t[kUi32CoalesceSize]);
+	}
+	szCoalesceUsed = 0;
+	ui64FileOffset = 0;
+	ui64BytesWritten = 0;
+	bOpen = true;
+	return true;
+}
+
+/**
+* \brief
+* Добавляет данные в конец файла. Небольшие записи накапливаются в буфере объединения,
+* записи размером не меньше буфера передаются на диск напрямую без копирования.
+**/
+bool IOutputSink::write(const uint8_t* pUi8Data, size_t szSize) {
+	if (!bOpen || (szSize != 0 && pUi8Data == nullptr)) {
+		return false;
+	}
+	ui64BytesWritten += szSize;
+
+	if (szCoalesceUsed + szSize <= kUi32CoalesceSize) {
+		std::memcpy(pUi8Coalesce.get() + szCoalesceUsed, pUi8Data, szSize);
+		szCoalesceUsed += szSize;
+		return (szCoalesceUsed == kUi32CoalesceSize) ? flush() : true;
+	}
+
+	if (!flush()) {
+		return false;
+	}
+	if (szSize >= kUi32CoalesceSize) {
+		if (!writeRaw(pUi8Data, szSize, ui64FileOffset)) {
+			return false;
+		}
+		ui64FileOffset += szSize;
+		return true;
+	}
+	std::memcpy(pUi8Coalesce.get(), pUi8Data, szSize);
+	szCoalesceUsed = szSize;
+	return true;
+}
+
+/**
+* \brief
+* Копирование ядром. Накопленные в буфере объединения данные предварительно
+* записываются, чтобы порядок данных в файле совпадал с порядком вызовов.
+**/
+uint64_t IOutputSink::copyFrom(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size) {
+	if (!bOpen || iSourceDescriptor < 0 || ui64Size == 0) {
+		return 0;
+	}
+	if (!flush()) {
+		return 0;
+	}
+
+	uint64_t ui64Copied = copyRaw(iSourceDescriptor, ui64SourceOffset, ui64Size, ui64FileOffset);
+	ui64FileOffset += ui64Copied;
+	ui64BytesWritten += ui64Copied;
+	return ui64Copied;
+}
+
+bool IOutputSink::close() {
+	if (!bOpen) {
+		return true;
+	}
+	bOpen = false;
+
+	bool bResult = flush();
+	// Итоговый размер устанавливается всегда: зарезервированное, но не записанное место отбрасывается
+	if (!closeRaw(ui64FileOffset)) {
+		bResult = false;
+	}
+	return bResult;
+}
+
+bool IOutputSink::flush() {
+	if (szCoalesceUsed == 0) {
+		return true;
+	}
+	if (!writeRaw(pUi8Coalesce.get(), szCoalesceUsed, ui64FileOffset)) {
+		return false;
+	}
+	ui64FileOffset += szCoalesceUsed;
+	szCoalesceUsed = 0;
+	return true;
+}
+
+std::unique_ptr<IOutputSink> IOutputSink::create() {
+#if defined(_WIN32)
+	return std::make_unique<WinOutputSink>();
+#else
+	return std::make_unique<PosixOutputSink>();
+#endif
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+
+/*
+* Файл назначения для выгрузки данных (например, цепочки видеофрагментов).
+* Открывается один раз на всю выгрузку, заранее резервирует место под итоговый
+* размер и объединяет небольшие записи в крупные блоки kUi32CoalesceSize,
+* поэтому выгрузка выполняется со скоростью последовательной записи.
+*
+* Реализации отвечают только за работу с файлом (openRaw, writeRaw, closeRaw):
+*	PosixOutputSink - Linux (fallocate, копирование ядром через copy_file_range или splice) и macOS (F_PREALLOCATE);
+*	WinOutputSink   - Windows (SetEndOfFile и SetFileValidData).
+*/
+class IOutputSink {
+public:
+	virtual ~IOutputSink() = default;
+
+	/*
+	* Создаёт (или перезаписывает) файл и резервирует ui64ExpectedSize байт.
+	* Ошибка резервирования не считается ошибкой открытия.
+	*/
+	bool open(const std::string& inFilePath, uint64_t ui64ExpectedSize);
+
+	// Добавляет данные в конец файла
+	bool write(const uint8_t* pUi8Data, size_t szSize);
+
+	// Записывает накопленные данные, устанавливает итоговый размер файла и закрывает его
+	bool close();
+
+	/*
+	* Дописывает в конец файла ui64Size байт файла iSourceDescriptor начиная с ui64SourceOffset
+	* средствами ядра, без передачи данных через пространство пользователя.
+	* Возвращает количество скопированных байт: 0, если копирование ядром недоступно,
+	* меньше ui64Size, если оно прервалось (остаток вызывающий дописывает через write).
+	*/
+	uint64_t copyFrom(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size);
+
+	// Способ копирования ядром, выбранный при первом вызове copyFrom (nullptr, если не используется)
+	virtual const char* getKernelCopyName() const { return nullptr; }
+
+	// Количество байт, переданных в write и copyFrom с момента открытия
+	uint64_t getBytesWritten() const { return ui64BytesWritten; }
+
+	// Создаёт реализацию для текущей платформы
+	static std::unique_ptr<IOutputSink> create();
+
+protected:
+	virtual bool openRaw(const std::string& inFilePath, uint64_t ui64ExpectedSize) = 0;
+	virtual bool writeRaw(const uint8_t* pUi8Data, size_t szSize, uint64_t ui64Offset) = 0;
+	virtual bool closeRaw(uint64_t ui64FinalSize) = 0;
+
+	// Копирование ядром в файл назначения по смещению ui64Offset. По умолчанию не поддерживается
+	virtual uint64_t copyRaw(int /*iSourceDescriptor*/, uint64_t /*ui64SourceOffset*/, uint64_t /*ui64Size*/, uint64_t /*ui64Offset*/) { return 0; }
+
+private:
+	static constexpr uint32_t kUi32CoalesceSize = 0x800000;		// Размер блока объединения записей (8 МБ)
+
+	std::unique_ptr<uint8_t[]> pUi8Coalesce;	// Буфер объединения записей
+	size_t szCoalesceUsed = 0;					// Заполнено байт в буфере объединения
+	uint64_t ui64FileOffset = 0;				// Смещение в файле для следующей записи на диск
+	uint64_t ui64BytesWritten = 0;				// Всего принято байт
+	bool bOpen = false;
+
+	bool flush();
+};
@@ -0,0 +1,263 @@
+#include "InstrumentedFile.h"
+
+#include <sstream>
+
+uint64_t IoOpStats::percentileNs(double dPercentile) const {
+	uint64_t ui64Total = 0;
+	for (uint64_t ui64Count : arrLatency) {
+		ui64Total += ui64Count;
+	}
+	if (ui64Total == 0) {
+		return 0;
+	}
+
+	uint64_t ui64Threshold = static_cast<uint64_t>(dPercentile * static_cast<double>(ui64Total) / 100.0);
+	uint64_t ui64Accumulated = 0;
+	for (uint32_t ui32Bucket = 0; ui32Bucket < kUi32LatencyBuckets; ui32Bucket++) {
+		ui64Accumulated += arrLatency[ui32Bucket];
+		if (ui64Accumulated > ui64Threshold || ui64Accumulated == ui64Total) {
+			return 1ULL << (ui32Bucket + 1);
+		}
+	}
+	return 1ULL << kUi32LatencyBuckets;
+}
+
+/**
+* \brief
+* Формирует JSON со статистикой. Гистограмма выводится массивом latency_log2_ns,
+* элемент i которого - количество операций длительностью [2^i, 2^(i+1)) нс.
+**/
+std::string IoStats::toJson() const {
+	std::ostringstream streamJson;
+	auto fnOp = [&streamJson](const char* szName, const IoOpStats& inStats) {
+		streamJson << "  \"" << szName << "\": {\n";
+		streamJson << "    \"calls\": " << inStats.ui64Calls << ",\n";
+		streamJson << "    \"inner_calls\": " << inStats.ui64InnerCalls << ",\n";
+		streamJson << "    \"bytes\": " << inStats.ui64Bytes << ",\n";
+		streamJson << "    \"total_ns\": " << inStats.ui64TotalNs << ",\n";
+		streamJson << "    \"max_ns\": " << inStats.ui64MaxNs << ",\n";
+		streamJson << "    \"p50_ns\": " << inStats.percentileNs(50.0) << ",\n";
+		streamJson << "    \"p90_ns\": " << inStats.percentileNs(90.0) << ",\n";
+		streamJson << "    \"p99_ns\": " << inStats.percentileNs(99.0) << ",\n";
+		streamJson << "    \"latency_log2_ns\": [";
+		for (uint32_t ui32Bucket = 0; ui32Bucket < IoOpStats::kUi32LatencyBuckets; ui32Bucket++) {
+			streamJson << (ui32Bucket == 0 ? "" : ", ") << inStats.arrLatency[ui32Bucket];
+		}
+		streamJson << "]\n  },\n";
+	};
+
+	streamJson << "{\n";
+	fnOp("read", stRead);
+	fnOp("write", stWrite);
+	streamJson << "  \"views\": " << ui64Views << ",\n";
+	streamJson << "  \"kernel_copy_bytes\": " << ui64KernelCopyBytes << ",\n";
+	streamJson << "  \"locality\": {\n";
+	streamJson << "    \"sequential\": " << ui64Sequential << ",\n";
+	streamJson << "    \"near\": " << ui64Near << ",\n";
+	streamJson << "    \"random\": " << ui64Random << ",\n";
+	streamJson << "    \"near_distance\": " << kUi64NearDistance << ",\n";
+	streamJson << "    \"seek_distance\": " << ui64SeekDistance << "\n";
+	streamJson << "  }\n";
+	streamJson << "}\n";
+	return streamJson.str();
+}
+
+InstrumentedFile::InstrumentedFile(std::unique_ptr<IFile> inFile)
+	: inputFile_(std::move(inFile)), ui64Views(0), ui64KernelCopyBytes(0), ui64Sequential(0), ui64Near(0), ui64Random(0), ui64SeekDistance(0), ui64LastReadEnd(0), ui64Position(0) {};
+
+bool InstrumentedFile::open(const std::string& inFilePath) {
+	ui64Position = 0;
+	ui64LastReadEnd = 0;
+	return inputFile_->open(inFilePath);
+};
+
+bool InstrumentedFile::setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) {
+	if (!inputFile_->setPosition(ui64Offset, ui8MoveMethod)) {
+		return false;
+	}
+	// Позиция дублируется только для учёта локальности чтений через read()
+	switch (ui8MoveMethod) {
+		case FILE_ORIGIN_BEGIN: ui64Position = ui64Offset; break;
+		case FILE_ORIGIN_CUR: ui64Position += ui64Offset; break;
+		case FILE_ORIGIN_END: ui64Position = inputFile_->getSize() + ui64Offset; break;
+	}
+	return true;
+};
+
+bool InstrumentedFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	recordLocality(ui64Position, ui32Size);
+	auto timeStart = std::chrono::steady_clock::now();
+	bool bResult = inputFile_->read(ui8Buffer, ui32Size, ui32BytesRead);
+	stRead.record(1, ui32BytesRead, elapsedNs(timeStart));
+	ui64Position += ui32BytesRead;
+	return bResult;
+};
+
+bool InstrumentedFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	auto timeStart = std::chrono::steady_clock::now();
+	bool bResult = inputFile_->writeToFile(inFilePath, pUi8Data, inDataSize);
+	stWrite.record(1, bResult ? inDataSize : 0, elapsedNs(timeStart));
+	return bResult;
+};
+
+bool InstrumentedFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	auto timeStart = std::chrono::steady_clock::now();
+	bool bResult = inputFile_->writeToFileAppend(inFilePath, pUi8Data, inDataSize);
+	stWrite.record(1, bResult ? inDataSize : 0, elapsedNs(timeStart));
+	return bResult;
+};
+
+void InstrumentedFile::close() {
+	inputFile_->close();
+};
+
+bool InstrumentedFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	recordLocality(ui64Offset, ui64Size);
+	auto timeStart = std::chrono::steady_clock::now();
+	bool bResult = inputFile_->readAt(ui64Offset, pUi8Buffer, ui64Size, ui64BytesRead);
+	stRead.record(1, ui64BytesRead, elapsedNs(timeStart));
+	return bResult;
+};
+
+/**
+* \brief
+* Пакетное чтение учитывается как одно обращение к исходному файлу
+* с количеством вызовов, равным числу элементов
+**/
+bool InstrumentedFile::readv(std::vector<ReadRequest>& vecRequests) {
+	for (const ReadRequest& stRequest : vecRequests) {
+		recordLocality(stRequest.ui64Offset, stRequest.ui64Size);
+	}
+	auto timeStart = std::chrono::steady_clock::now();
+	bool bResult = inputFile_->readv(vecRequests);
+	uint64_t ui64Bytes = 0;
+	for (const ReadRequest& stRequest : vecRequests) {
+		ui64Bytes += stRequest.ui64BytesRead;
+	}
+	stRead.record(vecRequests.size(), ui64Bytes, elapsedNs(timeStart));
+	return bResult;
+};
+
+ByteView InstrumentedFile::view(uint64_t ui64Offset, uint64_t ui64Length) {
+	ByteView stView = inputFile_->view(ui64Offset, ui64Length);
+	if (!stView.empty()) {
+		ui64Views++;
+	}
+	return stView;
+};
+
+void InstrumentedFile::advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) {
+	inputFile_->advise(ui64Offset, ui64Length, eHint);
+};
+
+int InstrumentedFile::getNativeDescriptor() const {
+	return inputFile_->getNativeDescriptor();
+}
+
+/**
+* \brief
+* Копирование ядром учитывается как одно обращение к исходному файлу
+**/
+void InstrumentedFile::recordKernelRead(uint64_t ui64Offset, uint64_t ui64Size, uint64_t ui64Ns) {
+	recordLocality(ui64Offset, ui64Size);
+	stRead.record(1, ui64Size, ui64Ns);
+	ui64KernelCopyBytes += ui64Size;
+	inputFile_->recordKernelRead(ui64Offset, ui64Size, ui64Ns);
+};
+
+uint64_t InstrumentedFile::getSize() {
+	return inputFile_->getSize();
+};
+
+uint64_t InstrumentedFile::getModificationTime() {
+	return inputFile_->getModificationTime();
+};
+
+void InstrumentedFile::setBlockSizeHint(uint32_t ui32BlockSize) {
+	inputFile_->setBlockSizeHint(ui32BlockSize);
+};
+
+IoStats InstrumentedFile::getStats() const {
+	IoStats stStats;
+	stRead.snapshot(stStats.stRead);
+	stWrite.snapshot(stStats.stWrite);
+	stStats.ui64Views = ui64Views;
+	stStats.ui64KernelCopyBytes = ui64KernelCopyBytes;
+	stStats.ui64Sequential = ui64Sequential;
+	stStats.ui64Near = ui64Near;
+	stStats.ui64Random = ui64Random;
+	stStats.ui64SeekDistance = ui64SeekDistance;
+	return stStats;
+};
+
+void InstrumentedFile::resetStats() {
+	stRead.reset();
+	stWrite.reset();
+	ui64Views = 0;
+	ui64KernelCopyBytes = 0;
+	ui64Sequential = 0;
+	ui64Near = 0;
+	ui64Random = 0;
+	ui64SeekDistance = 0;
+};
+
+/**
+* \brief
+* Классифицирует чтение по расстоянию от конца предыдущего чтения
+**/
+void InstrumentedFile::recordLocality(uint64_t ui64Offset, uint64_t ui64Size) {
+	uint64_t ui64Previous = ui64LastReadEnd.exchange(ui64Offset + ui64Size);
+	uint64_t ui64Distance = (ui64Offset >= ui64Previous) ? ui64Offset - ui64Previous : ui64Previous - ui64Offset;
+	if (ui64Distance == 0) {
+		ui64Sequential++;
+	}
+	else if (ui64Distance <= IoStats::kUi64NearDistance) {
+		ui64Near++;
+	}
+	else {
+		ui64Random++;
+	}
+	ui64SeekDistance += ui64Distance;
+};
+
+uint64_t InstrumentedFile::elapsedNs(std::chrono::steady_clock::time_point timeStart) {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timeStart).count());
+};
+
+void InstrumentedFile::AtomicOpStats::record(uint64_t ui64CallCount, uint64_t ui64ByteCount, uint64_t ui64Ns) {
+	ui64Calls += ui64CallCount;
+	ui64InnerCalls++;
+	ui64Bytes += ui64ByteCount;
+	ui64TotalNs += ui64Ns;
+
+	uint64_t ui64Max = ui64MaxNs;
+	while (ui64Ns > ui64Max && !ui64MaxNs.compare_exchange_weak(ui64Max, ui64Ns)) {}
+
+	uint32_t ui32Bucket = 0;
+	while (ui32Bucket + 1 < IoOpStats::kUi32LatencyBuckets && (ui64Ns >> (ui32Bucket + 1)) != 0) {
+		ui32Bucket++;
+	}
+	arrLatency[ui32Bucket]++;
+};
+
+void InstrumentedFile::AtomicOpStats::snapshot(IoOpStats& outStats) const {
+	outStats.ui64Calls = ui64Calls;
+	outStats.ui64InnerCalls = ui64InnerCalls;
+	outStats.ui64Bytes = ui64Bytes;
+	outStats.ui64TotalNs = ui64TotalNs;
+	outStats.ui64MaxNs = ui64MaxNs;
+	for (uint32_t ui32Bucket = 0; ui32Bucket < IoOpStats::kUi32LatencyBuckets; ui32Bucket++) {
+		outStats.arrLatency[ui32Bucket] = arrLatency[ui32Bucket];
+	}
+};
+
+void InstrumentedFile::AtomicOpStats::reset() {
+	ui64Calls = 0;
+	ui64InnerCalls = 0;
+	ui64Bytes = 0;
+	ui64TotalNs = 0;
+	ui64MaxNs = 0;
+	for (std::atomic<uint64_t>& ui64Count : arrLatency) {
+		ui64Count = 0;
+	}
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IFile.h"
+
+/*
+* Статистика одного вида операций (чтение или запись)
+*/
+struct IoOpStats {
+	static constexpr uint32_t kUi32LatencyBuckets = 40;	// Интервалы гистограммы: [2^i, 2^(i+1)) нс
+
+	uint64_t	ui64Calls = 0;			// Вызовов IFile (readv учитывается по элементам)
+	uint64_t	ui64InnerCalls = 0;		// Обращений к исходному файлу (вызовов IFile, а не системных вызовов)
+	uint64_t	ui64Bytes = 0;			// Передано байт
+	uint64_t	ui64TotalNs = 0;		// Суммарное время операций
+	uint64_t	ui64MaxNs = 0;			// Наибольшее время одной операции
+	std::array<uint64_t, kUi32LatencyBuckets> arrLatency{};	// Логарифмическая гистограмма времени операций
+
+	// Оценка процентиля времени операции по гистограмме (верхняя граница интервала), нс
+	uint64_t percentileNs(double dPercentile) const;
+};
+
+/*
+* Сводная статистика ввода-вывода InstrumentedFile
+*/
+struct IoStats {
+	IoOpStats	stRead;
+	IoOpStats	stWrite;
+	uint64_t	ui64Views = 0;				// Обращений к данным без копирования (view)
+	uint64_t	ui64KernelCopyBytes = 0;	// Байт образа, скопированных ядром (входят в stRead)
+	uint64_t	ui64Sequential = 0;			// Чтений, начавшихся точно в конце предыдущего
+	uint64_t	ui64Near = 0;				// Чтений на расстоянии до kUi64NearDistance от конца предыдущего
+	uint64_t	ui64Random = 0;				// Остальных чтений
+	uint64_t	ui64SeekDistance = 0;		// Суммарное расстояние переходов между чтениями, байт
+
+	static constexpr uint64_t kUi64NearDistance = 0x100000;	// 1 МБ
+
+	// Статистика в формате JSON
+	std::string toJson() const;
+};
+
+/*
+* Декоратор IFile, собирающий статистику ввода-вывода: количество вызовов и обращений
+* к исходному файлу, объём данных, локальность смещений чтения и логарифмическую
+* гистограмму времени операций чтения и записи. Позволяет определить, на что уходит
+* время открытия образа (носитель, разбор или вывод), и сравнить способы чтения и диски.
+*
+* Счётчики атомарные, поэтому декоратор можно использовать при параллельном чтении.
+* Дескриптор исходного файла передаётся вызывающему, поэтому выгрузка копированием ядром сохраняется;
+* скопированные ядром данные учитываются в чтении через recordKernelRead.
+*/
+class InstrumentedFile : public IFile {
+public:
+	explicit InstrumentedFile(std::unique_ptr<IFile> inFile);
+
+	bool open(const std::string& inFilePath) override;
+	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
+	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+
+	ByteView view(uint64_t ui64Offset, uint64_t ui64Length) override;
+	void advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) override;
+	int getNativeDescriptor() const override;
+	void recordKernelRead(uint64_t ui64Offset, uint64_t ui64Size, uint64_t ui64Ns) override;
+	uint64_t getSize() override;
+	uint64_t getModificationTime() override;
+	void setBlockSizeHint(uint32_t ui32BlockSize) override;
+
+	// Снимок текущих значений счётчиков
+	IoStats getStats() const;
+
+	// Обнуляет счётчики
+	void resetStats();
+
+private:
+	struct AtomicOpStats {
+		std::atomic<uint64_t> ui64Calls{ 0 };
+		std::atomic<uint64_t> ui64InnerCalls{ 0 };
+		std::atomic<uint64_t> ui64Bytes{ 0 };
+		std::atomic<uint64_t> ui64TotalNs{ 0 };
+		std::atomic<uint64_t> ui64MaxNs{ 0 };
+		std::array<std::atomic<uint64_t>, IoOpStats::kUi32LatencyBuckets> arrLatency{};
+
+		void record(uint64_t ui64Calls, uint64_t ui64Bytes, uint64_t ui64Ns);
+		void snapshot(IoOpStats& outStats) const;
+		void reset();
+	};
+
+	std::unique_ptr<IFile> inputFile_;
+	AtomicOpStats stRead;
+	AtomicOpStats stWrite;
+	std::atomic<uint64_t> ui64Views;
+	std::atomic<uint64_t> ui64KernelCopyBytes;
+	std::atomic<uint64_t> ui64Sequential;
+	std::atomic<uint64_t> ui64Near;
+	std::atomic<uint64_t> ui64Random;
+	std::atomic<uint64_t> ui64SeekDistance;
+	std::atomic<uint64_t> ui64LastReadEnd;		// Конец предыдущего чтения
+	uint64_t ui64Position;
+
+	void recordLocality(uint64_t ui64Offset, uint64_t ui64Size);
+	static uint64_t elapsedNs(std::chrono::steady_clock::time_point timeStart);
+};
@@ -0,0 +1,203 @@
+#if defined(__linux__) || (defined(__MACH__) && defined(__APPLE__))
+#include "MmapFile.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include "PosixFile.h"
+#else
+#include "macFile.h"
+#endif
+
+#if defined(__linux__)
+using NativeFile = PosixFile;
+#else
+using NativeFile = macFile;
+#endif
+
+MmapFile::MmapFile() : fileDescriptor(-1), pUi8Mapping(nullptr), ui64MappingSize(0), ui64Position(0) {};
+
+MmapFile::~MmapFile() {
+	close();
+};
+
+bool MmapFile::open(const std::string& inFilePath) {
+	if (inFilePath.empty()) return false;
+
+	close();
+
+	fileDescriptor = ::open(inFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	/*
+	* Блочные устройства не отображаются: ошибка чтения сектора на повреждённом или изъятом
+	* диске при обращении к отображённой странице завершает процесс сигналом SIGBUS, тогда как
+	* readAt других способов чтения возвращает ошибку. Для устройств используются native и direct
+	*/
+	struct stat stFileStat;
+	if (fstat(fileDescriptor, &stFileStat) != 0 || !S_ISREG(stFileStat.st_mode)) {
+		close();
+		return false;
+	}
+	ui64MappingSize = static_cast<uint64_t>(stFileStat.st_size);
+
+	if (ui64MappingSize == 0) {
+		close();
+		return false;
+	}
+
+	void* pMapping = mmap(nullptr, static_cast<size_t>(ui64MappingSize), PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	if (pMapping == MAP_FAILED) {
+		close();
+		return false;
+	}
+	pUi8Mapping = static_cast<uint8_t*>(pMapping);
+	ui64Position = 0;
+	return true;
+};
+
+bool MmapFile::setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) {
+	if (pUi8Mapping == nullptr) {
+		return false;
+	}
+
+	switch (ui8MoveMethod) {
+		case FILE_ORIGIN_BEGIN: ui64Position = ui64Offset; break;
+		case FILE_ORIGIN_CUR: ui64Position += ui64Offset; break;
+		case FILE_ORIGIN_END: ui64Position = ui64MappingSize + ui64Offset; break;
+		default: return false;
+	}
+	return true;
+};
+
+bool MmapFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	ui32BytesRead = 0;
+	if (pUi8Mapping == nullptr) {
+		return false;
+	}
+	if (ui64Position >= ui64MappingSize) {
+		return true;	// Конец файла
+	}
+
+	uint64_t ui64Available = ui64MappingSize - ui64Position;
+	ui32BytesRead = (ui64Available < ui32Size) ? static_cast<uint32_t>(ui64Available) : ui32Size;
+	std::memcpy(ui8Buffer, pUi8Mapping + ui64Position, ui32BytesRead);
+	ui64Position += ui32BytesRead;
+	return true;
+};
+
+/**
+* \brief
+* Позиционное чтение копированием из отображённых страниц. Общая позиция не используется.
+**/
+bool MmapFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (pUi8Mapping == nullptr) {
+		return false;
+	}
+	if (ui64Offset >= ui64MappingSize) {
+		return true;	// Конец файла
+	}
+
+	uint64_t ui64Available = ui64MappingSize - ui64Offset;
+	ui64BytesRead = (ui64Available < ui64Size) ? ui64Available : ui64Size;
+	std::memcpy(pUi8Buffer, pUi8Mapping + ui64Offset, static_cast<size_t>(ui64BytesRead));
+	return true;
+};
+
+bool MmapFile::readv(std::vector<ReadRequest>& vecRequests) {
+	bool bResult = true;
+	for (ReadRequest& stRequest : vecRequests) {
+		if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+			bResult = false;
+		}
+	}
+	return bResult;
+};
+
+void MmapFile::close() {
+	if (pUi8Mapping != nullptr) {
+		munmap(pUi8Mapping, static_cast<size_t>(ui64MappingSize));
+		pUi8Mapping = nullptr;
+	}
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+	ui64MappingSize = 0;
+	ui64Position = 0;
+};
+
+/**
+* \brief
+* Возвращает участок отображённого образа без копирования.
+*
+* \param
+* uint64_t ui64Offset - смещение начала участка.
+*
+* uint64_t ui64Length - длина участка.
+*
+* \return
+* ByteView на отображённые страницы или пустой ByteView, если участок выходит за границы образа.
+**/
+ByteView MmapFile::view(uint64_t ui64Offset, uint64_t ui64Length) {
+	if (pUi8Mapping == nullptr || ui64Offset > ui64MappingSize || ui64Length > ui64MappingSize - ui64Offset) {
+		return ByteView{};
+	}
+	return ByteView{ pUi8Mapping + ui64Offset, ui64Length };
+};
+
+void MmapFile::advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) {
+	if (pUi8Mapping == nullptr || ui64Offset >= ui64MappingSize) {
+		return;
+	}
+	if (ui64Length == 0 || ui64Length > ui64MappingSize - ui64Offset) {
+		ui64Length = ui64MappingSize - ui64Offset;
+	}
+
+	// madvise требует адрес, выровненный по границе страницы
+	uint64_t ui64PageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	uint64_t ui64AlignedOffset = ui64Offset - (ui64Offset % ui64PageSize);
+	uint64_t ui64AlignedLength = ui64Length + (ui64Offset - ui64AlignedOffset);
+
+	int iAdvice = MADV_NORMAL;
+	switch (eHint) {
+		case FileAccessHint::Normal: iAdvice = MADV_NORMAL; break;
+		case FileAccessHint::Sequential: iAdvice = MADV_SEQUENTIAL; break;
+		case FileAccessHint::WillNeed: iAdvice = MADV_WILLNEED; break;
+		case FileAccessHint::DontNeed: iAdvice = MADV_DONTNEED; break;
+	}
+	madvise(pUi8Mapping + ui64AlignedOffset, static_cast<size_t>(ui64AlignedLength), iAdvice);
+};
+
+uint64_t MmapFile::getModificationTime() {
+	struct stat stFileStat;
+	if (fileDescriptor < 0 || fstat(fileDescriptor, &stFileStat) != 0) {
+		return 0;
+	}
+#if defined(__linux__)
+	return static_cast<uint64_t>(stFileStat.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(stFileStat.st_mtim.tv_nsec);
+#else
+	return static_cast<uint64_t>(stFileStat.st_mtimespec.tv_sec) * 1000000000ull + static_cast<uint64_t>(stFileStat.st_mtimespec.tv_nsec);
+#endif
+};
+
+/**
+* \brief
+* Запись выполняется способом чтения платформы по умолчанию (PosixFile или macFile)
+**/
+bool MmapFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	NativeFile outputFile;
+	return outputFile.writeToFile(inFilePath, pUi8Data, inDataSize);
+};
+
+bool MmapFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	NativeFile outputFile;
+	return outputFile.writeToFileAppend(inFilePath, pUi8Data, inDataSize);
+};
+#endif
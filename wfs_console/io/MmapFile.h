@@ -0,0 +1,44 @@
+#pragma once
+#if defined(__linux__) || (defined(__MACH__) && defined(__APPLE__))
+#include <cstdint>
+#include <string>
+#include <memory>
+
+#include "IFile.h"
+
+/*
+* Реализация IFile на основе отображения образа в память (mmap).
+* Метод view() возвращает указатель непосредственно на отображённые страницы,
+* что позволяет разбирать IndexArea, SuperBlock и выгружать фрагменты без
+* выделения промежуточных буферов и копирования. Подсказки advise()
+* транслируются в madvise (MADV_SEQUENTIAL / MADV_WILLNEED / MADV_DONTNEED).
+* Открываются только обычные файлы: ошибка чтения отображённой страницы блочного
+* устройства приводит к SIGBUS, а не к ошибке чтения.
+*/
+class MmapFile : public IFile {
+public:
+	MmapFile();
+	~MmapFile();
+
+	bool open(const std::string& inFilePath) override;
+	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
+	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+	int getNativeDescriptor() const override { return fileDescriptor; }
+
+	ByteView view(uint64_t ui64Offset, uint64_t ui64Length) override;
+	void advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) override;
+	uint64_t getSize() override { return ui64MappingSize; }
+	uint64_t getModificationTime() override;
+
+private:
+	int fileDescriptor;
+	uint8_t* pUi8Mapping;
+	uint64_t ui64MappingSize;
+	uint64_t ui64Position;
+};
+#endif
@@ -0,0 +1,262 @@
+#if defined(__linux__)
+#include "PosixFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <climits>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+
+PosixFile::PosixFile() : fileDescriptor(-1), ui64Position(0) {};
+
+PosixFile::~PosixFile() {
+	close();
+};
+
+bool PosixFile::open(const std::string& inFilePath) {
+	if (inFilePath.empty()) return false;
+
+	close();
+
+	fileDescriptor = ::open(inFilePath.c_str(), O_RDONLY | O_CLOEXEC | O_LARGEFILE);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+	ui64Position = 0;
+	return true;
+};
+
+bool PosixFile::setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) {
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	/*
+	* Позиция хранится только в объекте: само чтение выполняется через pread64
+	* с явным смещением, поэтому lseek не вызывается
+	*/
+	switch (ui8MoveMethod) {
+		case FILE_ORIGIN_BEGIN: ui64Position = ui64Offset; break;
+		case FILE_ORIGIN_CUR: ui64Position += ui64Offset; break;
+		case FILE_ORIGIN_END: ui64Position = getSize() + ui64Offset; break;
+		default: return false;
+	}
+	return true;
+};
+
+bool PosixFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	ui32BytesRead = 0;
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	// pread64 может вернуть меньше запрошенного (сигналы, границы устройства), поэтому дочитываем в цикле
+	while (ui32BytesRead < ui32Size) {
+		ssize_t iResultRead = pread64(fileDescriptor, ui8Buffer + ui32BytesRead, ui32Size - ui32BytesRead, static_cast<off64_t>(ui64Position));
+		if (iResultRead < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (iResultRead == 0) {
+			break;	// Конец файла
+		}
+		ui32BytesRead += static_cast<uint32_t>(iResultRead);
+		ui64Position += static_cast<uint64_t>(iResultRead);
+	}
+	return true;
+};
+
+/**
+* \brief
+* Позиционное чтение через pread64. Текущая позиция объекта не используется,
+* поэтому вызов безопасен при одновременном обращении из нескольких потоков.
+**/
+bool PosixFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	while (ui64BytesRead < ui64Size) {
+		// Ядро Linux передаёт за один вызов не более ~2 ГБ, поэтому большие участки читаются частями
+		size_t szChunk = static_cast<size_t>(std::min<uint64_t>(ui64Size - ui64BytesRead, kUi64MaxChunk));
+		ssize_t iResultRead = pread64(fileDescriptor, pUi8Buffer + ui64BytesRead, szChunk, static_cast<off64_t>(ui64Offset + ui64BytesRead));
+		if (iResultRead < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (iResultRead == 0) {
+			break;	// Конец файла
+		}
+		ui64BytesRead += static_cast<uint64_t>(iResultRead);
+	}
+	return true;
+};
+
+/**
+* \brief
+* Пакетное позиционное чтение. Подряд идущие запросы, участки которых непрерывно
+* следуют друг за другом в файле, объединяются в один вызов preadv64 (до IOV_MAX буферов),
+* остальные выполняются отдельным pread64.
+**/
+bool PosixFile::readv(std::vector<ReadRequest>& vecRequests) {
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	bool bResult = true;
+	size_t szFirst = 0;
+	while (szFirst < vecRequests.size()) {
+		// Поиск группы смежных участков
+		size_t szLast = szFirst + 1;
+		uint64_t ui64GroupSize = vecRequests[szFirst].ui64Size;
+		while (szLast < vecRequests.size() && szLast - szFirst < IOV_MAX &&
+			vecRequests[szLast].ui64Offset == vecRequests[szLast - 1].ui64Offset + vecRequests[szLast - 1].ui64Size &&
+			ui64GroupSize + vecRequests[szLast].ui64Size <= kUi64MaxChunk) {
+			ui64GroupSize += vecRequests[szLast].ui64Size;
+			szLast++;
+		}
+
+		bool bGroupDone = false;
+		if (szLast - szFirst > 1) {
+			std::vector<struct iovec> vecIov(szLast - szFirst);
+			for (size_t szIter = szFirst; szIter < szLast; szIter++) {
+				vecIov[szIter - szFirst].iov_base = vecRequests[szIter].pUi8Buffer;
+				vecIov[szIter - szFirst].iov_len = static_cast<size_t>(vecRequests[szIter].ui64Size);
+			}
+
+			ssize_t iResultRead;
+			do {
+				iResultRead = preadv64(fileDescriptor, vecIov.data(), static_cast<int>(vecIov.size()), static_cast<off64_t>(vecRequests[szFirst].ui64Offset));
+			} while (iResultRead < 0 && errno == EINTR);
+
+			// Неполное чтение (конец файла, сигнал) дочитывается поэлементно ниже
+			if (iResultRead >= 0 && static_cast<uint64_t>(iResultRead) == ui64GroupSize) {
+				for (size_t szIter = szFirst; szIter < szLast; szIter++) {
+					vecRequests[szIter].ui64BytesRead = vecRequests[szIter].ui64Size;
+				}
+				bGroupDone = true;
+			}
+		}
+
+		if (!bGroupDone) {
+			for (size_t szIter = szFirst; szIter < szLast; szIter++) {
+				ReadRequest& stRequest = vecRequests[szIter];
+				if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+					bResult = false;
+				}
+			}
+		}
+		szFirst = szLast;
+	}
+	return bResult;
+};
+
+void PosixFile::close() {
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+	ui64Position = 0;
+};
+
+bool PosixFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	if (inDataSize != 0 && !pUi8Data) {
+		return false;
+	}
+
+	int iOutFileDescriptor = ::open(inFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (iOutFileDescriptor < 0) {
+		return false;
+	}
+
+	bool bResult = writeAll(iOutFileDescriptor, pUi8Data, inDataSize, 0);
+	::close(iOutFileDescriptor);
+	return bResult;
+};
+
+bool PosixFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	if (inDataSize != 0 && !pUi8Data) {
+		return false;
+	}
+
+	int iOutFileDescriptor = ::open(inFilePath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+	if (iOutFileDescriptor < 0) {
+		return false;
+	}
+
+	// Запись с явным смещением в конец файла (O_APPEND в Linux игнорирует смещение pwrite)
+	struct stat stFileStat;
+	if (fstat(iOutFileDescriptor, &stFileStat) != 0) {
+		::close(iOutFileDescriptor);
+		return false;
+	}
+
+	bool bResult = writeAll(iOutFileDescriptor, pUi8Data, inDataSize, static_cast<uint64_t>(stFileStat.st_size));
+	::close(iOutFileDescriptor);
+	return bResult;
+};
+
+/**
+* \brief
+* Передаёт подсказку о характере доступа в страничный кэш ядра (posix_fadvise).
+**/
+void PosixFile::advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) {
+	if (fileDescriptor < 0) {
+		return;
+	}
+
+	int iAdvice = POSIX_FADV_NORMAL;
+	switch (eHint) {
+		case FileAccessHint::Normal: iAdvice = POSIX_FADV_NORMAL; break;
+		case FileAccessHint::Sequential: iAdvice = POSIX_FADV_SEQUENTIAL; break;
+		case FileAccessHint::WillNeed: iAdvice = POSIX_FADV_WILLNEED; break;
+		case FileAccessHint::DontNeed: iAdvice = POSIX_FADV_DONTNEED; break;
+	}
+	posix_fadvise64(fileDescriptor, static_cast<off64_t>(ui64Offset), static_cast<off64_t>(ui64Length), iAdvice);
+};
+
+/**
+* \brief
+* Возвращает размер открытого файла. Для блочных устройств st_size равен нулю,
+* поэтому размер запрашивается через ioctl BLKGETSIZE64.
+**/
+uint64_t PosixFile::getSize() {
+	struct stat stFileStat;
+	if (fstat(fileDescriptor, &stFileStat) != 0) {
+		return 0;
+	}
+	if (S_ISBLK(stFileStat.st_mode)) {
+		uint64_t ui64DeviceSize = 0;
+		if (ioctl(fileDescriptor, BLKGETSIZE64, &ui64DeviceSize) != 0) {
+			return 0;
+		}
+		return ui64DeviceSize;
+	}
+	return static_cast<uint64_t>(stFileStat.st_size);
+}
+
+uint64_t PosixFile::getModificationTime() {
+	struct stat stFileStat;
+	if (fstat(fileDescriptor, &stFileStat) != 0) {
+		return 0;
+	}
+	return static_cast<uint64_t>(stFileStat.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(stFileStat.st_mtim.tv_nsec);
+}
+
+bool PosixFile::writeAll(int inFileDescriptor, const uint8_t* pUi8Data, size_t inDataSize, uint64_t inUi64Offset) {
+	size_t szWritten = 0;
+	while (szWritten < inDataSize) {
+		ssize_t iResultWrite = pwrite64(inFileDescriptor, pUi8Data + szWritten, inDataSize - szWritten, static_cast<off64_t>(inUi64Offset + szWritten));
+		if (iResultWrite < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		szWritten += static_cast<size_t>(iResultWrite);
+	}
+	return true;
+}
+#endif
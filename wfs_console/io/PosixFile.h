@@ -0,0 +1,42 @@
+#pragma once
+#if defined(__linux__)
+#include <cstdint>
+#include <string>
+#include <memory>
+
+#include "IFile.h"
+
+/*
+* Реализация IFile для Linux на основе файлового дескриптора.
+* Чтение выполняется позиционно через pread64, поэтому каждая операция read
+* требует ровно одного системного вызова без отдельного lseek.
+* readAt/readv не используют общую позицию и безопасны для одновременного вызова из нескольких потоков.
+* Поддерживаются как обычные файлы-образы, так и блочные устройства (/dev/sdX).
+*/
+class PosixFile : public IFile {
+public:
+	PosixFile();
+	~PosixFile();
+
+	bool open(const std::string& inFilePath) override;
+	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
+	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+	int getNativeDescriptor() const override { return fileDescriptor; }
+	uint64_t getSize() override;
+	uint64_t getModificationTime() override;
+
+	void advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) override;
+
+protected:
+	static constexpr uint64_t kUi64MaxChunk = 0x40000000;	// Максимальный объём одного системного вызова чтения (1 ГБ)
+
+	int fileDescriptor;
+	uint64_t ui64Position;
+	bool writeAll(int inFileDescriptor, const uint8_t* pUi8Data, size_t inDataSize, uint64_t inUi64Offset);
+};
+#endif
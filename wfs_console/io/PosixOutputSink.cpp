@@ -0,0 +1,178 @@
+#if !defined(_WIN32)
+#include "PosixOutputSink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+PosixOutputSink::PosixOutputSink() : fileDescriptor(-1), eKernelCopy(KernelCopy::Unknown), aiPipe{ -1, -1 } {};
+
+PosixOutputSink::~PosixOutputSink() {
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+	}
+	closePipe();
+};
+
+const char* PosixOutputSink::getKernelCopyName() const {
+	switch (eKernelCopy) {
+		case KernelCopy::CopyFileRange: return "copy_file_range";
+		case KernelCopy::Splice: return "splice";
+		default: return nullptr;
+	}
+};
+
+bool PosixOutputSink::openRaw(const std::string& inFilePath, uint64_t ui64ExpectedSize) {
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+	}
+
+	eKernelCopy = KernelCopy::Unknown;
+	fileDescriptor = ::open(inFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	if (ui64ExpectedSize != 0) {
+#if defined(__linux__)
+		// Выделение блоков под весь файл одним вызовом; ошибка (например, EOPNOTSUPP) не критична
+		fallocate(fileDescriptor, 0, 0, static_cast<off_t>(ui64ExpectedSize));
+#elif defined(__APPLE__)
+		fstore_t stStore = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(ui64ExpectedSize), 0 };
+		if (fcntl(fileDescriptor, F_PREALLOCATE, &stStore) != 0) {
+			stStore.fst_flags = F_ALLOCATEALL;
+			fcntl(fileDescriptor, F_PREALLOCATE, &stStore);
+		}
+#endif
+	}
+	return true;
+};
+
+bool PosixOutputSink::writeRaw(const uint8_t* pUi8Data, size_t szSize, uint64_t ui64Offset) {
+	size_t szWritten = 0;
+	while (szWritten < szSize) {
+		ssize_t iResultWrite = pwrite(fileDescriptor, pUi8Data + szWritten, szSize - szWritten, static_cast<off_t>(ui64Offset + szWritten));
+		if (iResultWrite < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		szWritten += static_cast<size_t>(iResultWrite);
+	}
+	return true;
+};
+
+bool PosixOutputSink::closeRaw(uint64_t ui64FinalSize) {
+	if (fileDescriptor < 0) {
+		return false;
+	}
+	bool bResult = (ftruncate(fileDescriptor, static_cast<off_t>(ui64FinalSize)) == 0);
+	if (::close(fileDescriptor) != 0) {
+		bResult = false;
+	}
+	fileDescriptor = -1;
+	return bResult;
+};
+
+/**
+* \brief
+* Копирование ядром. Способ определяется при первом вызове: copy_file_range, затем splice.
+* Если способ, работавший ранее, перестал работать, возвращается 0 и остаток дописывается через буфер.
+**/
+uint64_t PosixOutputSink::copyRaw(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size, uint64_t ui64Offset) {
+#if defined(__linux__)
+	if (fileDescriptor < 0 || eKernelCopy == KernelCopy::None) {
+		return 0;
+	}
+
+	if (eKernelCopy == KernelCopy::Unknown || eKernelCopy == KernelCopy::CopyFileRange) {
+		uint64_t ui64Copied = copyFileRange(iSourceDescriptor, ui64SourceOffset, ui64Size, ui64Offset);
+		if (ui64Copied > 0 || eKernelCopy == KernelCopy::CopyFileRange) {
+			eKernelCopy = KernelCopy::CopyFileRange;
+			return ui64Copied;
+		}
+	}
+
+	// copy_file_range не поддерживает блочные устройства и копирование между некоторыми файловыми системами
+	uint64_t ui64Copied = spliceRange(iSourceDescriptor, ui64SourceOffset, ui64Size, ui64Offset);
+	if (ui64Copied > 0) {
+		eKernelCopy = KernelCopy::Splice;
+	}
+	else if (eKernelCopy == KernelCopy::Unknown) {
+		eKernelCopy = KernelCopy::None;
+	}
+	return ui64Copied;
+#else
+	return 0;
+#endif
+};
+
+#if defined(__linux__)
+uint64_t PosixOutputSink::copyFileRange(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size, uint64_t ui64Offset) {
+	loff_t llSourceOffset = static_cast<loff_t>(ui64SourceOffset);
+	loff_t llOffset = static_cast<loff_t>(ui64Offset);
+	uint64_t ui64Copied = 0;
+	while (ui64Copied < ui64Size) {
+		size_t szChunk = static_cast<size_t>(std::min<uint64_t>(ui64Size - ui64Copied, 0x40000000));
+		ssize_t iResultCopy = copy_file_range(iSourceDescriptor, &llSourceOffset, fileDescriptor, &llOffset, szChunk, 0);
+		if (iResultCopy < 0) {
+			if (errno == EINTR) continue;
+			break;		// EXDEV, EINVAL, EOPNOTSUPP, ENOSYS и др.: способ недоступен
+		}
+		if (iResultCopy == 0) {
+			break;		// Конец исходного файла
+		}
+		ui64Copied += static_cast<uint64_t>(iResultCopy);
+	}
+	return ui64Copied;
+};
+
+uint64_t PosixOutputSink::spliceRange(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size, uint64_t ui64Offset) {
+	if (aiPipe[0] < 0) {
+		if (pipe2(aiPipe, O_CLOEXEC) != 0) {
+			aiPipe[0] = aiPipe[1] = -1;
+			return 0;
+		}
+		fcntl(aiPipe[1], F_SETPIPE_SZ, 0x100000);	// Увеличение канала до 1 МБ; при ошибке остаётся размер по умолчанию
+	}
+
+	loff_t llSourceOffset = static_cast<loff_t>(ui64SourceOffset);
+	loff_t llOffset = static_cast<loff_t>(ui64Offset);
+	uint64_t ui64Copied = 0;
+	while (ui64Copied < ui64Size) {
+		size_t szChunk = static_cast<size_t>(std::min<uint64_t>(ui64Size - ui64Copied, 0x100000));
+		ssize_t iResultIn = splice(iSourceDescriptor, &llSourceOffset, aiPipe[1], nullptr, szChunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+		if (iResultIn < 0 && errno == EINTR) {
+			continue;
+		}
+		if (iResultIn <= 0) {
+			break;
+		}
+
+		size_t szPending = static_cast<size_t>(iResultIn);
+		while (szPending > 0) {
+			ssize_t iResultOut = splice(aiPipe[0], nullptr, fileDescriptor, &llOffset, szPending, SPLICE_F_MOVE | SPLICE_F_MORE);
+			if (iResultOut < 0 && errno == EINTR) {
+				continue;
+			}
+			if (iResultOut <= 0) {
+				// Данные, оставшиеся в канале, отбрасываются, чтобы канал можно было использовать повторно
+				closePipe();
+				return ui64Copied;
+			}
+			szPending -= static_cast<size_t>(iResultOut);
+			ui64Copied += static_cast<uint64_t>(iResultOut);
+		}
+	}
+	return ui64Copied;
+};
+#endif
+
+void PosixOutputSink::closePipe() {
+	if (aiPipe[0] >= 0) {
+		::close(aiPipe[0]);
+		::close(aiPipe[1]);
+		aiPipe[0] = aiPipe[1] = -1;
+	}
+};
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#if !defined(_WIN32)
+#include <cstdint>
+#include <string>
+
+#include "IOutputSink.h"
+
+/*
+* Файл назначения для Linux и macOS на основе файлового дескриптора.
+* Место под итоговый размер резервируется через fallocate (Linux) или
+* fcntl(F_PREALLOCATE) (macOS), что уменьшает фрагментацию выгруженного файла.
+*
+* В Linux поддерживается копирование ядром (copyFrom): сначала пробуется copy_file_range
+* (для файлов-образов; на XFS/Btrfs допускает reflink без копирования данных), затем
+* splice через канал (для блочных устройств). Выбранный способ запоминается при первом вызове.
+*/
+class PosixOutputSink : public IOutputSink {
+public:
+	PosixOutputSink();
+	~PosixOutputSink();
+
+	const char* getKernelCopyName() const override;
+
+protected:
+	bool openRaw(const std::string& inFilePath, uint64_t ui64ExpectedSize) override;
+	bool writeRaw(const uint8_t* pUi8Data, size_t szSize, uint64_t ui64Offset) override;
+	bool closeRaw(uint64_t ui64FinalSize) override;
+	uint64_t copyRaw(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size, uint64_t ui64Offset) override;
+
+private:
+	// Способ копирования ядром
+	enum class KernelCopy : uint8_t {
+		Unknown,		// Ещё не определён
+		CopyFileRange,	// copy_file_range
+		Splice,			// splice через канал
+		None			// Недоступен, используется запись через буфер
+	};
+
+	int fileDescriptor;
+	KernelCopy eKernelCopy;
+	int aiPipe[2];		// Канал для splice, создаётся при первом использовании
+
+#if defined(__linux__)
+	uint64_t copyFileRange(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size, uint64_t ui64Offset);
+	uint64_t spliceRange(int iSourceDescriptor, uint64_t ui64SourceOffset, uint64_t ui64Size, uint64_t ui64Offset);
+#endif
+	void closePipe();
+};
+#endif
@@ -0,0 +1,282 @@
+#include "SegmentedFile.h"
+
+#include <algorithm>
+
+SegmentedFile::SegmentedFile(FileFactory fnFactory) : fnFactory_(std::move(fnFactory)), ui64TotalSize(0), ui64Position(0) {};
+
+SegmentedFile::~SegmentedFile() {
+	close();
+};
+
+/**
+* \brief
+* Частью разбитого образа считается только путь с расширением из ровно трех цифр (.001, .002, ...),
+* поэтому числовые расширения другой длины (например, image.2024) открываются как один файл.
+**/
+bool SegmentedFile::isSegmentPath(const std::string& inFilePath) {
+	if (inFilePath.size() <= kSzSuffixDigits + 1) {
+		return false;
+	}
+	size_t szDot = inFilePath.size() - kSzSuffixDigits - 1;
+	if (inFilePath[szDot] != '.' || inFilePath[szDot - 1] == '/' || inFilePath[szDot - 1] == '\\') {
+		return false;
+	}
+	return std::all_of(inFilePath.begin() + szDot + 1, inFilePath.end(), [](char chSymbol) { return chSymbol >= '0' && chSymbol <= '9'; });
+};
+
+/**
+* \brief
+* Открывает образ. Для пути к части разбитого образа открываются все части, начиная
+* с указанной, пока очередной номер существует; номер части увеличивается с сохранением
+* ширины (wfs.dd.009 -> wfs.dd.010).
+**/
+bool SegmentedFile::open(const std::string& inFilePath) {
+	close();
+
+	if (!isSegmentPath(inFilePath)) {
+		std::unique_ptr<IFile> imageFile = fnFactory_();
+		if (!imageFile || !imageFile->open(inFilePath)) {
+			return false;
+		}
+		// Если размер неизвестен, границы не нужны: чтение единственного файла не ограничивается
+		uint64_t ui64Size = imageFile->getSize();
+		addSegment(std::move(imageFile), (ui64Size == 0) ? UINT64_MAX : ui64Size);
+		return true;
+	}
+
+	size_t szDot = inFilePath.size() - kSzSuffixDigits - 1;
+	std::string stringBase = inFilePath.substr(0, szDot + 1);
+	size_t szWidth = kSzSuffixDigits;
+	// Расширение проверено isSegmentPath(): три цифры не переполняют счетчик
+	uint64_t ui64Number = 0;
+	for (size_t szIndex = szDot + 1; szIndex < inFilePath.size(); szIndex++) {
+		ui64Number = ui64Number * 10 + static_cast<uint64_t>(inFilePath[szIndex] - '0');
+	}
+
+	while (true) {
+		std::string stringNumber = std::to_string(ui64Number);
+		if (stringNumber.size() < szWidth) {
+			stringNumber.insert(0, szWidth - stringNumber.size(), '0');
+		}
+		std::unique_ptr<IFile> segmentFile = fnFactory_();
+		if (!segmentFile || !segmentFile->open(stringBase + stringNumber)) {
+			break;
+		}
+		// Размер каждой части должен быть известен, по нему строится карта смещений
+		uint64_t ui64Size = segmentFile->getSize();
+		if (ui64Size == 0) {
+			close();
+			return false;
+		}
+		addSegment(std::move(segmentFile), ui64Size);
+		ui64Number++;
+	}
+	return !vecSegments.empty();
+};
+
+bool SegmentedFile::setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) {
+	if (vecSegments.empty()) {
+		return false;
+	}
+	switch (ui8MoveMethod) {
+		case FILE_ORIGIN_BEGIN: ui64Position = ui64Offset; break;
+		case FILE_ORIGIN_CUR: ui64Position += ui64Offset; break;
+		case FILE_ORIGIN_END: ui64Position = ui64TotalSize + ui64Offset; break;
+		default: return false;
+	}
+	return true;
+};
+
+bool SegmentedFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	uint64_t ui64BytesRead = 0;
+	bool bResult = readAt(ui64Position, ui8Buffer, ui32Size, ui64BytesRead);
+	ui32BytesRead = static_cast<uint32_t>(ui64BytesRead);
+	ui64Position += ui64BytesRead;
+	return bResult;
+};
+
+bool SegmentedFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	std::unique_ptr<IFile> outputFile = fnFactory_();
+	return outputFile ? outputFile->writeToFile(inFilePath, pUi8Data, inDataSize) : false;
+};
+
+bool SegmentedFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	std::unique_ptr<IFile> outputFile = fnFactory_();
+	return outputFile ? outputFile->writeToFileAppend(inFilePath, pUi8Data, inDataSize) : false;
+};
+
+void SegmentedFile::close() {
+	for (Segment& stSegment : vecSegments) {
+		stSegment.file->close();
+	}
+	vecSegments.clear();
+	ui64TotalSize = 0;
+	ui64Position = 0;
+};
+
+/**
+* \brief
+* Позиционное чтение. Участок, пересекающий границы частей, читается по частям;
+* неполное чтение части (ошибка носителя, усечённая часть) завершает чтение.
+**/
+bool SegmentedFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (vecSegments.empty()) {
+		return false;
+	}
+	if (ui64Offset >= ui64TotalSize || ui64Size == 0) {
+		return true;	// Конец файла
+	}
+
+	size_t szSegment = findSegment(ui64Offset);
+	while (ui64BytesRead < ui64Size && szSegment < vecSegments.size()) {
+		Segment& stSegment = vecSegments[szSegment];
+		uint64_t ui64Local = ui64Offset + ui64BytesRead - stSegment.ui64Start;
+		uint64_t ui64Chunk = std::min(ui64Size - ui64BytesRead, stSegment.ui64Size - ui64Local);
+
+		uint64_t ui64ChunkRead = 0;
+		if (!stSegment.file->readAt(ui64Local, pUi8Buffer + ui64BytesRead, ui64Chunk, ui64ChunkRead)) {
+			return false;
+		}
+		ui64BytesRead += ui64ChunkRead;
+		if (ui64ChunkRead != ui64Chunk) {
+			break;
+		}
+		szSegment++;
+	}
+	return true;
+};
+
+/**
+* \brief
+* Пакетное позиционное чтение. Запросы распределяются по частям и передаются в readv
+* каждой части, поэтому объединение смежных запросов в реализации части сохраняется.
+* Запросы, пересекающие границу частей, выполняются через readAt.
+**/
+bool SegmentedFile::readv(std::vector<ReadRequest>& vecRequests) {
+	if (vecSegments.empty()) {
+		return false;
+	}
+
+	bool bResult = true;
+	std::vector<std::vector<ReadRequest>> vecSegmentRequests(vecSegments.size());
+	std::vector<std::vector<size_t>> vecSegmentIndices(vecSegments.size());
+
+	for (size_t szIter = 0; szIter < vecRequests.size(); szIter++) {
+		ReadRequest& stRequest = vecRequests[szIter];
+		stRequest.ui64BytesRead = 0;
+		if (stRequest.ui64Size == 0 || stRequest.ui64Offset >= ui64TotalSize) {
+			continue;
+		}
+
+		size_t szSegment = findSegment(stRequest.ui64Offset);
+		const Segment& stSegment = vecSegments[szSegment];
+		if (stRequest.ui64Offset + stRequest.ui64Size > stSegment.ui64Start + stSegment.ui64Size) {
+			if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+				bResult = false;
+			}
+			continue;
+		}
+
+		ReadRequest stLocalRequest = stRequest;
+		stLocalRequest.ui64Offset -= stSegment.ui64Start;
+		vecSegmentRequests[szSegment].push_back(stLocalRequest);
+		vecSegmentIndices[szSegment].push_back(szIter);
+	}
+
+	for (size_t szSegment = 0; szSegment < vecSegments.size(); szSegment++) {
+		if (vecSegmentRequests[szSegment].empty()) {
+			continue;
+		}
+		if (!vecSegments[szSegment].file->readv(vecSegmentRequests[szSegment])) {
+			bResult = false;
+		}
+		for (size_t szIter = 0; szIter < vecSegmentRequests[szSegment].size(); szIter++) {
+			vecRequests[vecSegmentIndices[szSegment][szIter]].ui64BytesRead = vecSegmentRequests[szSegment][szIter].ui64BytesRead;
+		}
+	}
+	return bResult;
+};
+
+/**
+* \brief
+* Прямой доступ возможен только к участку, целиком лежащему в одной части
+**/
+ByteView SegmentedFile::view(uint64_t ui64Offset, uint64_t ui64Length) {
+	if (vecSegments.empty() || ui64Offset >= ui64TotalSize) {
+		return ByteView{};
+	}
+	Segment& stSegment = vecSegments[findSegment(ui64Offset)];
+	if (ui64Offset + ui64Length > stSegment.ui64Start + stSegment.ui64Size) {
+		return ByteView{};
+	}
+	return stSegment.file->view(ui64Offset - stSegment.ui64Start, ui64Length);
+};
+
+void SegmentedFile::advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) {
+	if (vecSegments.empty() || ui64Offset >= ui64TotalSize) {
+		return;
+	}
+	uint64_t ui64End = (ui64Length == 0) ? ui64TotalSize : std::min(ui64TotalSize, ui64Offset + ui64Length);
+	for (size_t szSegment = findSegment(ui64Offset); szSegment < vecSegments.size() && vecSegments[szSegment].ui64Start < ui64End; szSegment++) {
+		Segment& stSegment = vecSegments[szSegment];
+		uint64_t ui64From = std::max(ui64Offset, stSegment.ui64Start);
+		uint64_t ui64To = std::min(ui64End, stSegment.ui64Start + stSegment.ui64Size);
+		stSegment.file->advise(ui64From - stSegment.ui64Start, ui64To - ui64From, eHint);
+	}
+};
+
+/**
+* \brief
+* Дескриптор с глобальными смещениями существует только у образа из одной части
+**/
+int SegmentedFile::getNativeDescriptor() const {
+	return (vecSegments.size() == 1) ? vecSegments.front().file->getNativeDescriptor() : -1;
+};
+
+void SegmentedFile::recordKernelRead(uint64_t ui64Offset, uint64_t ui64Size, uint64_t ui64Ns) {
+	if (vecSegments.size() == 1) {
+		vecSegments.front().file->recordKernelRead(ui64Offset, ui64Size, ui64Ns);
+	}
+};
+
+uint64_t SegmentedFile::getSize() {
+	return (ui64TotalSize == UINT64_MAX) ? 0 : ui64TotalSize;
+};
+
+/**
+* \brief
+* Возвращает наибольшее время изменения среди частей образа.
+**/
+uint64_t SegmentedFile::getModificationTime() {
+	uint64_t ui64Time = 0;
+	for (Segment& stSegment : vecSegments) {
+		ui64Time = std::max(ui64Time, stSegment.file->getModificationTime());
+	}
+	return ui64Time;
+};
+
+void SegmentedFile::setBlockSizeHint(uint32_t ui32BlockSize) {
+	for (Segment& stSegment : vecSegments) {
+		stSegment.file->setBlockSizeHint(ui32BlockSize);
+	}
+};
+
+/**
+* \brief
+* Двоичный поиск части, содержащей глобальное смещение ui64Offset (ui64Offset < ui64TotalSize)
+**/
+size_t SegmentedFile::findSegment(uint64_t ui64Offset) const {
+	auto iterSegment = std::upper_bound(vecSegments.begin(), vecSegments.end(), ui64Offset,
+		[](uint64_t ui64Value, const Segment& stSegment) { return ui64Value < stSegment.ui64Start; });
+	return static_cast<size_t>(iterSegment - vecSegments.begin()) - 1;
+};
+
+void SegmentedFile::addSegment(std::unique_ptr<IFile> inFile, uint64_t ui64Size) {
+	Segment stSegment;
+	stSegment.file = std::move(inFile);
+	stSegment.ui64Start = ui64TotalSize;
+	stSegment.ui64Size = ui64Size;
+	ui64TotalSize = (ui64Size == UINT64_MAX) ? UINT64_MAX : ui64TotalSize + ui64Size;
+	vecSegments.push_back(std::move(stSegment));
+};
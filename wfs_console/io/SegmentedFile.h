@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IFile.h"
+
+/*
+* Фабрика файлов для открытия отдельных частей образа
+*/
+using FileFactory = std::function<std::unique_ptr<IFile>()>;
+
+/*
+* Реализация IFile для образа, разбитого на части (wfs.dd.001, wfs.dd.002, ...),
+* без предварительного объединения частей в один файл.
+*
+* Если путь оканчивается числовым расширением, open() открывает эту часть и все
+* следующие по номеру (с той же шириной номера) до первой отсутствующей, иначе
+* открывается единственный файл. Каждая часть открывается реализацией IFile,
+* созданной фабрикой, поэтому разбитый образ можно читать любым способом чтения.
+*
+* Глобальное смещение сопоставляется с частью двоичным поиском по началам частей,
+* чтения через границу частей разбиваются прозрачно. Если образ состоит из одной части,
+* view() и getNativeDescriptor() передаются ей, и выгрузка копированием ядром сохраняется.
+*/
+class SegmentedFile : public IFile {
+public:
+	explicit SegmentedFile(FileFactory fnFactory);
+	~SegmentedFile();
+
+	bool open(const std::string& inFilePath) override;
+	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
+	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+
+	ByteView view(uint64_t ui64Offset, uint64_t ui64Length) override;
+	void advise(uint64_t ui64Offset, uint64_t ui64Length, FileAccessHint eHint) override;
+	int getNativeDescriptor() const override;
+	void recordKernelRead(uint64_t ui64Offset, uint64_t ui64Size, uint64_t ui64Ns) override;
+	uint64_t getSize() override;
+	uint64_t getModificationTime() override;
+	void setBlockSizeHint(uint32_t ui32BlockSize) override;
+
+	// Количество открытых частей образа
+	size_t getSegmentCount() const { return vecSegments.size(); }
+
+	// Количество цифр в расширении части разбитого образа (.001, .002, ...)
+	static constexpr size_t kSzSuffixDigits = 3;
+
+	// Признак пути к части разбитого образа (расширение из kSzSuffixDigits цифр)
+	static bool isSegmentPath(const std::string& inFilePath);
+
+private:
+	struct Segment {
+		std::unique_ptr<IFile> file;
+		uint64_t ui64Start = 0;		// Глобальное смещение начала части
+		uint64_t ui64Size = 0;		// Размер части в байтах
+	};
+
+	FileFactory fnFactory_;
+	std::vector<Segment> vecSegments;	// Упорядочены по ui64Start
+	uint64_t ui64TotalSize;
+	uint64_t ui64Position;
+
+	size_t findSegment(uint64_t ui64Offset) const;
+	void addSegment(std::unique_ptr<IFile> inFile, uint64_t ui64Size);
+};
@@ -1,6 +1,8 @@
 #ifdef _WIN32
 #include "WinFile.h"
 
+#include <winioctl.h>
+
 WinFile::WinFile() : fileHandle(INVALID_HANDLE_VALUE) {};
 
 WinFile::~WinFile() {
@@ -63,20 +65,116 @@ bool WinFile::setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) {
 };
 
 bool WinFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	ui32BytesRead = 0;
 	if (fileHandle == INVALID_HANDLE_VALUE) {
 		return false;
 	}
 
-	DWORD dwBytesRead = 0;
+	// Как и в PosixFile, неполное чтение у конца файла не является ошибкой: объём возвращается в ui32BytesRead
+	while (ui32BytesRead < ui32Size) {
+		DWORD dwBytesRead = 0;
+		if (!ReadFile(fileHandle, ui8Buffer + ui32BytesRead, ui32Size - ui32BytesRead, &dwBytesRead, NULL)) {
+			if (GetLastError() == ERROR_HANDLE_EOF) {
+				break;
+			}
+			return false;
+		}
+		if (dwBytesRead == 0) {
+			break;	// Конец файла
+		}
+		ui32BytesRead += static_cast<uint32_t>(dwBytesRead);
+	}
+	return true;
+};
 
-	bool blResultRead = ReadFile(fileHandle, ui8Buffer, ui32Size, &dwBytesRead, NULL);
-	if ((!blResultRead) || (ui32Size != dwBytesRead)) {
+/**
+* \brief
+* Позиционное чтение: смещение передаётся в структуре OVERLAPPED, поэтому
+* предварительный SetFilePointer не нужен и вызов не зависит от позиции, установленной setPosition.
+* Объём одного ReadFile ограничен DWORD, большие участки читаются частями.
+**/
+bool WinFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (fileHandle == INVALID_HANDLE_VALUE) {
 		return false;
 	}
-	ui32BytesRead = static_cast<uint32_t>(dwBytesRead);
+
+	while (ui64BytesRead < ui64Size) {
+		uint64_t ui64CurOffset = ui64Offset + ui64BytesRead;
+		DWORD dwChunk = static_cast<DWORD>((ui64Size - ui64BytesRead > 0x40000000) ? 0x40000000 : (ui64Size - ui64BytesRead));
+
+		OVERLAPPED stOverlapped = {};
+		stOverlapped.Offset = static_cast<DWORD>(ui64CurOffset & 0xFFFFFFFF);
+		stOverlapped.OffsetHigh = static_cast<DWORD>(ui64CurOffset >> 32);
+
+		DWORD dwBytesRead = 0;
+		if (!ReadFile(fileHandle, pUi8Buffer + ui64BytesRead, dwChunk, &dwBytesRead, &stOverlapped)) {
+			if (GetLastError() == ERROR_HANDLE_EOF) {
+				break;
+			}
+			return false;
+		}
+		if (dwBytesRead == 0) {
+			break;	// Конец файла
+		}
+		ui64BytesRead += dwBytesRead;
+	}
 	return true;
 };
 
+/**
+* \brief
+* Пакетное позиционное чтение. ReadFileScatter требует FILE_FLAG_NO_BUFFERING и буферов,
+* выровненных по странице, поэтому элементы читаются последовательными вызовами readAt.
+**/
+bool WinFile::readv(std::vector<ReadRequest>& vecRequests) {
+	bool bResult = true;
+	for (ReadRequest& stRequest : vecRequests) {
+		if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+			bResult = false;
+		}
+	}
+	return bResult;
+};
+
+/**
+* \brief
+* Возвращает размер открытого файла. Для физических дисков и томов (\\.\PhysicalDriveN)
+* GetFileSizeEx не работает, размер запрашивается через IOCTL_DISK_GET_LENGTH_INFO.
+**/
+uint64_t WinFile::getSize() {
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+
+	LARGE_INTEGER liFileSize;
+	if (GetFileSizeEx(fileHandle, &liFileSize) && liFileSize.QuadPart > 0) {
+		return static_cast<uint64_t>(liFileSize.QuadPart);
+	}
+
+	GET_LENGTH_INFORMATION stLengthInfo = {};
+	DWORD dwBytesReturned = 0;
+	if (DeviceIoControl(fileHandle, IOCTL_DISK_GET_LENGTH_INFO, NULL, 0, &stLengthInfo, sizeof(stLengthInfo), &dwBytesReturned, NULL)) {
+		return static_cast<uint64_t>(stLengthInfo.Length.QuadPart);
+	}
+	return 0;
+};
+
+/**
+* \brief
+* Возвращает время последней записи (FILETIME, интервалы по 100 нс от 1601 года),
+* приведённое к наносекундам от начала эпохи Unix.
+**/
+uint64_t WinFile::getModificationTime() {
+	FILETIME stLastWrite;
+	if (fileHandle == INVALID_HANDLE_VALUE || !GetFileTime(fileHandle, NULL, NULL, &stLastWrite)) {
+		return 0;
+	}
+	uint64_t ui64Ticks = (static_cast<uint64_t>(stLastWrite.dwHighDateTime) << 32) | stLastWrite.dwLowDateTime;
+	const uint64_t ui64EpochTicks = 116444736000000000ull;
+	return (ui64Ticks > ui64EpochTicks) ? (ui64Ticks - ui64EpochTicks) * 100 : 0;
+};
+
 void WinFile::close() {
 	if (fileHandle != INVALID_HANDLE_VALUE) {
 		CloseHandle(fileHandle);
@@ -84,7 +182,7 @@ void WinFile::close() {
 	}
 };
 
-bool WinFile::writeToFile(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pUi8Data, size_t inDataSize) {
+bool WinFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
 	DWORD ui32ResulGetLastErrorCode = NO_ERROR;
 
 	std::wstring widePath = utf8ToWide(inFilePath);
@@ -117,7 +215,7 @@ bool WinFile::writeToFile(const std::string& inFilePath, const std::unique_ptr<u
 	DWORD dwNumberOfBytesToWrite = 0;
 	BOOL bResult = WriteFile(
 		hFile,
-		pUi8Data.get(),
+		pUi8Data,
 		static_cast<DWORD>(inDataSize),
 		&dwNumberOfBytesToWrite,
 		nullptr
@@ -132,7 +230,7 @@ bool WinFile::writeToFile(const std::string& inFilePath, const std::unique_ptr<u
 	return true;
 };
 
-bool WinFile::writeToFileAppend(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pUi8Data, size_t inDataSize) {
+bool WinFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
 	DWORD ui32ResulGetLastErrorCode = NO_ERROR;
 
 	std::wstring widePath = utf8ToWide(inFilePath);
@@ -172,7 +270,7 @@ bool WinFile::writeToFileAppend(const std::string& inFilePath, const std::unique
 	DWORD dwNumberOfBytesToWrite = 0;
 	BOOL bResult = WriteFile(
 		hFile,
-		pUi8Data.get(),
+		pUi8Data,
 		static_cast<DWORD>(inDataSize),
 		&dwNumberOfBytesToWrite,
 		nullptr
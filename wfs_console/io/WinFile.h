@@ -15,9 +15,13 @@ public:
 	bool open(const std::string& inFilePath) override;
 	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
 	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
-	bool writeToFile(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pUi8Data, size_t inDataSize) override;
-	bool writeToFileAppend(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pUi8Data, size_t inDataSize) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
 	void close() override;	
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+	uint64_t getSize() override;
+	uint64_t getModificationTime() override;
 
 private:
 	HANDLE fileHandle;
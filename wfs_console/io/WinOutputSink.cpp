@@ -0,0 +1,105 @@
+#ifdef _WIN32
+#include "WinOutputSink.h"
+
+WinOutputSink::WinOutputSink() : fileHandle(INVALID_HANDLE_VALUE), ui64WrittenEnd(0) {};
+
+WinOutputSink::~WinOutputSink() {
+	// Незавершённая выгрузка: зарезервированный размер не должен оставаться в файле
+	if (fileHandle != INVALID_HANDLE_VALUE) {
+		truncateAndClose(ui64WrittenEnd);
+	}
+};
+
+bool WinOutputSink::openRaw(const std::string& inFilePath, uint64_t ui64ExpectedSize) {
+	if (fileHandle != INVALID_HANDLE_VALUE) {
+		truncateAndClose(ui64WrittenEnd);
+	}
+	ui64WrittenEnd = 0;
+
+	std::wstring widePath = utf8ToWide(inFilePath);
+	if (widePath.empty()) return false;
+
+	fileHandle = CreateFileW(
+		widePath.c_str(),
+		GENERIC_WRITE,
+		0,
+		nullptr,
+		CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr
+	);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	if (ui64ExpectedSize != 0) {
+		LARGE_INTEGER liSize;
+		liSize.QuadPart = static_cast<LONGLONG>(ui64ExpectedSize);
+		if (SetFilePointerEx(fileHandle, liSize, nullptr, FILE_BEGIN) && SetEndOfFile(fileHandle)) {
+			// Без привилегии SE_MANAGE_VOLUME_NAME вызов завершается ошибкой, что допустимо
+			SetFileValidData(fileHandle, liSize.QuadPart);
+		}
+	}
+	return true;
+};
+
+bool WinOutputSink::writeRaw(const uint8_t* pUi8Data, size_t szSize, uint64_t ui64Offset) {
+	size_t szWritten = 0;
+	while (szWritten < szSize) {
+		uint64_t ui64CurOffset = ui64Offset + szWritten;
+		DWORD dwChunk = static_cast<DWORD>((szSize - szWritten > 0x40000000) ? 0x40000000 : (szSize - szWritten));
+
+		OVERLAPPED stOverlapped = {};
+		stOverlapped.Offset = static_cast<DWORD>(ui64CurOffset & 0xFFFFFFFF);
+		stOverlapped.OffsetHigh = static_cast<DWORD>(ui64CurOffset >> 32);
+
+		DWORD dwBytesWritten = 0;
+		if (!WriteFile(fileHandle, pUi8Data + szWritten, dwChunk, &dwBytesWritten, &stOverlapped) || dwBytesWritten == 0) {
+			return false;
+		}
+		szWritten += dwBytesWritten;
+		if (ui64CurOffset + dwBytesWritten > ui64WrittenEnd) {
+			ui64WrittenEnd = ui64CurOffset + dwBytesWritten;
+		}
+	}
+	return true;
+};
+
+bool WinOutputSink::closeRaw(uint64_t ui64FinalSize) {
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	return truncateAndClose(ui64FinalSize);
+};
+
+/**
+* \brief
+* Устанавливает размер файла ui64Size и закрывает его. После SetFileValidData в
+* зарезервированной, но не записанной части файла находятся прежние данные тома,
+* поэтому файл всегда усекается до записанных данных.
+**/
+bool WinOutputSink::truncateAndClose(uint64_t ui64Size) {
+	LARGE_INTEGER liSize;
+	liSize.QuadPart = static_cast<LONGLONG>(ui64Size);
+	bool bResult = SetFilePointerEx(fileHandle, liSize, nullptr, FILE_BEGIN) && SetEndOfFile(fileHandle);
+	if (!CloseHandle(fileHandle)) {
+		bResult = false;
+	}
+	fileHandle = INVALID_HANDLE_VALUE;
+	return bResult;
+};
+
+std::wstring WinOutputSink::utf8ToWide(const std::string& utf8Str) {
+	int len = MultiByteToWideChar(CP_UTF8, 0, utf8Str.c_str(), -1, nullptr, 0);
+	if (len == 0) return L"";
+
+	std::wstring result(len, 0);
+	if (MultiByteToWideChar(CP_UTF8, 0, utf8Str.c_str(), -1, &result[0], len) == 0) return L"";
+
+	if (!result.empty() && result.back() == L'\0') {
+		result.pop_back(); // Удаление \0
+	}
+
+	return result;
+}
+#endif
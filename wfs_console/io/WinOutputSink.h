@@ -0,0 +1,32 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+
+#include "IOutputSink.h"
+
+/*
+* Файл назначения для Windows.
+* Итоговый размер устанавливается заранее через SetEndOfFile, после чего
+* SetFileValidData отключает обнуление выделенных кластеров (требуется привилегия
+* SE_MANAGE_VOLUME_NAME; без неё резервирование выполняется без этой оптимизации).
+*/
+class WinOutputSink : public IOutputSink {
+public:
+	WinOutputSink();
+	~WinOutputSink();
+
+protected:
+	bool openRaw(const std::string& inFilePath, uint64_t ui64ExpectedSize) override;
+	bool writeRaw(const uint8_t* pUi8Data, size_t szSize, uint64_t ui64Offset) override;
+	bool closeRaw(uint64_t ui64FinalSize) override;
+
+private:
+	HANDLE fileHandle;
+	uint64_t ui64WrittenEnd;	// Конец записанных данных; до него усекается файл незавершённой выгрузки
+
+	bool truncateAndClose(uint64_t ui64Size);
+	std::wstring utf8ToWide(const std::string& utf8Str);
+};
+#endif
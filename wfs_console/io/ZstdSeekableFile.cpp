@@ -0,0 +1,275 @@
+#if defined(WFS_WITH_ZSTD)
+#include "ZstdSeekableFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <zstd.h>
+
+namespace {
+	constexpr uint32_t kUi32SkippableMagic = 0x184D2A5E;	// Пропускаемый кадр с таблицей поиска
+	constexpr uint32_t kUi32SeekableMagic = 0x8F92EAB1;		// Сигнатура в конце таблицы поиска
+	constexpr uint32_t kUi32FooterSize = 9;					// Количество кадров, дескриптор таблицы, сигнатура
+	constexpr uint32_t kUi32FrameHeaderSize = 8;			// Сигнатура и размер пропускаемого кадра
+	constexpr uint8_t kUi8ChecksumFlag = 0x80;				// В записях таблицы есть контрольные суммы кадров
+	constexpr uint8_t kUi8ReservedBits = 0x7C;
+
+	uint32_t readLE32(const uint8_t* pUi8Data) {
+		return static_cast<uint32_t>(pUi8Data[0]) | (static_cast<uint32_t>(pUi8Data[1]) << 8) |
+			(static_cast<uint32_t>(pUi8Data[2]) << 16) | (static_cast<uint32_t>(pUi8Data[3]) << 24);
+	}
+}
+
+ZstdSeekableFile::ZstdSeekableFile(std::unique_ptr<IFile> inFile)
+	: inputFile_(std::move(inFile)), ui64DecompressedSize(0), ui64Position(0), ui64CachedBytes(0), ui64DecompressedFrames(0) {};
+
+ZstdSeekableFile::~ZstdSeekableFile() {
+	close();
+	for (ZSTD_DCtx* pContext : vecContexts) {
+		ZSTD_freeDCtx(pContext);
+	}
+};
+
+bool ZstdSeekableFile::isCompressedPath(const std::string& inFilePath) {
+	static const std::string stringExtension = ".zst";
+	return inFilePath.size() > stringExtension.size() &&
+		inFilePath.compare(inFilePath.size() - stringExtension.size(), stringExtension.size(), stringExtension) == 0;
+};
+
+bool ZstdSeekableFile::open(const std::string& inFilePath) {
+	close();
+	if (!inputFile_->open(inFilePath)) {
+		return false;
+	}
+	if (!readSeekTable()) {
+		close();
+		return false;
+	}
+	return true;
+};
+
+bool ZstdSeekableFile::setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) {
+	switch (ui8MoveMethod) {
+		case FILE_ORIGIN_BEGIN: ui64Position = ui64Offset; break;
+		case FILE_ORIGIN_CUR: ui64Position += ui64Offset; break;
+		case FILE_ORIGIN_END: ui64Position = ui64DecompressedSize + ui64Offset; break;
+		default: return false;
+	}
+	return true;
+};
+
+bool ZstdSeekableFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) {
+	uint64_t ui64BytesRead = 0;
+	bool bResult = readAt(ui64Position, ui8Buffer, ui32Size, ui64BytesRead);
+	ui32BytesRead = static_cast<uint32_t>(ui64BytesRead);
+	ui64Position += ui64BytesRead;
+	return bResult;
+};
+
+bool ZstdSeekableFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	return inputFile_->writeToFile(inFilePath, pUi8Data, inDataSize);
+};
+
+bool ZstdSeekableFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
+	return inputFile_->writeToFileAppend(inFilePath, pUi8Data, inDataSize);
+};
+
+void ZstdSeekableFile::close() {
+	if (inputFile_) {
+		inputFile_->close();
+	}
+	clearCache();
+	vecFrames.clear();
+	ui64DecompressedSize = 0;
+	ui64Position = 0;
+	ui64DecompressedFrames = 0;
+};
+
+/**
+* \brief
+* Позиционное чтение распакованных данных. Распаковываются только кадры,
+* пересекающиеся с запрошенным участком.
+**/
+bool ZstdSeekableFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (vecFrames.empty()) {
+		return false;
+	}
+	if (ui64Offset >= ui64DecompressedSize || ui64Size == 0) {
+		return true;	// Конец файла
+	}
+
+	for (size_t szFrame = findFrame(ui64Offset); ui64BytesRead < ui64Size && szFrame < vecFrames.size(); szFrame++) {
+		std::shared_ptr<std::vector<uint8_t>> frameData = getFrame(szFrame);
+		if (!frameData) {
+			return false;
+		}
+		uint64_t ui64Local = ui64Offset + ui64BytesRead - vecFrames[szFrame].ui64DecompressedOffset;
+		uint64_t ui64Chunk = std::min<uint64_t>(ui64Size - ui64BytesRead, frameData->size() - ui64Local);
+		std::memcpy(pUi8Buffer + ui64BytesRead, frameData->data() + ui64Local, static_cast<size_t>(ui64Chunk));
+		ui64BytesRead += ui64Chunk;
+	}
+	return true;
+};
+
+bool ZstdSeekableFile::readv(std::vector<ReadRequest>& vecRequests) {
+	bool bResult = true;
+	for (ReadRequest& stRequest : vecRequests) {
+		if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+			bResult = false;
+		}
+	}
+	return bResult;
+};
+
+/**
+* \brief
+* Читает таблицу поиска в конце файла и строит карту кадров.
+* Контрольные суммы кадров (если есть) не проверяются: целостность данных
+* обеспечивает контрольная сумма внутри каждого кадра zstd.
+*
+* \return
+* false, если файл не является архивом zstd seekable или таблица повреждена.
+**/
+bool ZstdSeekableFile::readSeekTable() {
+	uint64_t ui64FileSize = inputFile_->getSize();
+	if (ui64FileSize < kUi32FrameHeaderSize + kUi32FooterSize) {
+		return false;
+	}
+
+	uint8_t aUi8Footer[kUi32FooterSize];
+	uint64_t ui64BytesRead = 0;
+	if (!inputFile_->readAt(ui64FileSize - kUi32FooterSize, aUi8Footer, kUi32FooterSize, ui64BytesRead) || ui64BytesRead != kUi32FooterSize) {
+		return false;
+	}
+	uint32_t ui32FrameCount = readLE32(aUi8Footer);
+	uint8_t ui8Descriptor = aUi8Footer[4];
+	if (readLE32(aUi8Footer + 5) != kUi32SeekableMagic || (ui8Descriptor & kUi8ReservedBits) != 0) {
+		return false;
+	}
+
+	uint64_t ui64EntrySize = (ui8Descriptor & kUi8ChecksumFlag) ? 12 : 8;
+	uint64_t ui64TableSize = ui64EntrySize * ui32FrameCount + kUi32FooterSize;
+	if (ui64TableSize + kUi32FrameHeaderSize > ui64FileSize) {
+		return false;
+	}
+
+	uint64_t ui64TableOffset = ui64FileSize - ui64TableSize - kUi32FrameHeaderSize;
+	std::vector<uint8_t> vecTable(static_cast<size_t>(ui64TableSize + kUi32FrameHeaderSize));
+	if (!inputFile_->readAt(ui64TableOffset, vecTable.data(), vecTable.size(), ui64BytesRead) || ui64BytesRead != vecTable.size()) {
+		return false;
+	}
+	if (readLE32(vecTable.data()) != kUi32SkippableMagic || readLE32(vecTable.data() + 4) != ui64TableSize) {
+		return false;
+	}
+
+	uint64_t ui64CompressedOffset = 0;
+	uint64_t ui64DecompressedOffset = 0;
+	vecFrames.reserve(ui32FrameCount);
+	for (uint32_t ui32Iter = 0; ui32Iter < ui32FrameCount; ui32Iter++) {
+		const uint8_t* pUi8Entry = vecTable.data() + kUi32FrameHeaderSize + ui64EntrySize * ui32Iter;
+		ZstdFrame stFrame;
+		stFrame.ui64CompressedOffset = ui64CompressedOffset;
+		stFrame.ui64DecompressedOffset = ui64DecompressedOffset;
+		stFrame.ui32CompressedSize = readLE32(pUi8Entry);
+		stFrame.ui32DecompressedSize = readLE32(pUi8Entry + 4);
+		ui64CompressedOffset += stFrame.ui32CompressedSize;
+		ui64DecompressedOffset += stFrame.ui32DecompressedSize;
+		// Пустые кадры не содержат данных и не участвуют в поиске
+		if (stFrame.ui32DecompressedSize != 0) {
+			vecFrames.push_back(stFrame);
+		}
+	}
+
+	// Кадры должны занимать всё пространство до таблицы поиска
+	if (ui64CompressedOffset != ui64TableOffset) {
+		vecFrames.clear();
+		return false;
+	}
+	ui64DecompressedSize = ui64DecompressedOffset;
+	return true;
+};
+
+/**
+* \brief
+* Двоичный поиск кадра, содержащего смещение ui64Offset распакованных данных (ui64Offset < ui64DecompressedSize)
+**/
+size_t ZstdSeekableFile::findFrame(uint64_t ui64Offset) const {
+	auto iterFrame = std::upper_bound(vecFrames.begin(), vecFrames.end(), ui64Offset,
+		[](uint64_t ui64Value, const ZstdFrame& stFrame) { return ui64Value < stFrame.ui64DecompressedOffset; });
+	return static_cast<size_t>(iterFrame - vecFrames.begin()) - 1;
+};
+
+/**
+* \brief
+* Возвращает распакованные данные кадра из кэша или распаковывает кадр.
+* Чтение и распаковка выполняются без блокировки кэша, поэтому разные кадры
+* распаковываются параллельно; данные остаются действительными и после вытеснения кадра.
+*
+* \return
+* nullptr при ошибке чтения или распаковки.
+**/
+std::shared_ptr<std::vector<uint8_t>> ZstdSeekableFile::getFrame(size_t szFrame) {
+	ZSTD_DCtx* pContext = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutexCache);
+		auto iterFrame = mapCachedFrames.find(szFrame);
+		if (iterFrame != mapCachedFrames.end()) {
+			listLru.splice(listLru.begin(), listLru, iterFrame->second.iterLru);
+			return iterFrame->second.data;
+		}
+		if (!vecContexts.empty()) {
+			pContext = vecContexts.back();
+			vecContexts.pop_back();
+		}
+	}
+	if (pContext == nullptr) {
+		pContext = ZSTD_createDCtx();
+		if (pContext == nullptr) {
+			return nullptr;
+		}
+	}
+
+	const ZstdFrame& stFrame = vecFrames[szFrame];
+	std::unique_ptr<uint8_t[]> pUi8Compressed(new uint8_t[stFrame.ui32CompressedSize]);
+	std::shared_ptr<std::vector<uint8_t>> frameData = std::make_shared<std::vector<uint8_t>>(stFrame.ui32DecompressedSize);
+
+	uint64_t ui64BytesRead = 0;
+	bool bResult = inputFile_->readAt(stFrame.ui64CompressedOffset, pUi8Compressed.get(), stFrame.ui32CompressedSize, ui64BytesRead) &&
+		ui64BytesRead == stFrame.ui32CompressedSize;
+	if (bResult) {
+		size_t szResult = ZSTD_decompressDCtx(pContext, frameData->data(), frameData->size(), pUi8Compressed.get(), stFrame.ui32CompressedSize);
+		bResult = !ZSTD_isError(szResult) && szResult == stFrame.ui32DecompressedSize;
+	}
+	ui64DecompressedFrames++;
+
+	std::lock_guard<std::mutex> lock(mutexCache);
+	vecContexts.push_back(pContext);
+	if (!bResult) {
+		return nullptr;
+	}
+
+	auto iterFrame = mapCachedFrames.find(szFrame);
+	if (iterFrame != mapCachedFrames.end()) {
+		return iterFrame->second.data;	// Кадр распакован параллельно другим потоком
+	}
+	while (!listLru.empty() && listLru.size() >= kUi32MinCachedFrames && ui64CachedBytes + frameData->size() > kUi64FrameCacheCapacity) {
+		auto iterEvicted = mapCachedFrames.find(listLru.back());
+		ui64CachedBytes -= iterEvicted->second.data->size();
+		mapCachedFrames.erase(iterEvicted);
+		listLru.pop_back();
+	}
+	listLru.push_front(szFrame);
+	CachedFrame& stCachedFrame = mapCachedFrames[szFrame];
+	stCachedFrame.iterLru = listLru.begin();
+	stCachedFrame.data = frameData;
+	ui64CachedBytes += frameData->size();
+	return frameData;
+};
+
+void ZstdSeekableFile::clearCache() {
+	std::lock_guard<std::mutex> lock(mutexCache);
+	mapCachedFrames.clear();
+	listLru.clear();
+	ui64CachedBytes = 0;
+};
+#endif
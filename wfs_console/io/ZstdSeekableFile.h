@@ -0,0 +1,89 @@
+#pragma once
+#if defined(WFS_WITH_ZSTD)
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IFile.h"
+
+struct ZSTD_DCtx_s;
+
+/*
+* Реализация IFile для образа, сжатого в формате zstd seekable (wfs.dd.zst).
+* Образ хранится последовательностью независимых кадров zstd, за которыми следует
+* таблица поиска (пропускаемый кадр с размерами каждого кадра до и после сжатия).
+* Зарезервированные дескрипторы (0xFE) и пустые участки DataArea сжимаются очень хорошо,
+* а читать такой архив можно без распаковки всего образа на диск.
+*
+* При открытии читается только таблица поиска. readAt находит нужные кадры двоичным
+* поиском по смещениям распакованных данных и распаковывает только их; распакованные
+* кадры хранятся в небольшом кэше LRU (kUi64FrameCacheCapacity), поэтому соседние
+* небольшие чтения не распаковывают кадр повторно. readAt потокобезопасен.
+*
+* Сжатые данные читаются исходным IFile, поэтому архив можно читать любым способом чтения.
+* Такой архив создаётся, например, утилитой zstd из contrib/seekable_format.
+*/
+class ZstdSeekableFile : public IFile {
+public:
+	explicit ZstdSeekableFile(std::unique_ptr<IFile> inFile);
+	~ZstdSeekableFile();
+
+	bool open(const std::string& inFilePath) override;
+	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
+	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) override;
+	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+	uint64_t getSize() override { return ui64DecompressedSize; }
+	uint64_t getModificationTime() override { return inputFile_->getModificationTime(); }
+
+	// Количество кадров zstd в образе
+	size_t getFrameCount() const { return vecFrames.size(); }
+
+	// Количество распаковок кадров с момента открытия (промахи кэша кадров)
+	uint64_t getDecompressedFrames() const { return ui64DecompressedFrames; }
+
+	// Признак пути к сжатому образу (расширение .zst)
+	static bool isCompressedPath(const std::string& inFilePath);
+
+private:
+	static constexpr uint64_t kUi64FrameCacheCapacity = 0x4000000;	// Объём кэша распакованных кадров (64 МБ)
+	static constexpr uint32_t kUi32MinCachedFrames = 2;				// Кэш вмещает не меньше двух кадров независимо от их размера
+
+	struct ZstdFrame {
+		uint64_t ui64CompressedOffset = 0;		// Смещение кадра в сжатом файле
+		uint64_t ui64DecompressedOffset = 0;	// Смещение данных кадра в образе
+		uint32_t ui32CompressedSize = 0;
+		uint32_t ui32DecompressedSize = 0;
+	};
+
+	struct CachedFrame {
+		std::list<size_t>::iterator iterLru;
+		std::shared_ptr<std::vector<uint8_t>> data;
+	};
+
+	std::unique_ptr<IFile> inputFile_;
+	std::vector<ZstdFrame> vecFrames;		// Упорядочены по ui64DecompressedOffset
+	uint64_t ui64DecompressedSize;
+	uint64_t ui64Position;
+
+	std::mutex mutexCache;					// Защищает кэш кадров и пул контекстов
+	std::list<size_t> listLru;				// Номера кадров, от недавно использованных к давно использованным
+	std::unordered_map<size_t, CachedFrame> mapCachedFrames;
+	uint64_t ui64CachedBytes;
+	std::vector<ZSTD_DCtx_s*> vecContexts;	// Свободные контексты распаковки
+	std::atomic<uint64_t> ui64DecompressedFrames;
+
+	bool readSeekTable();
+	size_t findFrame(uint64_t ui64Offset) const;
+	std::shared_ptr<std::vector<uint8_t>> getFrame(size_t szFrame);
+	void clearCache();
+};
+#endif
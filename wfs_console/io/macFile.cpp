@@ -1,7 +1,13 @@
 #if defined(__MACH__) && defined(__APPLE__)
 #include "macFile.h"
 
-macFile::macFile() {};
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/disk.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+macFile::macFile() : fileDescriptor(-1) {};
 
 macFile::~macFile() {
 	close();
@@ -18,6 +24,13 @@ bool macFile::open(const std::string& inFilePath) {
 	if (inputFile_.fail()) {
 		return false;
 	}
+
+	// Отдельный дескриптор для позиционного чтения, не разделяющий позицию с потоком
+	fileDescriptor = ::open(inFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fileDescriptor < 0) {
+		inputFile_.close();
+		return false;
+	}
 	return true;
 };
 
@@ -46,13 +59,83 @@ bool macFile::read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRea
 	return inputFile_.bad() ? false : true;
 };
 
+/**
+* \brief
+* Позиционное чтение через pread. Позиция потока inputFile_ не затрагивается,
+* поэтому вызов безопасен при одновременном обращении из нескольких потоков.
+**/
+bool macFile::readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) {
+	ui64BytesRead = 0;
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	while (ui64BytesRead < ui64Size) {
+		// Ядро Darwin принимает за один вызов не более INT_MAX байт
+		size_t szChunk = static_cast<size_t>((ui64Size - ui64BytesRead > 0x40000000) ? 0x40000000 : (ui64Size - ui64BytesRead));
+		ssize_t iResultRead = pread(fileDescriptor, pUi8Buffer + ui64BytesRead, szChunk, static_cast<off_t>(ui64Offset + ui64BytesRead));
+		if (iResultRead < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (iResultRead == 0) {
+			break;	// Конец файла
+		}
+		ui64BytesRead += static_cast<uint64_t>(iResultRead);
+	}
+	return true;
+};
+
+bool macFile::readv(std::vector<ReadRequest>& vecRequests) {
+	bool bResult = true;
+	for (ReadRequest& stRequest : vecRequests) {
+		if (!readAt(stRequest.ui64Offset, stRequest.pUi8Buffer, stRequest.ui64Size, stRequest.ui64BytesRead)) {
+			bResult = false;
+		}
+	}
+	return bResult;
+};
+
+/**
+* \brief
+* Возвращает размер открытого файла. Для блочных устройств st_size равен нулю,
+* поэтому размер вычисляется через DKIOCGETBLOCKSIZE и DKIOCGETBLOCKCOUNT.
+**/
+uint64_t macFile::getSize() {
+	struct stat stFileStat;
+	if (fileDescriptor < 0 || fstat(fileDescriptor, &stFileStat) != 0) {
+		return 0;
+	}
+	if (S_ISBLK(stFileStat.st_mode) || S_ISCHR(stFileStat.st_mode)) {
+		uint32_t ui32BlockSize = 0;
+		uint64_t ui64BlockCount = 0;
+		if (ioctl(fileDescriptor, DKIOCGETBLOCKSIZE, &ui32BlockSize) != 0 || ioctl(fileDescriptor, DKIOCGETBLOCKCOUNT, &ui64BlockCount) != 0) {
+			return 0;
+		}
+		return static_cast<uint64_t>(ui32BlockSize) * ui64BlockCount;
+	}
+	return static_cast<uint64_t>(stFileStat.st_size);
+};
+
+uint64_t macFile::getModificationTime() {
+	struct stat stFileStat;
+	if (fileDescriptor < 0 || fstat(fileDescriptor, &stFileStat) != 0) {
+		return 0;
+	}
+	return static_cast<uint64_t>(stFileStat.st_mtimespec.tv_sec) * 1000000000ull + static_cast<uint64_t>(stFileStat.st_mtimespec.tv_nsec);
+};
+
 void macFile::close() {
 	if (inputFile_.is_open()) {
 		inputFile_.close();
 	}
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
 };
 
-bool macFile::writeToFile(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pUi8Data, size_t inDataSize) {
+bool macFile::writeToFile(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
 	if (inDataSize == 0 || !pUi8Data) {
 		return false;
 	}
@@ -62,7 +145,7 @@ bool macFile::writeToFile(const std::string& inFilePath, const std::unique_ptr<u
 		return false;
 	}
 
-	outputFile.write(reinterpret_cast<const char*>(pUi8Data.get()), inDataSize);
+	outputFile.write(reinterpret_cast<const char*>(pUi8Data), inDataSize);
 	if (!outputFile) {
 		return false;
 	}
@@ -71,7 +154,7 @@ bool macFile::writeToFile(const std::string& inFilePath, const std::unique_ptr<u
 	return true;
 };
 
-bool macFile::writeToFileAppend(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pUi8Data, size_t inDataSize) {
+bool macFile::writeToFileAppend(const std::string& inFilePath, const uint8_t* pUi8Data, size_t inDataSize) {
 	if (inDataSize == 0 || !pUi8Data) {
 		return false;
 	}
@@ -81,7 +164,7 @@ bool macFile::writeToFileAppend(const std::string& inFilePath, const std::unique
 		return false;
 	}
 
-	outputFile.write(reinterpret_cast<const char*>(pUi8Data.get()), inDataSize);
+	outputFile.write(reinterpret_cast<const char*>(pUi8Data), inDataSize);
 	if (!outputFile) {
 		return false;
 	}
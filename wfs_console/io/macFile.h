@@ -16,11 +16,17 @@ public:
 	bool open(const std::string& inFilePath) override;
 	bool setPosition(uint64_t ui64Offset, uint8_t ui8MoveMethod) override;
 	bool read(uint8_t* ui8Buffer, uint32_t ui32Size, uint32_t& ui32BytesRead) override;
-	bool writeToFile(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pData, size_t dataSize) override;
-	bool writeToFileAppend(const std::string& inFilePath, const std::unique_ptr<uint8_t[]>& pData, size_t dataSize) override;
+	bool writeToFile(const std::string& inFilePath, const uint8_t* pData, size_t dataSize) override;
+	bool writeToFileAppend(const std::string& inFilePath, const uint8_t* pData, size_t dataSize) override;
 	void close() override;
+	bool readAt(uint64_t ui64Offset, uint8_t* pUi8Buffer, uint64_t ui64Size, uint64_t& ui64BytesRead) override;
+	bool readv(std::vector<ReadRequest>& vecRequests) override;
+	int getNativeDescriptor() const override { return fileDescriptor; }
+	uint64_t getSize() override;
+	uint64_t getModificationTime() override;
 
 private:
 	std::ifstream inputFile_;
+	int fileDescriptor;		// Дескриптор для позиционного чтения (readAt/readv)
 };
 #endif
\ No newline at end of file
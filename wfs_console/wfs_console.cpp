@@ -1,28 +1,105 @@
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <locale>
 #include <codecvt>
+#include <chrono>
+#include <iomanip>
+#include <fstream>
+#include <thread>
+#include <csignal>
 
 #include "./core/FileSystem_WFS.h"
+#include "./io/CachedFile.h"
+#include "./io/SegmentedFile.h"
+#include "./io/InstrumentedFile.h"
+#if defined(WFS_WITH_ZSTD)
+#include "./io/ZstdSeekableFile.h"
+#endif
 #if defined(__MACH__) && defined(__APPLE__)
 #include "./io/macFile.h"
 #elif defined(_WIN32)
 #include "./io/WinFile.h"
+#elif defined(__linux__)
+#include "./io/PosixFile.h"
+#endif
+#if defined(__linux__) || defined(__APPLE__)
+#include "./io/MmapFile.h"
 #endif
+#if defined(__linux__)
+#include "./io/DirectFile.h"
+#endif
+
+// Наибольшее количество потоков разбора (--threads)
+static constexpr uint32_t kUi32MaxThreads = 1024;
+// Наибольший интервал опроса SuperBlock в секундах (--watch)
+static constexpr uint32_t kUi32MaxWatchSeconds = 86400;
+
+// Установлен обработчиком SIGINT/SIGTERM; завершает опрос --watch
+static volatile std::sig_atomic_t g_iStopWatch = 0;
+
+void StopWatchHandler(int /*inISignal*/) {
+	g_iStopWatch = 1;
+}
 
 void PrintHelp() {
 	std::cout << "WFS Console Tool — утилита для работы с файловой системой WFS." << std::endl;
 	std::cout << std::endl;
 	std::cout << "Использование:" << std::endl;
-	std::cout << "    wfs_console <путь_к_образу_WFS>" << std::endl;
+	std::cout << "    wfs_console [--backend=<имя>] [--cache] [--io-stats[=<файл>]] [--threads=<N>] [--index-cache[=<файл>]] [--watch[=<секунды>]] [--anomalies=<файл>] [--anomaly-samples=<N>] [--bench] [--export=<номер> | --export-run=<номер> --out=<файл>] <путь_к_образу_WFS>" << std::endl;
+	std::cout << "    wfs_console info [--backend=<имя>] <путь_к_образу_WFS>" << std::endl;
+	std::cout << std::endl;
+	std::cout << "Команды:" << std::endl;
+	std::cout << "    info                  Вывести информацию из заголовка и SuperBlock без разбора IndexArea." << std::endl;
 	std::cout << std::endl;
 	std::cout << "Параметры:" << std::endl;
 	std::cout << "    <путь_к_образу_WFS>   Путь к файлу-образу DVR/WFS. Поддерживаются пути в UTF-8." << std::endl;
+	std::cout << "                          Для образа, разбитого на части (wfs.dd.001, wfs.dd.002, ...), указывается первая часть." << std::endl;
+#if defined(WFS_WITH_ZSTD)
+	std::cout << "                          Образ с расширением .zst читается как архив zstd seekable без распаковки на диск." << std::endl;
+#endif
+	std::cout << "    --backend=<имя>       Способ чтения образа:" << std::endl;
+	std::cout << "                            native - системный API платформы (по умолчанию);" << std::endl;
+	std::cout << "                            mmap   - отображение файла-образа в память без копирования (Linux, macOS; не для устройств);" << std::endl;
+	std::cout << "                            direct - чтение в обход страничного кэша, O_DIRECT (Linux)." << std::endl;
+	std::cout << "    --cache               Читать образ через кэш блоков с упреждающим чтением и вывести статистику кэша." << std::endl;
+	std::cout << "    --io-stats[=<файл>]   Вывести статистику ввода-вывода в формате JSON (в файл или в конце вывода):" << std::endl;
+	std::cout << "                          количество вызовов и байт, локальность смещений, гистограмма времени операций." << std::endl;
+	std::cout << "    --threads=<N>         Количество потоков разбора IndexArea, не больше 1024 (по умолчанию - по количеству ядер процессора)." << std::endl;
+	std::cout << "    --index-cache[=<файл>] Сохранить результаты разбора в файл индекса (по умолчанию <путь_к_образу_WFS>.wfsidx)" << std::endl;
+	std::cout << "                          и загружать их при следующих запусках. Файл не используется, если изменились" << std::endl;
+	std::cout << "                          заголовок, SuperBlock, размер или время изменения образа." << std::endl;
+	std::cout << "    --watch[=<секунды>]   После разбора опрашивать SuperBlock с указанным интервалом (по умолчанию 5 секунд)" << std::endl;
+	std::cout << "                          и обновлять результаты по записанным с прошлого опроса дескрипторам." << std::endl;
+	std::cout << "                          Для диска работающего регистратора; завершение - Ctrl+C, после него выводится статистика." << std::endl;
+	std::cout << "    --anomalies=<файл>    Сохранить отчёт о нарушениях в IndexArea и цепочках в формате JSON." << std::endl;
+	std::cout << "    --anomaly-samples=<N> Количество примеров каждого вида нарушений в отчёте, не больше 4096 (по умолчанию 16)." << std::endl;
+	std::cout << "    --bench               Измерить скорость последовательного чтения образа выбранным способом." << std::endl;
+	std::cout << "    --export=<номер>      Сохранить цепочку видеофрагментов с указанным номером MainDesc в файл --out." << std::endl;
+	std::cout << "                          Выводится способ выгрузки (copy_file_range, splice, mixed/..., mmap, async/..., readv)." << std::endl;
+	std::cout << "                          Цепочка с MainDesc строится без разбора всей IndexArea." << std::endl;
+	std::cout << "    --export-run=<номер>  Сохранить в файл --out последовательность SecDesc, восстановленную по ссылкам" << std::endl;
+	std::cout << "                          prev/next (нумерация с 0 в порядке вывода количества последовательностей)." << std::endl;
 	std::cout << std::endl;
 	std::cout << "Примеры:" << std::endl;
 	std::cout << "    wfs_console D:\\images\\wfs.dd" << std::endl;
+	std::cout << "    wfs_console info /dev/sdb" << std::endl;
 	std::cout << "    wfs_console /Volumes/DVR/wfs.dd" << std::endl;
+	std::cout << "    wfs_console /dev/sdb" << std::endl;
+	std::cout << "    wfs_console --backend=mmap /srv/images/wfs.dd" << std::endl;
+	std::cout << "    wfs_console --backend=direct --bench /dev/sdb" << std::endl;
+	std::cout << "    wfs_console --cache /dev/sdb" << std::endl;
+	std::cout << "    wfs_console --io-stats=/tmp/io_sdb.json /dev/sdb" << std::endl;
+	std::cout << "    wfs_console --threads=16 /dev/sdb" << std::endl;
+	std::cout << "    wfs_console --index-cache /srv/images/wfs.dd" << std::endl;
+	std::cout << "    wfs_console --watch=10 /dev/sdb" << std::endl;
+	std::cout << "    wfs_console --anomalies=/tmp/anomalies_sdb.json --anomaly-samples=64 /dev/sdb" << std::endl;
+	std::cout << "    wfs_console /srv/images/wfs.dd.001" << std::endl;
+#if defined(WFS_WITH_ZSTD)
+	std::cout << "    wfs_console --export=1234 --out=/tmp/chain_1234.dav /srv/archive/wfs.dd.zst" << std::endl;
+#endif
+	std::cout << "    wfs_console --export=1234 --out=/tmp/chain_1234.dav /srv/images/wfs.dd" << std::endl;
 	std::cout << std::endl;
 	std::cout << "Дополнительно:" << std::endl;
 	std::cout << "    Программа кросс-платформенная и работает на Windows, Linux и macOS," << std::endl;
@@ -30,30 +107,439 @@ void PrintHelp() {
 	std::cout << std::endl;
 }
 
+/**
+* \brief
+* Разбирает числовой параметр командной строки вида <ключ>=<число>: только десятичные цифры
+* (без знака и лишних символов), значение в диапазоне [inUi32Min, inUi32Max]. При ошибке
+* выводит сообщение с допустимым диапазоном.
+*
+* \param
+* const std::string& inStringArg - Параметр целиком.
+*
+* const std::string& inStringKey - Ключ параметра вместе со знаком '='.
+*
+* uint32_t inUi32Min, inUi32Max - Допустимый диапазон значения.
+*
+* uint32_t& outUi32Value - Разобранное значение.
+*
+* \return
+* true, если значение допустимо.
+**/
+bool ParseNumberArg(const std::string& inStringArg, const std::string& inStringKey, uint32_t inUi32Min, uint32_t inUi32Max, uint32_t& outUi32Value) {
+	std::string stringValue = inStringArg.substr(inStringKey.size());
+	bool bIsValid = !stringValue.empty() && stringValue.size() <= 10 && std::all_of(stringValue.begin(), stringValue.end(), [](char inChar) { return inChar >= '0' && inChar <= '9'; });
+	uint64_t ui64Value = bIsValid ? std::stoull(stringValue) : 0;
+	if (!bIsValid || ui64Value < inUi32Min || ui64Value > inUi32Max) {
+		std::cout << "Недопустимое значение параметра " << inStringKey << "\"" << stringValue << "\": ожидается целое число от "
+			<< inUi32Min << " до " << inUi32Max << "." << std::endl;
+		return false;
+	}
+	outUi32Value = static_cast<uint32_t>(ui64Value);
+	return true;
+}
+
+/**
+* \brief
+* Создаёт реализацию IFile по имени способа чтения.
+*
+* \param
+* const std::string& inStringBackend - Имя способа чтения ("native", "mmap" или "direct").
+*
+* \return
+* std::unique_ptr<IFile> - Объект для чтения образа, nullptr если способ не поддерживается.
+**/
+std::unique_ptr<IFile> CreateImageFile(const std::string& inStringBackend) {
+	if (inStringBackend == "native") {
+#if defined(__MACH__) && defined(__APPLE__)
+		return std::make_unique<macFile>();
+#elif defined(_WIN32)
+		return std::make_unique<WinFile>();
+#elif defined(__linux__)
+		return std::make_unique<PosixFile>();
+#endif
+	}
+#if defined(__linux__) || defined(__APPLE__)
+	if (inStringBackend == "mmap") {
+		return std::make_unique<MmapFile>();
+	}
+#endif
+#if defined(__linux__)
+	if (inStringBackend == "direct") {
+		return std::make_unique<DirectFile>();
+	}
+#endif
+	return nullptr;
+}
+
+/**
+* \brief
+* Измеряет скорость последовательного чтения всего образа через readAt участками по 8 МБ.
+* Перед измерением страницы образа вытесняются из кэша (если способ чтения это поддерживает),
+* чтобы буферизованное чтение сравнивалось с небуферизованным в равных условиях.
+*
+* \param
+* IFile& inFile - Открытый образ.
+**/
+void RunBenchmark(IFile& inFile) {
+	const uint64_t ui64ChunkSize = 0x800000;
+	std::unique_ptr<uint8_t[]> pUi8Buffer(new uint8_t[ui64ChunkSize]);
+
+	inFile.advise(0, 0, FileAccessHint::DontNeed);
+
+	uint64_t ui64TotalRead = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (true) {
+		uint64_t ui64BytesRead = 0;
+		if (!inFile.readAt(ui64TotalRead, pUi8Buffer.get(), ui64ChunkSize, ui64BytesRead)) {
+			std::cout << "Ошибка чтения по смещению " << ui64TotalRead << std::endl;
+			return;
+		}
+		ui64TotalRead += ui64BytesRead;
+		if (ui64BytesRead < ui64ChunkSize) {
+			break;
+		}
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	double dMegabytes = static_cast<double>(ui64TotalRead) / (1024.0 * 1024.0);
+	std::cout << "Прочитано: " << std::fixed << std::setprecision(1) << dMegabytes << " МБ за " << std::setprecision(3) << elapsed.count() << " с" << std::endl;
+	if (elapsed.count() > 0) {
+		std::cout << "Скорость чтения: " << std::setprecision(1) << dMegabytes / elapsed.count() << " МБ/с" << std::endl;
+	}
+}
+
+/**
+* \brief
+* Сохраняет цепочку видеофрагментов и выводит способ и время выгрузки.
+**/
+void SaveChain(FileSystem_WFS& inWFS, const FragmentChain& inFragmentChain, const std::string& inStringOutPath) {
+	auto start = std::chrono::steady_clock::now();
+	inWFS.saveVideoChain(inFragmentChain, inStringOutPath);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Сохранен файл: " << inStringOutPath << std::endl;
+	std::cout << "Способ выгрузки: " << inWFS.getLastExportStrategy() << std::endl;
+	std::cout << "Время выгрузки: " << std::fixed << std::setprecision(3) << elapsed.count() << " с" << std::endl;
+}
+
+/**
+* \brief
+* Сохраняет цепочку видеофрагментов с указанным номером MainDesc и выводит способ выгрузки.
+* Цепочка с MainDesc строится выборочно, IndexArea разбирается целиком только для цепочек без MainDesc.
+*
+* \param
+* FileSystem_WFS& inWFS - Открытая файловая система.
+*
+* uint32_t inUi32Index - Номер MainDesc цепочки.
+*
+* const std::string& inStringOutPath - Путь к файлу назначения.
+**/
+void ExportChain(FileSystem_WFS& inWFS, uint32_t inUi32Index, const std::string& inStringOutPath) {
+	FragmentChain* pFragmentChain = inWFS.findChain(inUi32Index);
+	if (pFragmentChain == nullptr) {
+		std::cout << "Цепочка " << inUi32Index << " не найдена" << std::endl;
+		return;
+	}
+
+	SaveChain(inWFS, *pFragmentChain, inStringOutPath);
+}
+
+/**
+* \brief
+* Сохраняет последовательность SecDesc, восстановленную по ссылкам prev/next, и выводит способ выгрузки.
+*
+* \param
+* FileSystem_WFS& inWFS - Открытая файловая система.
+*
+* uint32_t inUi32Index - Номер последовательности.
+*
+* const std::string& inStringOutPath - Путь к файлу назначения.
+**/
+void ExportLinkedRun(FileSystem_WFS& inWFS, uint32_t inUi32Index, const std::string& inStringOutPath) {
+	std::vector<FragmentChain>& vecLinkedRuns = inWFS.getLinkedRuns();
+	if (inUi32Index >= vecLinkedRuns.size()) {
+		std::cout << "Последовательность " << inUi32Index << " не найдена" << std::endl;
+		return;
+	}
+	SaveChain(inWFS, vecLinkedRuns[inUi32Index], inStringOutPath);
+}
+
+/**
+* \brief
+* Опрашивает SuperBlock с интервалом inUi32Seconds и обновляет результаты разбора (--watch)
+* до получения SIGINT (Ctrl+C) или SIGTERM. Интервал отсчитывается шагами по 100 мс,
+* чтобы после сигнала опрос завершался без ожидания конца интервала.
+*
+* \param
+* FileSystem_WFS& inWFS - Разобранный образ.
+*
+* uint32_t inUi32Seconds - Интервал опроса в секундах.
+**/
+void WatchImage(FileSystem_WFS& inWFS, uint32_t inUi32Seconds) {
+	g_iStopWatch = 0;
+	std::signal(SIGINT, StopWatchHandler);
+	std::signal(SIGTERM, StopWatchHandler);
+	const std::chrono::milliseconds stepSleep(100);
+	while (g_iStopWatch == 0) {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(inUi32Seconds);
+		while (g_iStopWatch == 0 && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(stepSleep);
+		}
+		if (g_iStopWatch == 0) {
+			inWFS.refresh();
+		}
+	}
+	std::signal(SIGINT, SIG_DFL);
+	std::signal(SIGTERM, SIG_DFL);
+	std::cout << "Опрос SuperBlock завершён" << std::endl;
+}
+
+/**
+* \brief
+* Выводит статистику кэша блоков (--cache).
+*
+* \param
+* const CacheStats& inStats - Счётчики CachedFile.
+**/
+void PrintCacheStats(const CacheStats& inStats) {
+	uint64_t ui64Total = inStats.ui64Hits + inStats.ui64Misses;
+	double dHitRate = (ui64Total == 0) ? 0.0 : 100.0 * static_cast<double>(inStats.ui64Hits) / static_cast<double>(ui64Total);
+	std::cout << "Кэш блоков: попаданий " << inStats.ui64Hits << ", промахов " << inStats.ui64Misses
+		<< " (" << std::fixed << std::setprecision(1) << dHitRate << "% попаданий)" << std::endl;
+	std::cout << "Кэш блоков: упреждающе прочитано блоков " << inStats.ui64ReadAheadBlocks << ", вытеснено " << inStats.ui64Evictions
+		<< ", чтений в обход кэша " << inStats.ui64BypassReads << std::endl;
+}
+
+/**
+* \brief
+* Выводит статистику ввода-вывода (--io-stats) в формате JSON.
+*
+* \param
+* const IoStats& inStats - Счётчики InstrumentedFile.
+*
+* const std::string& inStringPath - Файл для записи; если пуст, статистика выводится в консоль.
+**/
+void WriteIoStats(const IoStats& inStats, const std::string& inStringPath) {
+	if (inStringPath.empty()) {
+		std::cout << inStats.toJson();
+		return;
+	}
+
+	std::ofstream streamOut(inStringPath, std::ios::out | std::ios::trunc);
+	streamOut << inStats.toJson();
+	if (!streamOut) {
+		std::cout << "Не удалось записать статистику ввода-вывода: " << inStringPath << std::endl;
+	}
+}
+
+/**
+* \brief
+* Сохраняет отчёт о нарушениях разбора (--anomalies) в формате JSON.
+*
+* \param
+* const FileSystem_WFS& inWFS - Разобранный образ.
+*
+* const std::string& inStringPath - Файл для записи.
+**/
+void WriteAnomalies(const FileSystem_WFS& inWFS, const std::string& inStringPath) {
+	std::ofstream streamOut(inStringPath, std::ios::out | std::ios::trunc);
+	streamOut << inWFS.getAnomaliesJson();
+	if (!streamOut) {
+		std::cout << "Не удалось записать отчёт о нарушениях: " << inStringPath << std::endl;
+	}
+}
+
 int main(int argc, char** argv) {
 	setlocale(LC_ALL, "ru_RU.UTF-8");
 	std::string stringPath;
+	std::string stringBackend = "native";
+	bool bBench = false;
+	bool bInfo = false;
+	bool bCache = false;
+	bool bIoStats = false;
+	std::string stringIoStatsPath;
+	uint32_t ui32Threads = 0;
+	bool bIndexCache = false;
+	std::string stringIndexCachePath;
+	uint32_t ui32WatchSeconds = 0;
+	std::string stringAnomaliesPath;
+	uint32_t ui32AnomalySamples = AnomalySink::kUi32DefaultSampleLimit;
+	bool bExport = false;
+	uint32_t ui32Export = 0;
+	bool bExportRun = false;
+	uint32_t ui32ExportRun = 0;
+	std::string stringOutPath;
 
 	if (argc < 2) {
 		PrintHelp();
 		return 0;
 	}
-	if (argc == 2) {
-		stringPath = argv[1];
+	for (int iArg = 1; iArg < argc; iArg++) {
+		std::string stringArg = argv[iArg];
+		if (iArg == 1 && stringArg == "info") {
+			bInfo = true;
+		}
+		else if (stringArg.rfind("--backend=", 0) == 0) {
+			stringBackend = stringArg.substr(std::string("--backend=").size());
+		}
+		else if (stringArg == "--cache") {
+			bCache = true;
+		}
+		else if (stringArg == "--io-stats") {
+			bIoStats = true;
+		}
+		else if (stringArg.rfind("--io-stats=", 0) == 0) {
+			bIoStats = true;
+			stringIoStatsPath = stringArg.substr(std::string("--io-stats=").size());
+		}
+		else if (stringArg.rfind("--threads=", 0) == 0) {
+			if (!ParseNumberArg(stringArg, "--threads=", 0, kUi32MaxThreads, ui32Threads)) {
+				PrintHelp();
+				return 0;
+			}
+		}
+		else if (stringArg == "--index-cache") {
+			bIndexCache = true;
+		}
+		else if (stringArg.rfind("--index-cache=", 0) == 0) {
+			bIndexCache = true;
+			stringIndexCachePath = stringArg.substr(std::string("--index-cache=").size());
+		}
+		else if (stringArg == "--watch") {
+			ui32WatchSeconds = 5;
+		}
+		else if (stringArg.rfind("--watch=", 0) == 0) {
+			if (!ParseNumberArg(stringArg, "--watch=", 1, kUi32MaxWatchSeconds, ui32WatchSeconds)) {
+				PrintHelp();
+				return 0;
+			}
+		}
+		else if (stringArg.rfind("--anomalies=", 0) == 0) {
+			stringAnomaliesPath = stringArg.substr(std::string("--anomalies=").size());
+		}
+		else if (stringArg.rfind("--anomaly-samples=", 0) == 0) {
+			if (!ParseNumberArg(stringArg, "--anomaly-samples=", 0, AnomalySink::kUi32MaxSampleLimit, ui32AnomalySamples)) {
+				PrintHelp();
+				return 0;
+			}
+		}
+		else if (stringArg == "--bench") {
+			bBench = true;
+		}
+		else if (stringArg.rfind("--export=", 0) == 0) {
+			bExport = ParseNumberArg(stringArg, "--export=", 0, 0xFFFFFFFF, ui32Export);
+			if (!bExport) {
+				PrintHelp();
+				return 0;
+			}
+		}
+		else if (stringArg.rfind("--export-run=", 0) == 0) {
+			bExportRun = ParseNumberArg(stringArg, "--export-run=", 0, 0xFFFFFFFF, ui32ExportRun);
+			if (!bExportRun) {
+				PrintHelp();
+				return 0;
+			}
+		}
+		else if (stringArg.rfind("--out=", 0) == 0) {
+			stringOutPath = stringArg.substr(std::string("--out=").size());
+		}
+		else if (stringPath.empty()) {
+			stringPath = stringArg;
+		}
+		else {
+			PrintHelp();
+			return 0;
+		}
 	}
 
-#if defined(__MACH__) && defined(__APPLE__)
-	std::unique_ptr<IFile> file = std::make_unique<macFile>();
-#elif defined(_WIN32)
-	std::unique_ptr<IFile> file = std::make_unique<WinFile>();
+	if ((bExport || bExportRun) && stringOutPath.empty()) {
+		std::cout << "Для --export и --export-run необходимо указать файл назначения --out" << std::endl;
+		return 0;
+	}
+
+	std::unique_ptr<IFile> file = CreateImageFile(stringBackend);
+	if (!file) {
+		std::cout << "Неподдерживаемый способ чтения: " << stringBackend << std::endl;
+		return 0;
+	}
+	SegmentedFile* pSegmentedFile = nullptr;
+#if defined(WFS_WITH_ZSTD)
+	ZstdSeekableFile* pZstdFile = nullptr;
+	if (ZstdSeekableFile::isCompressedPath(stringPath)) {
+		std::unique_ptr<ZstdSeekableFile> zstdFile = std::make_unique<ZstdSeekableFile>(std::move(file));
+		pZstdFile = zstdFile.get();
+		file = std::move(zstdFile);
+	}
+	else
 #endif
+	if (SegmentedFile::isSegmentPath(stringPath)) {
+		std::unique_ptr<SegmentedFile> segmentedFile = std::make_unique<SegmentedFile>([stringBackend]() { return CreateImageFile(stringBackend); });
+		pSegmentedFile = segmentedFile.get();
+		file = std::move(segmentedFile);
+	}
+	// Статистика собирается между источником данных и кэшем, то есть учитываются только обращения к носителю
+	InstrumentedFile* pInstrumentedFile = nullptr;
+	if (bIoStats) {
+		std::unique_ptr<InstrumentedFile> instrumentedFile = std::make_unique<InstrumentedFile>(std::move(file));
+		pInstrumentedFile = instrumentedFile.get();
+		file = std::move(instrumentedFile);
+	}
+	CachedFile* pCachedFile = nullptr;
+	if (bCache) {
+		std::unique_ptr<CachedFile> cachedFile = std::make_unique<CachedFile>(std::move(file));
+		pCachedFile = cachedFile.get();
+		file = std::move(cachedFile);
+	}
 
 	try {
 		if (!file->open(stringPath)) {
 			std::cout << "Ошибка чтения файла: " << stringPath << std::endl;
 			return 0;
 		}
-		std::unique_ptr<FileSystem_WFS> someWFS = std::make_unique<FileSystem_WFS>(std::move(file));
+#if defined(WFS_WITH_ZSTD)
+		if (pZstdFile != nullptr) {
+			std::cout << "Сжатый образ zstd: кадров " << pZstdFile->getFrameCount() << ", размер после распаковки " << pZstdFile->getSize() << " байт" << std::endl;
+		}
+#endif
+		if (pSegmentedFile != nullptr && pSegmentedFile->getSegmentCount() > 1) {
+			std::cout << "Образ разбит на части: " << pSegmentedFile->getSegmentCount() << ", общий размер " << pSegmentedFile->getSize() << " байт" << std::endl;
+		}
+		if (bBench) {
+			RunBenchmark(*file);
+			if (pInstrumentedFile != nullptr) {
+				WriteIoStats(pInstrumentedFile->getStats(), stringIoStatsPath);
+			}
+			return 1;
+		}
+		std::unique_ptr<FileSystem_WFS> someWFS = std::make_unique<FileSystem_WFS>(std::move(file), ui32Threads);
+		if (bIndexCache) {
+			someWFS->setIndexCachePath(stringIndexCachePath.empty() ? stringPath + ".wfsidx" : stringIndexCachePath);
+		}
+		someWFS->setAnomalySampleLimit(ui32AnomalySamples);
+		if (bInfo) {
+			someWFS->printWFSInf();
+		}
+		else if (bExport) {
+			ExportChain(*someWFS, ui32Export, stringOutPath);
+		}
+		else if (bExportRun) {
+			ExportLinkedRun(*someWFS, ui32ExportRun, stringOutPath);
+		}
+		else {
+			someWFS->analyze();
+			if (!stringAnomaliesPath.empty()) {
+				WriteAnomalies(*someWFS, stringAnomaliesPath);
+			}
+			if (ui32WatchSeconds != 0) {
+				WatchImage(*someWFS, ui32WatchSeconds);
+			}
+		}
+		if (pCachedFile != nullptr) {
+			PrintCacheStats(pCachedFile->getStats());
+		}
+		if (pInstrumentedFile != nullptr) {
+			WriteIoStats(pInstrumentedFile->getStats(), stringIoStatsPath);
+		}
 	}
 	catch (const std::runtime_error& e) {
 		std::cout << "Ошибка: " << e.what() << std::endl;
@@ -12,8 +12,8 @@ bool MyTreeWidgetItem::operator<(const QTreeWidgetItem& other) const {
 		// Столбцы с Index и ui8CameraNumber — сортируем как число
 		case 1: // Дата начала
 		case 2: // Дата конца
-			//return QDateTime::fromString(thisText, "dd.MM.yyyy HH:mm:ss") < QDateTime::fromString(otherText, "dd.MM.yyyy HH:mm:ss");
-			return data(column, Qt::UserRole).toDateTime() < other.data(column, Qt::UserRole).toDateTime();
+			// Упакованные метки WFS сравниваются как числа
+			return data(column, Qt::UserRole).toUInt() < other.data(column, Qt::UserRole).toUInt();
 
 		default: // Остальные — строковая сортировка
 			return text(column) < other.text(column);
@@ -41,6 +41,13 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
 	connect(ui->btnResetFilter, &QPushButton::clicked, this, &MainWindow::resetFilter);
 
 	connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::openAboutWindow);
+
+	// Статистика ввода-вывода открытого образа обновляется в строке состояния раз в секунду
+	labelIoStats = new QLabel(this);
+	ui->statusBar->addPermanentWidget(labelIoStats);
+	timerIoStats = new QTimer(this);
+	connect(timerIoStats, &QTimer::timeout, this, &MainWindow::updateIoStats);
+	timerIoStats->start(1000);
 }
 
 MainWindow::~MainWindow() {
@@ -55,9 +62,11 @@ void MainWindow::onOpenFile() {
 		QMessageBox::critical(this, "Ошибка", "Файл не задан.");
 		return;
 	}
+	pIoStatsFile = nullptr;
 	someWFS.reset();
 
-	file = createPlatformFile();
+	// Статистика ввода-вывода собирается, только если включена до открытия образа
+	file = createPlatformFile(ui->actionIoStats->isChecked() ? &pIoStatsFile : nullptr);
 
 	std::string fileStr = fileName.toUtf8().constData();
 
@@ -67,11 +76,19 @@ void MainWindow::onOpenFile() {
 	}
 
 	someWFS = std::make_unique<FileSystem_WFS>(std::move(file));
+	/*
+	* Дерево содержит все цепочки, поэтому IndexArea разбирается сразу после открытия.
+	* Результаты разбора сохраняются в файл индекса рядом с образом, и при повторном
+	* открытии неизменённого образа загружаются из него без разбора
+	*/
+	someWFS->setIndexCachePath(fileStr + ".wfsidx");
+	someWFS->analyze();
 	ui->statusBar->showMessage("Файл открыт: " + fileName, 6000);
+	updateIoStats();
 
 	ui->treeWidget->setSortingEnabled(false);
 	uint16_t ui16CameraCount = 0;
-	for (auto iterFragChain = someWFS->mapValidChains.begin(); iterFragChain != someWFS->mapValidChains.end(); ++iterFragChain) {
+	for (auto iterFragChain = someWFS->getValidChains().begin(); iterFragChain != someWFS->getValidChains().end(); ++iterFragChain) {
 		uint32_t ui32IndexCurrentMainDesc = iterFragChain->first;
 		FragmentChain& videoChainCurMainDesc = iterFragChain->second;
 		uint16_t ui16CountSecDesc = videoChainCurMainDesc.pMainDes->ui16CountSecDesc;
@@ -86,11 +103,11 @@ void MainWindow::onOpenFile() {
 		item->setText(0, QString::number(ui32IndexCurrentMainDesc));
 		item->setData(0, Qt::UserRole, ui32IndexCurrentMainDesc);
 
-		item->setText(1, formatTimestamp(videoChainCurMainDesc.pMainDes->stTimeStampStartVideoStream));
-		item->setData(1, Qt::UserRole, toQDateTime(videoChainCurMainDesc.pMainDes->stTimeStampStartVideoStream));
+		item->setText(1, formatTimestamp(videoChainCurMainDesc.pMainDes->ui32TimeStampStartVideoStream));
+		item->setData(1, Qt::UserRole, static_cast<uint>(videoChainCurMainDesc.pMainDes->ui32TimeStampStartVideoStream));
 
-		item->setText(2, formatTimestamp(videoChainCurMainDesc.pMainDes->stTimeStampEndVideoStream));
-		item->setData(2, Qt::UserRole, toQDateTime(videoChainCurMainDesc.pMainDes->stTimeStampEndVideoStream));
+		item->setText(2, formatTimestamp(videoChainCurMainDesc.pMainDes->ui32TimeStampEndVideoStream));
+		item->setData(2, Qt::UserRole, static_cast<uint>(videoChainCurMainDesc.pMainDes->ui32TimeStampEndVideoStream));
 
 		item->setText(3, QString::number(videoChainCurMainDesc.pMainDes->ui8CameraNumber));
 		item->setData(3, Qt::UserRole, videoChainCurMainDesc.pMainDes->ui8CameraNumber);
@@ -98,44 +115,18 @@ void MainWindow::onOpenFile() {
 		item->setText(4, "+");
 		item->setData(4, Qt::UserRole, QVariant::fromValue(reinterpret_cast<void*>(&(iterFragChain->second))));
 
-		for (uint16_t ui16Iter = 0; ui16Iter < ui16CountSecDesc; ui16Iter++) {
-			MyTreeWidgetItem* child = new MyTreeWidgetItem();
-			auto iterSecDesc = videoChainCurMainDesc.pSecDes.find(ui16Iter);
-			if (iterSecDesc != videoChainCurMainDesc.pSecDes.end()) {
-				/*
-				* Дочерние элементы можно инициализировать при раскрытии выпадающего списка
-				* Если инициализировать их в данном месте, то будет
-				* Если этого не делать, то только при инициализации MainDesc = 384 Мб
-				* MainDesc + SecDesc = 624 Мб
-				* Экономия = 240 Мб
-				* video.mkv
-				*/
-
-				/*
-				child->setText(0, QString::number(iterSecDesc->first));
-				child->setText(1, formatTimestamp(iterSecDesc->second->stTimeStampStartVideoSegment));
-				child->setText(2, formatTimestamp(iterSecDesc->second->stTimeStampEndVideoSegment));
-				child->setText(3, QString::number(iterSecDesc->second->ui8CameraNumber));
-				*/
-			}
-			else {
-				//std::cout << "\t[" << ui16Iter << "] - X" << std::endl;
-				child->setText(0, QString::number(ui16Iter));
-				child->setData(0, Qt::UserRole, ui16Iter);
-
-				child->setText(1, "-");
-				child->setText(2, "-");
-				child->setText(3, "-");
-			}
-			item->addChild(child);
-		}
+		/*
+		* Дочерние элементы (SecDesc) создаются при первом раскрытии цепочки (onItemExpanded),
+		* поэтому при открытии образа в дереве находятся только элементы цепочек
+		*/
+		item->setChildIndicatorPolicy(ui16CountSecDesc > 0 ? QTreeWidgetItem::ShowIndicator : QTreeWidgetItem::DontShowIndicator);
 		ui->treeWidget->addTopLevelItem(item);
 	}
 
 	/*
 	* Добавление в QTreeWidget восстановленных цепочек
 	*/
-	for (auto iterFragChain = someWFS->mapIncompleteChains.begin(); iterFragChain != someWFS->mapIncompleteChains.end(); ++iterFragChain) {
+	for (auto iterFragChain = someWFS->getIncompleteChains().begin(); iterFragChain != someWFS->getIncompleteChains().end(); ++iterFragChain) {
 		uint32_t ui32IndexCurrentMainDesc = iterFragChain->first;
 		FragmentChain& videoChainCurMainDesc = iterFragChain->second;
 
@@ -145,11 +136,11 @@ void MainWindow::onOpenFile() {
 		item->setText(0, QString::number(ui32IndexCurrentMainDesc));
 		item->setData(0, Qt::UserRole, ui32IndexCurrentMainDesc);
 
-		item->setText(1, formatTimestamp(videoChainCurMainDesc.pMainDes->stTimeStampStartVideoStream));
-		item->setData(1, Qt::UserRole, toQDateTime(videoChainCurMainDesc.pMainDes->stTimeStampStartVideoStream));
+		item->setText(1, formatTimestamp(videoChainCurMainDesc.pMainDes->ui32TimeStampStartVideoStream));
+		item->setData(1, Qt::UserRole, static_cast<uint>(videoChainCurMainDesc.pMainDes->ui32TimeStampStartVideoStream));
 
-		item->setText(2, formatTimestamp(videoChainCurMainDesc.pMainDes->stTimeStampEndVideoStream));
-		item->setData(2, Qt::UserRole, toQDateTime(videoChainCurMainDesc.pMainDes->stTimeStampEndVideoStream));
+		item->setText(2, formatTimestamp(videoChainCurMainDesc.pMainDes->ui32TimeStampEndVideoStream));
+		item->setData(2, Qt::UserRole, static_cast<uint>(videoChainCurMainDesc.pMainDes->ui32TimeStampEndVideoStream));
 
 		item->setText(3, QString::number(videoChainCurMainDesc.pMainDes->ui8CameraNumber));
 		item->setData(3, Qt::UserRole, videoChainCurMainDesc.pMainDes->ui8CameraNumber);
@@ -161,22 +152,7 @@ void MainWindow::onOpenFile() {
 			item->setBackground(i, QBrush(QColor("#f2ca16")));
 		}
 
-		for (uint16_t ui16Iter = 0; ui16Iter < ui16CountSecDesc; ui16Iter++) {
-			MyTreeWidgetItem* child = new MyTreeWidgetItem();
-			auto iterSecDesc = videoChainCurMainDesc.pSecDes.find(ui16Iter);
-			if (iterSecDesc != videoChainCurMainDesc.pSecDes.end()) {
-
-			}
-			else {
-				child->setText(0, QString::number(ui16Iter));
-				child->setData(0, Qt::UserRole, ui16Iter);
-
-				child->setText(1, "-");
-				child->setText(2, "-");
-				child->setText(3, "-");
-			}
-			item->addChild(child);
-		}
+		item->setChildIndicatorPolicy(ui16CountSecDesc > 0 ? QTreeWidgetItem::ShowIndicator : QTreeWidgetItem::DontShowIndicator);
 
 		ui->treeWidget->addTopLevelItem(item);
 	}
@@ -248,7 +224,7 @@ void MainWindow::onTreeWidgetContextMenu(const QPoint& pos) {
 			if (!qSFileName.isEmpty()) {
 				std::string strFileName = qSFileName.toUtf8().constData();
 				someWFS->saveVideoChain(*pFragmentChain, strFileName);
-				QMessageBox::information(this, "Информация", "Сохранен файл: " + qSFileName);
+				QMessageBox::information(this, "Информация", "Сохранен файл: " + qSFileName + "\nСпособ выгрузки: " + QString::fromStdString(someWFS->getLastExportStrategy()));
 			}
 		}
 		else {
@@ -262,7 +238,7 @@ void MainWindow::onTreeWidgetContextMenu(const QPoint& pos) {
 			if (!qSFileName.isEmpty()) {
 				std::string strFileName = qSFileName.toUtf8().constData();
 				someWFS->saveSecFragmentVideo(*pSecDesc, strFileName);
-				QMessageBox::information(this, "Информация", "Сохранен файл: " + qSFileName);	
+				QMessageBox::information(this, "Информация", "Сохранен файл: " + qSFileName + "\nСпособ выгрузки: " + QString::fromStdString(someWFS->getLastExportStrategy()));
 			}
 		}
 	}
@@ -272,39 +248,47 @@ void MainWindow::onItemExpanded(QTreeWidgetItem* item) {
 	ui->treeWidget->setSortingEnabled(false);
 	uint32_t ui32Index = item->text(0).toUInt();
 	QColor bgColor = item->background(0).color();
+
+	// Дочерние элементы (SecDesc) создаются при первом раскрытии цепочки
+	if (!item->parent() && item->childCount() == 0) {
+		FragmentChain* pFragmentChain = reinterpret_cast<FragmentChain*>(item->data(4, Qt::UserRole).value<void*>());
+		for (uint16_t ui16Iter = 0; ui16Iter < pFragmentChain->pMainDes->ui16CountSecDesc; ui16Iter++) {
+			item->addChild(new MyTreeWidgetItem());
+		}
+	}
 	int iCount = item->childCount();
 
 	if (bgColor == QColor("#f2ca16")) {
-		auto fragmentChain = someWFS->mapIncompleteChains.find(ui32Index);
+		auto fragmentChain = someWFS->getIncompleteChains().find(ui32Index);
 
-		if (fragmentChain != someWFS->mapIncompleteChains.end()) {
+		if (fragmentChain != someWFS->getIncompleteChains().end()) {
 			uint16_t ui16CountSecDesc = fragmentChain->second.pMainDes->ui16CountSecDesc;
 
 			for (int intIter = 0; intIter < iCount; ++intIter) {
 				uint16_t ui16Iter = static_cast<uint16_t>(intIter);
-				auto iterSecDesc = fragmentChain->second.pSecDes.find(ui16Iter);
+				WFSSecDescAdvInfo* pSecDesc = someWFS->getSecDesc(fragmentChain->second.getSecSlot(ui16Iter));
 				MyTreeWidgetItem* child = dynamic_cast<MyTreeWidgetItem*>(item->child(intIter));
 				//MyTreeWidgetItem* child = item->child(intIter);
-				if (iterSecDesc != fragmentChain->second.pSecDes.end()) {
-					if (iterSecDesc->second->bIsRecovered) {
+				if (pSecDesc != nullptr) {
+					if (pSecDesc->bIsRecovered) {
 						for (int i = 0; i < ui->treeWidget->columnCount(); ++i) {
 							child->setBackground(i, QBrush(QColor("#f2ca16")));
 						}
 					}
-					child->setText(0, QString::number(iterSecDesc->first) + " " + QString::number(iterSecDesc->second->ui32IndexCurrentSecDesc));
-					child->setData(0, Qt::UserRole, QString::number(iterSecDesc->first));
+					child->setText(0, QString::number(ui16Iter) + " " + QString::number(pSecDesc->ui32IndexCurrentSecDesc));
+					child->setData(0, Qt::UserRole, QString::number(ui16Iter));
 
-					child->setText(1, formatTimestamp(iterSecDesc->second->stTimeStampStartVideoSegment));
-					child->setData(1, Qt::UserRole, toQDateTime(iterSecDesc->second->stTimeStampStartVideoSegment));
+					child->setText(1, formatTimestamp(pSecDesc->ui32TimeStampStartVideoSegment));
+					child->setData(1, Qt::UserRole, static_cast<uint>(pSecDesc->ui32TimeStampStartVideoSegment));
 
-					child->setText(2, formatTimestamp(iterSecDesc->second->stTimeStampEndVideoSegment));
-					child->setData(2, Qt::UserRole, toQDateTime(iterSecDesc->second->stTimeStampEndVideoSegment));
+					child->setText(2, formatTimestamp(pSecDesc->ui32TimeStampEndVideoSegment));
+					child->setData(2, Qt::UserRole, static_cast<uint>(pSecDesc->ui32TimeStampEndVideoSegment));
 
-					child->setText(3, QString::number(iterSecDesc->second->ui8CameraNumber));
-					child->setData(3, Qt::UserRole, iterSecDesc->second->ui8CameraNumber);
+					child->setText(3, QString::number(pSecDesc->ui8CameraNumber));
+					child->setData(3, Qt::UserRole, pSecDesc->ui8CameraNumber);
 
 					child->setText(4, "+");
-					child->setData(4, Qt::UserRole, QVariant::fromValue(reinterpret_cast<void*>(iterSecDesc->second)));
+					child->setData(4, Qt::UserRole, QVariant::fromValue(reinterpret_cast<void*>(pSecDesc)));
 				}
 				else {
 					child->setText(0, QString::number(ui16Iter));
@@ -319,36 +303,36 @@ void MainWindow::onItemExpanded(QTreeWidgetItem* item) {
 		}
 	}
 	else {
-		auto fragmentChain = someWFS->mapValidChains.find(ui32Index);
+		auto fragmentChain = someWFS->getValidChains().find(ui32Index);
 
-		if (fragmentChain != someWFS->mapValidChains.end()) {
+		if (fragmentChain != someWFS->getValidChains().end()) {
 			uint16_t ui16CountSecDesc = fragmentChain->second.pMainDes->ui16CountSecDesc;
 
 			for (int intIter = 0; intIter < iCount; ++intIter) {
 				uint16_t ui16Iter = static_cast<uint16_t>(intIter);
-				auto iterSecDesc = fragmentChain->second.pSecDes.find(ui16Iter);
+				WFSSecDescAdvInfo* pSecDesc = someWFS->getSecDesc(fragmentChain->second.getSecSlot(ui16Iter));
 				MyTreeWidgetItem* child = dynamic_cast<MyTreeWidgetItem*>(item->child(intIter));
 
 				//MyTreeWidgetItem* child = item->child(intIter);
-				if (iterSecDesc != fragmentChain->second.pSecDes.end()) {
-					if (iterSecDesc->second->bIsRecovered) {
+				if (pSecDesc != nullptr) {
+					if (pSecDesc->bIsRecovered) {
 						for (int i = 0; i < ui->treeWidget->columnCount(); ++i) {
 							child->setBackground(i, QBrush(QColor("#f2ca16")));
 						}
 					}
-					child->setText(0, QString::number(iterSecDesc->first) + " " + QString::number(iterSecDesc->second->ui32IndexCurrentSecDesc));
-					child->setData(0, Qt::UserRole, iterSecDesc->first);
+					child->setText(0, QString::number(ui16Iter) + " " + QString::number(pSecDesc->ui32IndexCurrentSecDesc));
+					child->setData(0, Qt::UserRole, ui16Iter);
 
-					child->setText(1, formatTimestamp(iterSecDesc->second->stTimeStampStartVideoSegment));
-					child->setData(1, Qt::UserRole, toQDateTime(iterSecDesc->second->stTimeStampStartVideoSegment));
+					child->setText(1, formatTimestamp(pSecDesc->ui32TimeStampStartVideoSegment));
+					child->setData(1, Qt::UserRole, static_cast<uint>(pSecDesc->ui32TimeStampStartVideoSegment));
 
-					child->setText(2, formatTimestamp(iterSecDesc->second->stTimeStampEndVideoSegment));
-					child->setData(2, Qt::UserRole, toQDateTime(iterSecDesc->second->stTimeStampEndVideoSegment));
+					child->setText(2, formatTimestamp(pSecDesc->ui32TimeStampEndVideoSegment));
+					child->setData(2, Qt::UserRole, static_cast<uint>(pSecDesc->ui32TimeStampEndVideoSegment));
 
-					child->setText(3, QString::number(iterSecDesc->second->ui8CameraNumber));
+					child->setText(3, QString::number(pSecDesc->ui8CameraNumber));
 
 					child->setText(4, "+");
-					child->setData(4, Qt::UserRole, QVariant::fromValue(reinterpret_cast<void*>(iterSecDesc->second)));
+					child->setData(4, Qt::UserRole, QVariant::fromValue(reinterpret_cast<void*>(pSecDesc)));
 				}
 				else {
 					child->setText(0, QString::number(ui16Iter));
@@ -415,4 +399,12 @@ void MainWindow::openAboutWindow() {
 	AboutWindow* about = new AboutWindow(this);
 	about->show();
 	about->setAttribute(Qt::WA_DeleteOnClose);
-}
\ No newline at end of file
+}
+
+void MainWindow::updateIoStats() {
+	if (pIoStatsFile == nullptr) {
+		labelIoStats->clear();
+		return;
+	}
+	labelIoStats->setText(formatIoStats(pIoStatsFile->getStats()));
+}
@@ -11,6 +11,8 @@
 #include <QShortcut>
 #include <QKeySequence>
 #include <QHeaderView>
+#include <QLabel>
+#include <QTimer>
 
 #include "ui_MainWindow.h"
 #include "core/FileSystem_WFS.h"
@@ -18,6 +20,7 @@
 #include "io/IFile.h"
 #include "io/macFile.h"
 #include "io/WinFile.h"
+#include "io/PosixFile.h"
 #include "../utils.h"
 #include "../MyTreeWidgetItem.h"
 
@@ -37,6 +40,9 @@ private:
 	Ui::MainWindowClass* ui;
 	std::unique_ptr<FileSystem_WFS> someWFS;
 	std::unique_ptr<IFile> file;
+	InstrumentedFile* pIoStatsFile = nullptr;	// Статистика ввода-вывода открытого образа (принадлежит file или someWFS)
+	QLabel* labelIoStats;
+	QTimer* timerIoStats;
 
 private slots:
 	void onOpenFile();
@@ -46,4 +52,5 @@ private slots:
 	void applyFilter();
 	void resetFilter();
 	void openAboutWindow();
+	void updateIoStats();
 };
\ No newline at end of file
@@ -1,23 +1,53 @@
 #include "utils.h"
 
-QString formatTimestamp(const WFSDateTime& t) {
+QString formatTimestamp(uint32_t inUi32Time) {
+	WFSDateTime t = WFSTime::toDateTime(inUi32Time);
 	return QString::asprintf("%02u:%02u:%02u %02u.%02u.%04u",
 		t.ui8Hour, t.ui8Minute, t.ui8Second,
 		t.ui8Day, t.ui8Month, t.ui16Year);
 }
 
-std::unique_ptr<IFile> createPlatformFile() {
+/**
+* \brief
+* Создаёт реализацию IFile для текущей платформы. Образ открывается через SegmentedFile,
+* поэтому можно выбрать первую часть разбитого образа (wfs.dd.001). GUI многократно читает
+* небольшие участки образа (дескрипторы, шестнадцатеричный дамп), поэтому файл
+* оборачивается в кэш блоков CachedFile. Если статистика запрошена, между кэшем и образом
+* находится InstrumentedFile, статистика которого (обращения к носителю) показывается в строке состояния.
+*
+* \param
+* InstrumentedFile** ppOutInstrumented - Если задан, образ оборачивается в InstrumentedFile, указатель
+* на который действителен, пока существует возвращённый файл. Иначе счётчики не используются.
+**/
+std::unique_ptr<IFile> createPlatformFile(InstrumentedFile** ppOutInstrumented) {
+	FileFactory fnFactory = []() -> std::unique_ptr<IFile> {
 #if defined(__MACH__) && defined(__APPLE__)
-	return std::make_unique<macFile>();
+		return std::make_unique<macFile>();
 #elif defined(_WIN32)
-	return std::make_unique<WinFile>();
+		return std::make_unique<WinFile>();
+#elif defined(__linux__)
+		return std::make_unique<PosixFile>();
 #else
-	return nullptr;
+		return nullptr;
 #endif
+	};
+	std::unique_ptr<IFile> imageFile = std::make_unique<SegmentedFile>(fnFactory);
+	if (ppOutInstrumented != nullptr) {
+		std::unique_ptr<InstrumentedFile> instrumentedFile = std::make_unique<InstrumentedFile>(std::move(imageFile));
+		*ppOutInstrumented = instrumentedFile.get();
+		imageFile = std::move(instrumentedFile);
+	}
+	return std::make_unique<CachedFile>(std::move(imageFile));
 }
 
-QDateTime toQDateTime(const WFSDateTime& wfsTime) {
-	QDate date(wfsTime.ui16Year, wfsTime.ui8Month, wfsTime.ui8Day);
-	QTime time(wfsTime.ui8Hour, wfsTime.ui8Minute, wfsTime.ui8Second);
-	return QDateTime(date, time);
+QString formatIoStats(const IoStats& inStats) {
+	uint64_t ui64Reads = inStats.ui64Sequential + inStats.ui64Near + inStats.ui64Random;
+	double dSequential = (ui64Reads == 0) ? 0.0 : 100.0 * static_cast<double>(inStats.ui64Sequential + inStats.ui64Near) / static_cast<double>(ui64Reads);
+	return QString("Чтение: %1 выз., %2 МБ, %3 мс | p50 %4 мкс, p99 %5 мкс | локальных %6%")
+		.arg(inStats.stRead.ui64Calls)
+		.arg(static_cast<double>(inStats.stRead.ui64Bytes) / (1024.0 * 1024.0), 0, 'f', 1)
+		.arg(static_cast<double>(inStats.stRead.ui64TotalNs) / 1e6, 0, 'f', 1)
+		.arg(static_cast<double>(inStats.stRead.percentileNs(50.0)) / 1e3, 0, 'f', 1)
+		.arg(static_cast<double>(inStats.stRead.percentileNs(99.0)) / 1e3, 0, 'f', 1)
+		.arg(dSequential, 0, 'f', 0);
 }
\ No newline at end of file
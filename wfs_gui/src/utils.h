@@ -1,13 +1,17 @@
 #pragma once
 
 #include <QString>
-#include <QDateTime>
 
 #include "core/struct_wfs.h"
+#include "core/WFSTime.h"
 #include "io/IFile.h"
 #include "io/macFile.h"
 #include "io/WinFile.h"
+#include "io/PosixFile.h"
+#include "io/CachedFile.h"
+#include "io/SegmentedFile.h"
+#include "io/InstrumentedFile.h"
 
-QString formatTimestamp(const WFSDateTime& t);
-std::unique_ptr<IFile> createPlatformFile();
-QDateTime toQDateTime(const WFSDateTime& wfsTime);
\ No newline at end of file
+QString formatTimestamp(uint32_t inUi32Time);
+std::unique_ptr<IFile> createPlatformFile(InstrumentedFile** ppOutInstrumented = nullptr);
+QString formatIoStats(const IoStats& inStats);
\ No newline at end of file